@@ -0,0 +1,159 @@
+#include "Benchmark.h"
+
+double TimingStats::getTotalNs() const
+{
+    double total = 0.0;
+
+    for (auto ns : durationsNs)
+        total += ns;
+
+    return total;
+}
+
+double TimingStats::getPercentileNs(double percentile) const
+{
+    if (durationsNs.empty())
+        return 0.0;
+
+    auto sorted = durationsNs;
+    auto index = static_cast<size_t>(juce::jlimit(0.0, 1.0, percentile / 100.0) * static_cast<double>(sorted.size() - 1));
+    std::nth_element(sorted.begin(), sorted.begin() + static_cast<std::ptrdiff_t>(index), sorted.end());
+
+    return sorted[index];
+}
+
+juce::var TimingStats::toVar() const
+{
+    auto* result = new juce::DynamicObject();
+
+    if (durationsNs.empty())
+        return juce::var(result);
+
+    auto minMax = std::minmax_element(durationsNs.begin(), durationsNs.end());
+
+    result->setProperty("calls",   static_cast<int>(durationsNs.size()));
+    result->setProperty("minUs",   *minMax.first / 1000.0);
+    result->setProperty("meanUs",  getTotalNs() / static_cast<double>(durationsNs.size()) / 1000.0);
+    result->setProperty("p50Us",   getPercentileNs(50.0) / 1000.0);
+    result->setProperty("p90Us",   getPercentileNs(90.0) / 1000.0);
+    result->setProperty("p99Us",   getPercentileNs(99.0) / 1000.0);
+    result->setProperty("p999Us",  getPercentileNs(99.9) / 1000.0);
+    result->setProperty("maxUs",   *minMax.second / 1000.0);
+
+    return juce::var(result);
+}
+
+juce::Optional<juce::AudioPlayHead::PositionInfo> BenchmarkPlayHead::getPosition() const
+{
+    PositionInfo info;
+    info.setBpm(bpm);
+    info.setIsPlaying(true);
+
+    return info;
+}
+
+HeadlessProcessor::HeadlessProcessor()
+{
+    processor.setPlayHead(&playHead);
+}
+
+HeadlessProcessor::~HeadlessProcessor()
+{
+    processor.releaseResources();
+    processor.setPlayHead(nullptr);
+}
+
+void HeadlessProcessor::prepare(double sampleRate, int blockSize, juce::AudioProcessor::ProcessingPrecision precision)
+{
+    processor.setPlayConfigDetails(2, 2, sampleRate, blockSize);
+    processor.setProcessingPrecision(precision);
+    processor.prepareToPlay(sampleRate, blockSize);
+}
+
+void HeadlessProcessor::setParameter(const juce::String& parameterID, float value)
+{
+    auto* param = processor.apvts.getParameter(parameterID);
+    jassert(param != nullptr);
+
+    param->setValueNotifyingHost(param->convertTo0to1(value));
+}
+
+juce::String BenchmarkPreset::getName() const
+{
+    juce::StringArray parts;
+
+    if (pitchShift)    parts.add("pitch");
+    if (freqShift)     parts.add("freqshift");
+    if (lfo)           parts.add("lfo");
+    if (filtersClosed) parts.add("filters");
+
+    return parts.isEmpty() ? juce::String("plain") : parts.joinIntoString("+");
+}
+
+void BenchmarkPreset::apply(HeadlessProcessor& headless) const
+{
+    headless.setParameter("Delay Time",         300.f);
+    headless.setParameter("Feedback",           0.5f);
+    headless.setParameter("Dry/Wet Mix",        0.5f);
+
+    headless.setParameter("Pitch Shift",        pitchShift ? 7.f : 0.f);
+    headless.setParameter("Pitch Shift Amount", pitchShift ? 0.5f : 0.f);
+
+    headless.setParameter("Frequency Shift",    freqShift ? 120.f : 0.f);
+    headless.setParameter("Sideband Mix",       freqShift ? 0.25f : 0.f);
+
+    headless.setParameter("LFO Rate",           lfo ? 2.f : 0.f);
+    headless.setParameter("LFO Amount",         lfo ? 20.f : 0.f);
+
+    headless.setParameter("LowPass Freq",       filtersClosed ? 2000.f : 22000.f);
+    headless.setParameter("HighPass Freq",      filtersClosed ? 300.f : 20.f);
+}
+
+juce::Array<BenchmarkPreset> BenchmarkPreset::getAll()
+{
+    juce::Array<BenchmarkPreset> presets;
+
+    for (int mask = 0; mask < 16; ++mask)
+        presets.add({ (mask & 1) != 0, (mask & 2) != 0, (mask & 4) != 0, (mask & 8) != 0 });
+
+    return presets;
+}
+
+juce::var getStageTimings(StrangeEchoesAudioProcessor& processor)
+{
+   #if STRANGE_ECHOES_PROFILING
+    auto snapshot = processor.getProfiler().getSnapshot();
+    auto* result = new juce::DynamicObject();
+
+    for (int i = 0; i < StageProfiler::numStages; ++i)
+    {
+        const auto& stage = snapshot[(size_t) i];
+        auto* stageResult = new juce::DynamicObject();
+
+        stageResult->setProperty("calls",  static_cast<juce::int64>(stage.calls));
+        stageResult->setProperty("minUs",  static_cast<double>(stage.minNs) / 1000.0);
+        stageResult->setProperty("meanUs", stage.getMeanNs() / 1000.0);
+        stageResult->setProperty("p50Us",  stage.getPercentileNs(50.0) / 1000.0);
+        stageResult->setProperty("p99Us",  stage.getPercentileNs(99.0) / 1000.0);
+        stageResult->setProperty("maxUs",  static_cast<double>(stage.maxNs) / 1000.0);
+
+        result->setProperty(StageProfiler::getStageName(static_cast<DspStage>(i)), juce::var(stageResult));
+    }
+
+    return juce::var(result);
+   #else
+    juce::ignoreUnused(processor);
+    return {};
+   #endif
+}
+
+void fillWithNoise(juce::AudioBuffer<float>& buffer, juce::Random& random, float gain)
+{
+    for (int channel = 0; channel < buffer.getNumChannels(); ++channel)
+    {
+        auto* data = buffer.getWritePointer(channel);
+
+        for (int i = 0; i < buffer.getNumSamples(); ++i)
+            data[i] = gain * (2.f * random.nextFloat() - 1.f);
+    }
+}
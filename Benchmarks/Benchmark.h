@@ -0,0 +1,142 @@
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_core/juce_core.h>
+#include <algorithm>
+#include <chrono>
+#include <vector>
+#include "../Source/StrangeEchoesProcessor.h"
+
+struct BenchmarkOptions
+{
+    juce::Array<double> sampleRates { 44100.0, 48000.0, 88200.0, 96000.0, 176400.0, 192000.0 };
+    juce::Array<int> blockSizes { 16, 32, 64, 128, 256, 512, 1024, 2048, 4096 };
+
+    // Seconds of audio rendered per measured configuration (after warm-up)
+    double secondsPerRun { 1.0 };
+    double warmUpSeconds { 0.25 };
+};
+
+// Monotonic nanosecond clock used for all measurements
+struct Stopwatch
+{
+    using Clock = std::chrono::steady_clock;
+
+    void start() { startTime = Clock::now(); }
+
+    double getElapsedNs() const
+    {
+        return static_cast<double>(std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now() - startTime).count());
+    }
+
+    Clock::time_point startTime { Clock::now() };
+};
+
+// Collects per-call timings and turns them into a JSON object
+struct TimingStats
+{
+    void reserve(size_t numCalls) { durationsNs.reserve(numCalls); }
+    void add(double ns) { durationsNs.push_back(ns); }
+
+    double getTotalNs() const;
+    double getPercentileNs(double percentile) const;
+
+    // min/mean/percentiles/max of a single call, in microseconds
+    juce::var toVar() const;
+
+    std::vector<double> durationsNs;
+};
+
+// Host-like play head so processBlock can run without a DAW
+struct BenchmarkPlayHead final : juce::AudioPlayHead
+{
+    juce::Optional<PositionInfo> getPosition() const override;
+
+    double bpm { 120.0 };
+};
+
+// A processor prepared for headless use at a given sample rate and block size
+struct HeadlessProcessor
+{
+    HeadlessProcessor();
+    ~HeadlessProcessor();
+
+    // The precision is set before prepareToPlay, as a host would
+    void prepare(double sampleRate, int blockSize,
+                 juce::AudioProcessor::ProcessingPrecision precision = juce::AudioProcessor::singlePrecision);
+    void setParameter(const juce::String& parameterID, float value);
+
+    BenchmarkPlayHead playHead;
+    StrangeEchoesAudioProcessor processor;
+    juce::MidiBuffer midi;
+};
+
+// One point of the preset matrix: each stage of the wet chain switched on or off
+struct BenchmarkPreset
+{
+    bool pitchShift, freqShift, lfo, filtersClosed;
+
+    juce::String getName() const;
+    void apply(HeadlessProcessor& headless) const;
+
+    // All 16 on/off combinations
+    static juce::Array<BenchmarkPreset> getAll();
+};
+
+// Per-stage timings of a profiling build, or a void var when profiling is compiled out
+juce::var getStageTimings(StrangeEchoesAudioProcessor& processor);
+
+void fillWithNoise(juce::AudioBuffer<float>& buffer, juce::Random& random, float gain);
+
+// Benchmark suites, each returns an array of result objects
+juce::var runProcessBlockBenchmark(const BenchmarkOptions& options);
+juce::var runHilbertBenchmark(const BenchmarkOptions& options);
+juce::var runConvolutionBenchmark(const BenchmarkOptions& options);
+juce::var runDelayLineBenchmark(const BenchmarkOptions& options);
+
+// processBlock with settings applied per host block against fixed sub-block sizes
+juce::var runSubBlockBenchmark(const BenchmarkOptions& options);
+
+// processBlock with the pitch shifter on the audio thread against the background worker, paced to real time
+juce::var runPitchShiftModeBenchmark(const BenchmarkOptions& options);
+
+// processBlock cost and pitch shifter latency for each Pitch Shift Quality setting
+juce::var runPitchShiftQualityBenchmark(const BenchmarkOptions& options);
+
+// Editor paint time at 1x and 2x scale: after a resize, with warm caches, and for single knob repaints
+juce::var runEditorPaintBenchmark(const BenchmarkOptions& options);
+
+// Feedback saturation cost and latency at 1x, 2x and 4x oversampling
+juce::var runSaturationBenchmark(const BenchmarkOptions& options);
+
+// LFO engine cost per shape against a std::sin per sample, and processBlock with modulation off and on
+juce::var runLfoBenchmark(const BenchmarkOptions& options);
+
+// processBlock in single against double precision, and how far a float render drifts from a double one
+// with 0.99 feedback on the longest delay
+juce::var runPrecisionBenchmark(const BenchmarkOptions& options);
+
+// The pitch crossfade, feedback write and dry/wet output as separate passes against the fused kernels
+juce::var runOutputKernelBenchmark(const BenchmarkOptions& options);
+
+// Fails if the reported tail is too short, or processBlock doesn't go idle after it and wake up on input
+juce::var runTailCheck(const BenchmarkOptions& options);
+
+// Fails if rendering in random host block sizes (including oversized ones) differs from fixed-size blocks
+juce::var runBlockSizeCheck(const BenchmarkOptions& options);
+
+// Fails if the frequency shifter's 0 Hz bypass sounds different from the shifter held engaged at 0 Hz
+juce::var runShifterBypassCheck(const BenchmarkOptions& options);
+
+// Fails if HilbertTransformer differs from a double precision direct form FIR by more than its tolerance
+juce::var runHilbertAccuracyCheck(const BenchmarkOptions& options);
+
+// Fails if the output with every tap's feedback send at its maximum goes non-finite or doesn't decay
+juce::var runTapFeedbackCheck(const BenchmarkOptions& options);
+
+// Fails if a Pitch Shift Quality or Pitch Shift Mode change after prepareToPlay isn't applied, or the
+// latency reported to the host doesn't follow the mode
+juce::var runPitchShiftSettingsCheck(const BenchmarkOptions& options);
+
+// Fails (result "passed" is false) if processBlock allocates or locks, needs STRANGE_ECHOES_RT_AUDIT
+juce::var runRealtimeAuditCheck(const BenchmarkOptions& options);
@@ -0,0 +1,118 @@
+#include "Benchmark.h"
+#include <iostream>
+
+// Headless benchmark for StrangeEchoesAudioProcessor.
+//
+// Usage: StrangeEchoesBenchmark [--suite=processBlock|hilbert|convolution|delayLine|subBlocks|pitchShiftMode|pitchShiftQuality|editorPaint|outputKernel|saturation|lfo|precision|blockSizes|tail|hilbertAccuracy|shifterBypass|tapFeedback|pitchShiftSettings|realtimeAudit]
+//                               [--sample-rates=44100,96000] [--block-sizes=64,512] [--seconds=1.0] [--output=results.json]
+//
+// Results are written as JSON (to stdout unless --output is given) so runs can be diffed.
+
+namespace
+{
+    template <typename ValueType>
+    juce::Array<ValueType> parseList(const juce::String& text)
+    {
+        juce::Array<ValueType> values;
+
+        for (auto& item : juce::StringArray::fromTokens(text, ",", {}))
+            if (item.trim().isNotEmpty())
+                values.add(static_cast<ValueType>(item.trim().getDoubleValue()));
+
+        return values;
+    }
+
+    struct Suite
+    {
+        const char* name;
+        juce::var (*run)(const BenchmarkOptions&);
+    };
+
+    const Suite suites[] =
+    {
+        { "processBlock",      runProcessBlockBenchmark },
+        { "hilbert",           runHilbertBenchmark },
+        { "convolution",       runConvolutionBenchmark },
+        { "delayLine",         runDelayLineBenchmark },
+        { "subBlocks",         runSubBlockBenchmark },
+        { "pitchShiftMode",    runPitchShiftModeBenchmark },
+        { "pitchShiftQuality", runPitchShiftQualityBenchmark },
+        { "editorPaint",       runEditorPaintBenchmark },
+        { "outputKernel",      runOutputKernelBenchmark },
+        { "saturation",        runSaturationBenchmark },
+        { "lfo",               runLfoBenchmark },
+        { "precision",         runPrecisionBenchmark },
+        { "blockSizes",        runBlockSizeCheck },
+        { "tail",              runTailCheck },
+        { "hilbertAccuracy",   runHilbertAccuracyCheck },
+        { "shifterBypass",     runShifterBypassCheck },
+        { "tapFeedback",       runTapFeedbackCheck },
+        { "pitchShiftSettings", runPitchShiftSettingsCheck },
+        { "realtimeAudit",     runRealtimeAuditCheck },
+    };
+}
+
+int main(int argc, char* argv[])
+{
+    juce::ScopedJuceInitialiser_GUI juceInitialiser;
+    juce::ArgumentList args(argc, argv);
+
+    BenchmarkOptions options;
+
+    if (args.containsOption("--sample-rates"))
+        options.sampleRates = parseList<double>(args.getValueForOption("--sample-rates"));
+
+    if (args.containsOption("--block-sizes"))
+        options.blockSizes = parseList<int>(args.getValueForOption("--block-sizes"));
+
+    if (args.containsOption("--seconds"))
+        options.secondsPerRun = juce::jmax(0.01, args.getValueForOption("--seconds").getDoubleValue());
+
+    auto suiteFilter = args.getValueForOption("--suite");
+
+    auto* root = new juce::DynamicObject();
+    root->setProperty("plugin", "StrangeArtificialEchoes");
+    root->setProperty("secondsPerRun", options.secondsPerRun);
+
+    auto* results = new juce::DynamicObject();
+    bool allPassed = true;
+
+    for (const auto& suite : suites)
+    {
+        if (suiteFilter.isNotEmpty() && suiteFilter != suite.name)
+            continue;
+
+        std::cerr << "Running " << suite.name << "..." << std::endl;
+        auto suiteResult = suite.run(options);
+
+        // Checks report a "passed" flag, a failing check makes the process exit with an error
+        if (suiteResult.hasProperty("passed") && ! static_cast<bool>(suiteResult["passed"]))
+        {
+            std::cerr << suite.name << " FAILED" << std::endl;
+            allPassed = false;
+        }
+
+        results->setProperty(suite.name, suiteResult);
+    }
+
+    root->setProperty("suites", juce::var(results));
+
+    auto json = juce::JSON::toString(juce::var(root));
+
+    if (args.containsOption("--output"))
+    {
+        auto outputFile = juce::File::getCurrentWorkingDirectory().getChildFile(args.getValueForOption("--output"));
+
+        if (! outputFile.replaceWithText(json))
+        {
+            std::cerr << "Could not write " << outputFile.getFullPathName() << std::endl;
+            return 1;
+        }
+    }
+    else
+    {
+        std::cout << json << std::endl;
+    }
+
+    return allPassed ? 0 : 1;
+}
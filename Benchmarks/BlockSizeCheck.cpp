@@ -0,0 +1,105 @@
+#include "Benchmark.h"
+
+// Renders the same input through processBlock twice: once in blocks of the prepared size, and once in
+// random block sizes from 1 sample up to twice the prepared size. Every parameter is settled, so the
+// two renders must match; a stale, skipped or repeated sample anywhere in the wet chain shows up as a
+// difference. The background pitch shift mode is left out since its output depends on thread timing.
+
+namespace
+{
+    constexpr float tolerance = 1.0e-4f;
+
+    void render(HeadlessProcessor& headless, const juce::AudioBuffer<float>& input, juce::AudioBuffer<float>& output,
+                int preparedBlockSize, juce::Random* randomBlockSizes)
+    {
+        juce::AudioBuffer<float> block(2, 2 * preparedBlockSize);
+
+        for (int start = 0; start < input.getNumSamples();)
+        {
+            auto blockSize = randomBlockSizes != nullptr ? 1 + randomBlockSizes->nextInt(2 * preparedBlockSize) : preparedBlockSize;
+            blockSize = juce::jmin(blockSize, input.getNumSamples() - start);
+
+            block.setSize(2, blockSize, false, false, true);
+
+            for (int channel = 0; channel < 2; ++channel)
+                block.copyFrom(channel, 0, input, channel, start, blockSize);
+
+            headless.processor.processBlock(block, headless.midi);
+
+            for (int channel = 0; channel < 2; ++channel)
+                output.copyFrom(channel, start, block, channel, 0, blockSize);
+
+            start += blockSize;
+        }
+    }
+}
+
+juce::var runBlockSizeCheck(const BenchmarkOptions& options)
+{
+    constexpr double sampleRate = 48000.0;
+
+    juce::Array<juce::var> failures;
+    int numConfigurations = 0;
+
+    for (auto preparedBlockSize : options.blockSizes)
+    {
+        for (const auto& preset : BenchmarkPreset::getAll())
+        {
+            auto numSamples = juce::jmax(preparedBlockSize, static_cast<int>(options.secondsPerRun * sampleRate));
+
+            juce::Random random(1);
+            juce::AudioBuffer<float> input(2, numSamples), reference(2, numSamples), output(2, numSamples);
+            fillWithNoise(input, random, 0.25f);
+
+            {
+                HeadlessProcessor headless;
+                preset.apply(headless);
+                headless.prepare(sampleRate, preparedBlockSize);
+                render(headless, input, reference, preparedBlockSize, nullptr);
+            }
+
+            {
+                HeadlessProcessor headless;
+                preset.apply(headless);
+                headless.prepare(sampleRate, preparedBlockSize);
+
+                juce::Random randomBlockSizes(2);
+                render(headless, input, output, preparedBlockSize, &randomBlockSizes);
+            }
+
+            float maxDifference = 0.f;
+            int firstDifference = -1;
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                for (int i = 0; i < numSamples; ++i)
+                {
+                    auto difference = std::abs(output.getSample(channel, i) - reference.getSample(channel, i));
+                    maxDifference = juce::jmax(maxDifference, difference);
+
+                    if (difference > tolerance && (firstDifference < 0 || i < firstDifference))
+                        firstDifference = i;
+                }
+            }
+
+            ++numConfigurations;
+
+            if (maxDifference > tolerance)
+            {
+                auto* failure = new juce::DynamicObject();
+                failure->setProperty("preset",          preset.getName());
+                failure->setProperty("blockSize",       preparedBlockSize);
+                failure->setProperty("maxDifference",   maxDifference);
+                failure->setProperty("firstDifference", firstDifference);
+                failures.add(juce::var(failure));
+            }
+        }
+    }
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("configurations", numConfigurations);
+    result->setProperty("failures",       failures);
+    result->setProperty("passed",         failures.isEmpty());
+
+    return juce::var(result);
+}
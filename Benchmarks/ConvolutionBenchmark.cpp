@@ -0,0 +1,105 @@
+#include "Benchmark.h"
+
+// Long Hilbert kernels (1k - 8k taps) through the direct form juce::dsp::FIR::Filter, the
+// odd-tap HilbertTransformer and the PartitionedConvolver used by the long linear phase mode.
+
+namespace
+{
+    juce::var runKernel(int numTaps, int blockSize, const BenchmarkOptions& options)
+    {
+        constexpr double sampleRate = 48000.0;
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+
+        auto taps = designHilbertKernel(numTaps);
+
+        juce::dsp::ProcessSpec spec { sampleRate, static_cast<juce::uint32>(blockSize), 1 };
+        juce::dsp::FIR::Coefficients<float>::Ptr coefficients = new juce::dsp::FIR::Coefficients<float>(taps.data(), taps.size());
+        juce::dsp::FIR::Filter<float> directL(coefficients), directR(coefficients);
+        directL.prepare(spec);
+        directR.prepare(spec);
+
+        // HilbertTransformer wants the centre tap on an even index, so pad by one zero either side.
+        // That delays its output by one sample, which doesn't matter as it is only timed.
+        std::vector<float> paddedTaps(taps.size() + 2, 0.f);
+        std::copy(taps.begin(), taps.end(), paddedTaps.begin() + 1);
+
+        HilbertTransformer hilbert;
+        hilbert.setKernel(paddedTaps.data(), static_cast<int>(paddedTaps.size()));
+        hilbert.prepare(blockSize);
+
+        PartitionedConvolver convolver;
+        convolver.prepare(taps.data(), numTaps, FrequencyShifter<float>::longFilterPartitionSize, 2);
+        auto latency = convolver.getLatencyInSamples();
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> input(2, blockSize), direct(2, blockSize), kernel(2, blockSize), partitioned(2, blockSize);
+
+        // Left channel of the whole run, to compare the convolver against the direct form once it has caught up
+        std::vector<float> directHistory, partitionedHistory;
+        directHistory.reserve(static_cast<size_t>(numBlocks * blockSize));
+        partitionedHistory.reserve(static_cast<size_t>(numBlocks * blockSize));
+
+        TimingStats directStats, kernelStats, partitionedStats;
+        Stopwatch stopwatch;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            fillWithNoise(input, random, 0.5f);
+            direct.makeCopyOf(input, true);
+
+            stopwatch.start();
+            {
+                juce::dsp::AudioBlock<float> audioBlock(direct);
+                auto left = audioBlock.getSingleChannelBlock(0);
+                auto right = audioBlock.getSingleChannelBlock(1);
+                directL.process(juce::dsp::ProcessContextReplacing<float>(left));
+                directR.process(juce::dsp::ProcessContextReplacing<float>(right));
+            }
+            directStats.add(stopwatch.getElapsedNs());
+
+            stopwatch.start();
+            hilbert.process(input.getReadPointer(0), input.getReadPointer(1),
+                            kernel.getWritePointer(0), kernel.getWritePointer(1), blockSize);
+            kernelStats.add(stopwatch.getElapsedNs());
+
+            stopwatch.start();
+            for (int channel = 0; channel < 2; ++channel)
+                convolver.process(channel, input.getReadPointer(channel), partitioned.getWritePointer(channel), blockSize);
+            partitionedStats.add(stopwatch.getElapsedNs());
+
+            directHistory.insert(directHistory.end(), direct.getReadPointer(0), direct.getReadPointer(0) + blockSize);
+            partitionedHistory.insert(partitionedHistory.end(), partitioned.getReadPointer(0), partitioned.getReadPointer(0) + blockSize);
+        }
+
+        float maxError = 0.f;
+
+        for (size_t i = static_cast<size_t>(latency); i < partitionedHistory.size(); ++i)
+            maxError = juce::jmax(maxError, std::abs(partitionedHistory[i] - directHistory[i - static_cast<size_t>(latency)]));
+
+        auto numFrames = static_cast<double>(numBlocks) * blockSize;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("taps",                     numTaps);
+        result->setProperty("blockSize",                blockSize);
+        result->setProperty("partitionSize",            latency);
+        result->setProperty("directNsPerFrame",         directStats.getTotalNs() / numFrames);
+        result->setProperty("kernelNsPerFrame",         kernelStats.getTotalNs() / numFrames);
+        result->setProperty("partitionedNsPerFrame",    partitionedStats.getTotalNs() / numFrames);
+        result->setProperty("speedup",                  directStats.getTotalNs() / juce::jmax(1.0, partitionedStats.getTotalNs()));
+        result->setProperty("partitionedBlockLatency",  partitionedStats.toVar());
+        result->setProperty("maxAbsError",              maxError);
+
+        return juce::var(result);
+    }
+}
+
+juce::var runConvolutionBenchmark(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+
+    for (auto numTaps : { 1023, 2047, 4095, 8191 })
+        for (auto blockSize : options.blockSizes)
+            results.add(runKernel(numTaps, blockSize, options));
+
+    return results;
+}
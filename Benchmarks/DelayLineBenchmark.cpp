@@ -0,0 +1,150 @@
+#include "Benchmark.h"
+
+// Cost of each ModulatedDelayLine interpolation mode, stereo, with a 300 ms delay swept by
+// a 1 Hz, 20 ms LFO so every sample has a different fractional delay.
+//
+// Then 8 fixed taps, read with one addTaps() call per channel against 8 linear read() calls.
+
+namespace
+{
+    const char* getInterpolationName(DelayInterpolation interpolation)
+    {
+        switch (interpolation)
+        {
+            case DelayInterpolation::linear:    return "linear";
+            case DelayInterpolation::hermite:   return "hermite";
+            case DelayInterpolation::lagrange:  return "lagrange";
+            case DelayInterpolation::allpass:   return "allpass";
+        }
+
+        return "";
+    }
+
+    juce::var runInterpolation(DelayInterpolation interpolation, int blockSize, const BenchmarkOptions& options)
+    {
+        constexpr double sampleRate = 48000.0;
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+
+        ModulatedDelayLine<float> delayLine;
+        delayLine.prepare(2, static_cast<int>(2.5 * sampleRate), blockSize);
+        delayLine.setInterpolation(interpolation);
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> input(2, blockSize), output(2, blockSize), delayTimes(1, blockSize);
+
+        TimingStats stats;
+        Stopwatch stopwatch;
+        double lfoPhase = 0.0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            fillWithNoise(input, random, 0.5f);
+
+            for (int i = 0; i < blockSize; ++i)
+            {
+                delayTimes.setSample(0, i, static_cast<float>((0.3 + 0.02 * std::sin(2.0 * juce::MathConstants<double>::pi * lfoPhase)) * sampleRate));
+                lfoPhase += 1.0 / sampleRate;
+            }
+
+            stopwatch.start();
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                delayLine.write(channel, input.getReadPointer(channel), blockSize);
+                delayLine.read(channel, delayTimes.getReadPointer(0), output.getWritePointer(channel), blockSize);
+            }
+            delayLine.advance(blockSize);
+            stats.add(stopwatch.getElapsedNs());
+        }
+
+        auto numFrames = static_cast<double>(numBlocks) * blockSize;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("interpolation",    getInterpolationName(interpolation));
+        result->setProperty("blockSize",        blockSize);
+        result->setProperty("nsPerFrame",       stats.getTotalNs() / numFrames);
+        result->setProperty("blockLatency",     stats.toVar());
+
+        return juce::var(result);
+    }
+
+    juce::var runTaps(bool singlePass, int blockSize, const BenchmarkOptions& options)
+    {
+        constexpr double sampleRate = 48000.0;
+        constexpr int numTaps = 8;
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+
+        ModulatedDelayLine<float> delayLine;
+        delayLine.prepare(2, static_cast<int>(2.5 * sampleRate), blockSize);
+        delayLine.setInterpolation(DelayInterpolation::linear);
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> input(2, blockSize), output(2, blockSize), tapOutput(2, blockSize);
+        juce::AudioBuffer<float> delayTimes(numTaps, blockSize);
+
+        std::array<DelayTap, numTaps> taps;
+
+        for (int k = 0; k < numTaps; ++k)
+        {
+            auto delay = static_cast<float>((k + 1) * 0.15 * sampleRate) + 0.3f;
+            taps[(size_t) k] = { delay, delay, 0.5f, 0.5f };
+
+            for (int i = 0; i < blockSize; ++i)
+                delayTimes.setSample(k, i, delay);
+        }
+
+        TimingStats stats;
+        Stopwatch stopwatch;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            fillWithNoise(input, random, 0.5f);
+            output.clear();
+
+            stopwatch.start();
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                delayLine.write(channel, input.getReadPointer(channel), blockSize);
+
+                if (singlePass)
+                {
+                    delayLine.addTaps(channel, taps.data(), numTaps, output.getWritePointer(channel), blockSize);
+                }
+                else
+                {
+                    for (int k = 0; k < numTaps; ++k)
+                    {
+                        delayLine.read(channel, delayTimes.getReadPointer(k), tapOutput.getWritePointer(channel), blockSize);
+                        output.addFrom(channel, 0, tapOutput, channel, 0, blockSize, 0.5f);
+                    }
+                }
+            }
+            delayLine.advance(blockSize);
+            stats.add(stopwatch.getElapsedNs());
+        }
+
+        auto numFrames = static_cast<double>(numBlocks) * blockSize;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("interpolation",    singlePass ? "linear, 8 taps, addTaps" : "linear, 8 taps, read");
+        result->setProperty("blockSize",        blockSize);
+        result->setProperty("nsPerFrame",       stats.getTotalNs() / numFrames);
+        result->setProperty("blockLatency",     stats.toVar());
+
+        return juce::var(result);
+    }
+}
+
+juce::var runDelayLineBenchmark(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+
+    for (auto interpolation : { DelayInterpolation::linear, DelayInterpolation::hermite, DelayInterpolation::lagrange, DelayInterpolation::allpass })
+        for (auto blockSize : options.blockSizes)
+            results.add(runInterpolation(interpolation, blockSize, options));
+
+    for (auto singlePass : { false, true })
+        for (auto blockSize : options.blockSizes)
+            results.add(runTaps(singlePass, blockSize, options));
+
+    return results;
+}
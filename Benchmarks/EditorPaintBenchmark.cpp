@@ -0,0 +1,87 @@
+#include "Benchmark.h"
+#include "../Source/StrangeEchoesEditor.h"
+
+// Editor paint cost, rendered into an image at 1x and 2x pixel scale without a window:
+//  - "resize":      the whole editor right after a resize, which drops the cached layers
+//  - "full":        the whole editor with the caches warm
+//  - "knob":        one rotary slider moved and only its bounds repainted, as automation does,
+//                   cycling through all of them
+
+namespace
+{
+    void paintRegion(juce::Component& editor, juce::Image& target, float scale, juce::Rectangle<int> region)
+    {
+        juce::Graphics g(target);
+        g.addTransform(juce::AffineTransform::scale(scale));
+        g.reduceClipRegion(region);
+        editor.paintEntireComponent(g, true);
+    }
+
+    juce::var runPaintCase(juce::AudioProcessorEditor& editor, float scale, const juce::String& name, int numIterations)
+    {
+        auto bounds = editor.getLocalBounds();
+        juce::Image target(juce::Image::RGB, juce::roundToInt(bounds.getWidth() * scale), juce::roundToInt(bounds.getHeight() * scale), true);
+
+        juce::Array<RotarySliderWithLabels*> sliders;
+
+        for (auto* child : editor.getChildren())
+            if (auto* slider = dynamic_cast<RotarySliderWithLabels*>(child))
+                sliders.add(slider);
+
+        // Warm up every cache at this scale
+        paintRegion(editor, target, scale, bounds);
+
+        TimingStats stats;
+        stats.reserve(static_cast<size_t>(numIterations));
+        Stopwatch stopwatch;
+
+        for (int i = 0; i < numIterations; ++i)
+        {
+            auto region = bounds;
+
+            if (name == "resize")
+            {
+                // Alternates between two widths so every call invalidates the caches
+                editor.setSize(bounds.getWidth() + (i % 2), bounds.getHeight());
+                region = editor.getLocalBounds();
+            }
+            else if (name == "knob" && ! sliders.isEmpty())
+            {
+                auto* slider = sliders[i % sliders.size()];
+                auto range = slider->getRange();
+                slider->setValue(range.getStart() + range.getLength() * ((i / sliders.size()) % 10) / 10.0, juce::dontSendNotification);
+                region = slider->getBoundsInParent();
+            }
+
+            stopwatch.start();
+            paintRegion(editor, target, scale, region);
+            stats.add(stopwatch.getElapsedNs());
+        }
+
+        editor.setSize(bounds.getWidth(), bounds.getHeight());
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("case",    name);
+        result->setProperty("scale",   scale);
+        result->setProperty("paint",   stats.toVar());
+
+        return juce::var(result);
+    }
+}
+
+juce::var runEditorPaintBenchmark(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+
+    HeadlessProcessor headless;
+    headless.prepare(48000.0, 512);
+
+    std::unique_ptr<juce::AudioProcessorEditor> editor(headless.processor.createEditor());
+    auto numIterations = juce::jmax(10, static_cast<int>(options.secondsPerRun * 200.0));
+
+    for (auto scale : { 1.f, 2.f })
+        for (auto* name : { "resize", "full", "knob" })
+            results.add(runPaintCase(*editor, scale, name, numIterations));
+
+    return results;
+}
@@ -0,0 +1,107 @@
+#include "Benchmark.h"
+
+// Checks HilbertTransformer against a plain direct form FIR computed in double, for the
+// FrequencyShifter's 301 tap kernel and a longer designed one. Blocks alternate between
+// separate and in-place buffers, and every fourth block only pushes history (as the bypassed
+// shifter does), so the check also covers the history being carried across those.
+
+namespace
+{
+    // Float accumulation over the odd taps of noise at 0.5, well below anything audible
+    constexpr double tolerance = 1.0e-5;
+
+    juce::var runKernel(const std::vector<float>& taps, int blockSize, const BenchmarkOptions& options)
+    {
+        constexpr double sampleRate = 48000.0;
+        auto numBlocks = juce::jmax(8, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+        auto numTaps = static_cast<int>(taps.size());
+
+        HilbertTransformer hilbert;
+        hilbert.setKernel(taps.data(), numTaps);
+        hilbert.prepare(blockSize);
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> input(2, blockSize), output(2, blockSize);
+
+        // Whole input of each channel, the reference runs over it from the start
+        std::array<std::vector<float>, 2> history;
+        double maxError = 0.0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            fillWithNoise(input, random, 0.5f);
+
+            for (int channel = 0; channel < 2; ++channel)
+                history[(size_t) channel].insert(history[(size_t) channel].end(), input.getReadPointer(channel), input.getReadPointer(channel) + blockSize);
+
+            if (block % 4 == 3)
+            {
+                hilbert.pushHistory(input.getReadPointer(0), input.getReadPointer(1), blockSize);
+                continue;
+            }
+
+            if (block % 2 == 0)
+            {
+                hilbert.process(input.getReadPointer(0), input.getReadPointer(1),
+                                output.getWritePointer(0), output.getWritePointer(1), blockSize);
+            }
+            else
+            {
+                output.makeCopyOf(input, true);
+                hilbert.process(output.getReadPointer(0), output.getReadPointer(1),
+                                output.getWritePointer(0), output.getWritePointer(1), blockSize);
+            }
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                const auto& x = history[(size_t) channel];
+                auto blockStart = static_cast<int>(x.size()) - blockSize;
+
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    auto n = blockStart + i;
+                    double expected = 0.0;
+
+                    for (int k = 0; k < numTaps && k <= n; ++k)
+                        expected += static_cast<double>(taps[(size_t) k]) * x[(size_t) (n - k)];
+
+                    maxError = juce::jmax(maxError, std::abs(output.getSample(channel, i) - expected));
+                }
+            }
+        }
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("taps",         numTaps);
+        result->setProperty("blockSize",    blockSize);
+        result->setProperty("maxAbsError",  maxError);
+        result->setProperty("tolerance",    tolerance);
+        result->setProperty("passed",       maxError <= tolerance);
+
+        return juce::var(result);
+    }
+}
+
+juce::var runHilbertAccuracyCheck(const BenchmarkOptions& options)
+{
+    FrequencyShifter<float> shifter;
+    std::vector<float> shifterTaps(shifter.firCoeffArray.begin(), shifter.firCoeffArray.end());
+
+    juce::Array<juce::var> runs;
+    auto passed = true;
+
+    for (const auto& taps : { shifterTaps, designHilbertKernel(1025) })
+    {
+        for (auto blockSize : options.blockSizes)
+        {
+            auto run = runKernel(taps, blockSize, options);
+            passed = passed && static_cast<bool>(run["passed"]);
+            runs.add(run);
+        }
+    }
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("runs",     runs);
+    result->setProperty("passed",   passed);
+
+    return juce::var(result);
+}
@@ -0,0 +1,89 @@
+#include "Benchmark.h"
+
+// Compares the FrequencyShifter's Hilbert kernel against the juce::dsp::FIR::Filter
+// direct form it replaced (one filter per channel, all 301 taps), and against the
+// allpass pair used by the low latency mode.
+
+namespace
+{
+    juce::var runBlockSize(const juce::Array<float>& taps, int blockSize, const BenchmarkOptions& options)
+    {
+        constexpr double sampleRate = 48000.0;
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+
+        juce::dsp::ProcessSpec spec { sampleRate, static_cast<juce::uint32>(blockSize), 1 };
+        juce::dsp::FIR::Coefficients<float>::Ptr coefficients = new juce::dsp::FIR::Coefficients<float>(taps.getRawDataPointer(), static_cast<size_t>(taps.size()));
+        juce::dsp::FIR::Filter<float> directL(coefficients), directR(coefficients);
+        directL.prepare(spec);
+        directR.prepare(spec);
+
+        HilbertTransformer hilbert;
+        hilbert.setKernel(taps.getRawDataPointer(), taps.size());
+        hilbert.prepare(blockSize);
+
+        AllpassHilbertTransformer<float> allpass;
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> input(2, blockSize), direct(2, blockSize), kernel(2, blockSize);
+        juce::AudioBuffer<float> inPhase(2, blockSize), quadrature(2, blockSize);
+
+        TimingStats directStats, kernelStats, allpassStats;
+        Stopwatch stopwatch;
+        float maxError = 0.f;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            fillWithNoise(input, random, 0.5f);
+            direct.makeCopyOf(input, true);
+
+            stopwatch.start();
+            {
+                juce::dsp::AudioBlock<float> audioBlock(direct);
+                auto left = audioBlock.getSingleChannelBlock(0);
+                auto right = audioBlock.getSingleChannelBlock(1);
+                directL.process(juce::dsp::ProcessContextReplacing<float>(left));
+                directR.process(juce::dsp::ProcessContextReplacing<float>(right));
+            }
+            directStats.add(stopwatch.getElapsedNs());
+
+            stopwatch.start();
+            hilbert.process(input.getReadPointer(0), input.getReadPointer(1),
+                            kernel.getWritePointer(0), kernel.getWritePointer(1), blockSize);
+            kernelStats.add(stopwatch.getElapsedNs());
+
+            stopwatch.start();
+            allpass.process(input.getReadPointer(0), input.getReadPointer(1),
+                            inPhase.getWritePointer(0), inPhase.getWritePointer(1),
+                            quadrature.getWritePointer(0), quadrature.getWritePointer(1), blockSize);
+            allpassStats.add(stopwatch.getElapsedNs());
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    maxError = juce::jmax(maxError, std::abs(direct.getSample(channel, i) - kernel.getSample(channel, i)));
+        }
+
+        auto numFrames = static_cast<double>(numBlocks) * blockSize;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("blockSize",            blockSize);
+        result->setProperty("taps",                 taps.size());
+        result->setProperty("directNsPerFrame",     directStats.getTotalNs() / numFrames);
+        result->setProperty("kernelNsPerFrame",     kernelStats.getTotalNs() / numFrames);
+        result->setProperty("allpassNsPerFrame",    allpassStats.getTotalNs() / numFrames);
+        result->setProperty("speedup",              directStats.getTotalNs() / juce::jmax(1.0, kernelStats.getTotalNs()));
+        result->setProperty("maxAbsError",          maxError);
+
+        return juce::var(result);
+    }
+}
+
+juce::var runHilbertBenchmark(const BenchmarkOptions& options)
+{
+    FrequencyShifter<float> shifter;
+    juce::Array<juce::var> results;
+
+    for (auto blockSize : options.blockSizes)
+        results.add(runBlockSize(shifter.firCoeffArray, blockSize, options));
+
+    return results;
+}
@@ -0,0 +1,172 @@
+#include "Benchmark.h"
+
+// Cost of the LFO engine for each shape, stereo with a 90 degree offset, against the std::sin per sample
+// it replaced. Then processBlock on the plain preset with modulation off, and on for each shape, to show
+// what enabling the LFO adds to a whole block.
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+
+    const char* getShapeName(Lfo::Shape shape)
+    {
+        switch (shape)
+        {
+            case Lfo::Shape::sine:          return "sine";
+            case Lfo::Shape::triangle:      return "triangle";
+            case Lfo::Shape::saw:           return "saw";
+            case Lfo::Shape::square:        return "square";
+            case Lfo::Shape::sampleAndHold: return "sampleAndHold";
+            case Lfo::Shape::smoothRandom:  return "smoothRandom";
+        }
+
+        return "";
+    }
+
+    const Lfo::Shape allShapes[] = { Lfo::Shape::sine, Lfo::Shape::triangle, Lfo::Shape::saw,
+                                     Lfo::Shape::square, Lfo::Shape::sampleAndHold, Lfo::Shape::smoothRandom };
+
+    juce::var makeResult(const juce::String& shape, int blockSize, const TimingStats& stats, double numFrames)
+    {
+        auto* result = new juce::DynamicObject();
+        result->setProperty("shape",            shape);
+        result->setProperty("blockSize",        blockSize);
+        result->setProperty("nsPerFrame",       stats.getTotalNs() / numFrames);
+        result->setProperty("blockLatency",     stats.toVar());
+
+        return juce::var(result);
+    }
+
+    juce::var runEngine(Lfo::Shape shape, int blockSize, const BenchmarkOptions& options)
+    {
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+
+        Lfo lfo;
+        lfo.setShape(shape);
+        lfo.setStereoOffset(0.25);
+        lfo.prepare(sampleRate);
+        lfo.setRate(5.0);
+
+        juce::AudioBuffer<float> output(2, blockSize);
+
+        TimingStats stats;
+        Stopwatch stopwatch;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            stopwatch.start();
+            lfo.process(output.getArrayOfWritePointers(), 2, blockSize);
+            stats.add(stopwatch.getElapsedNs());
+        }
+
+        return makeResult(getShapeName(shape), blockSize, stats, static_cast<double>(numBlocks) * blockSize);
+    }
+
+    // The previous LFO: a float phase and a std::sin for every sample and channel
+    juce::var runStdSin(int blockSize, const BenchmarkOptions& options)
+    {
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+        const auto increment = static_cast<float>(5.0 / sampleRate);
+
+        juce::AudioBuffer<float> output(2, blockSize);
+        float phase = 0.f;
+
+        TimingStats stats;
+        Stopwatch stopwatch;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            stopwatch.start();
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                auto* data = output.getWritePointer(channel);
+                auto channelPhase = phase + 0.25f * static_cast<float>(channel);
+
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    data[i] = std::sin(channelPhase * 2 * juce::MathConstants<float>::pi);
+
+                    channelPhase += increment;
+                    if (channelPhase > 1)
+                        channelPhase -= 1.0f;
+                }
+            }
+            stats.add(stopwatch.getElapsedNs());
+
+            phase = std::fmod(phase + increment * static_cast<float>(blockSize), 1.f);
+        }
+
+        return makeResult("std::sin", blockSize, stats, static_cast<double>(numBlocks) * blockSize);
+    }
+
+    juce::var runProcessBlock(const Lfo::Shape* shape, int blockSize, const BenchmarkOptions& options)
+    {
+        HeadlessProcessor headless;
+        BenchmarkPreset{}.apply(headless);
+
+        if (shape != nullptr)
+        {
+            headless.setParameter("LFO Rate",           2.f);
+            headless.setParameter("LFO Amount",         20.f);
+            headless.setParameter("LFO Shape",          static_cast<float>(*shape));
+            headless.setParameter("LFO Stereo Offset",  90.f);
+        }
+
+        headless.prepare(sampleRate, blockSize);
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> input(2, blockSize), buffer(2, blockSize);
+        fillWithNoise(input, random, 0.25f);
+
+        auto warmUpBlocks = juce::jmax(1, static_cast<int>(options.warmUpSeconds * sampleRate / blockSize));
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+
+        for (int block = 0; block < warmUpBlocks; ++block)
+        {
+            buffer.makeCopyOf(input, true);
+            headless.processor.processBlock(buffer, headless.midi);
+        }
+
+        TimingStats stats;
+        stats.reserve(static_cast<size_t>(numBlocks));
+        Stopwatch stopwatch;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            buffer.makeCopyOf(input, true);
+
+            stopwatch.start();
+            headless.processor.processBlock(buffer, headless.midi);
+            stats.add(stopwatch.getElapsedNs());
+        }
+
+        auto result = makeResult(shape != nullptr ? getShapeName(*shape) : "off", blockSize, stats,
+                                 static_cast<double>(numBlocks) * blockSize);
+        result.getDynamicObject()->setProperty("stage", "processBlock");
+
+        return result;
+    }
+}
+
+juce::var runLfoBenchmark(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+
+    for (auto blockSize : options.blockSizes)
+    {
+        results.add(runStdSin(blockSize, options));
+
+        for (auto shape : allShapes)
+            results.add(runEngine(shape, blockSize, options));
+    }
+
+    for (auto blockSize : options.blockSizes)
+    {
+        results.add(runProcessBlock(nullptr, blockSize, options));
+
+        for (const auto& shape : allShapes)
+            results.add(runProcessBlock(&shape, blockSize, options));
+    }
+
+    return results;
+}
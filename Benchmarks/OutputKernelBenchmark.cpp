@@ -0,0 +1,148 @@
+#include "Benchmark.h"
+
+// The per-sample mixes at the end of processBlock, stereo with every gain ramping: the pitch
+// crossfade, the feedback write through the routing matrix (plus tap feedback) and the dry/wet
+// output, first as the separate passes processBlock used to make, then with the fused kernels.
+//
+// bytesPerFrame is the memory traffic each version needs in theory (every buffer load and store,
+// counting the delay line's mirror), so gbPerSecond shows how close a run gets to being bandwidth
+// bound. maxError is the largest difference of the fused output from the separate passes.
+
+namespace
+{
+    struct Buffers
+    {
+        explicit Buffers(int blockSize)
+            : wet(2, blockSize), pitch(2, blockSize), tapFeedback(2, blockSize), dry(2, blockSize)
+        {
+            delayLine.prepare(2, 48000, blockSize);
+        }
+
+        ModulatedDelayLine<float> delayLine;
+        juce::AudioBuffer<float> wet, pitch, tapFeedback, dry;
+    };
+
+    void runSeparate(Buffers& b, int blockSize, bool withTaps, float prev, float next,
+                     const std::array<float, 4>& prevGains, const std::array<float, 4>& gains)
+    {
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            b.wet.applyGainRamp(channel, 0, blockSize, 1.f - prev, 1.f - next);
+            b.wet.addFromWithRamp(channel, 0, b.pitch.getReadPointer(channel), blockSize, prev, next);
+        }
+
+        // The routing matrix as one ramped add per gain, { left to left, right to left, left to right, right to right }
+        for (size_t j = 0; j < 4; ++j)
+            b.delayLine.addWithRamp(static_cast<int>(j / 2), b.wet.getReadPointer(static_cast<int>(j % 2)), blockSize, prevGains[j], gains[j]);
+
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            if (withTaps)
+                b.delayLine.addWithRamp(channel, b.tapFeedback.getReadPointer(channel), blockSize, 1.f, 1.f);
+
+            b.dry.applyGainRamp(channel, 0, blockSize, 1.f - prev, 1.f - next);
+            b.dry.addFromWithRamp(channel, 0, b.wet.getReadPointer(channel), blockSize, prev, next);
+        }
+    }
+
+    void runFused(Buffers& b, int blockSize, bool withTaps, float prev, float next,
+                  const std::array<float, 4>& prevGains, const std::array<float, 4>& gains)
+    {
+        auto amount = MixKernels::Ramp::between(prev, next, blockSize);
+
+        for (int channel = 0; channel < 2; ++channel)
+            MixKernels::crossfade(b.wet.getWritePointer(channel), b.pitch.getReadPointer(channel), blockSize, amount);
+
+        const float* extraFeedback[2] = { b.tapFeedback.getReadPointer(0), b.tapFeedback.getReadPointer(1) };
+
+        b.delayLine.addFeedbackAndMix(b.wet.getArrayOfReadPointers(), withTaps ? extraFeedback : nullptr, blockSize,
+                                      prevGains, gains, b.dry.getArrayOfWritePointers(), prev, next);
+    }
+
+    juce::var run(bool withTaps, int blockSize, const BenchmarkOptions& options)
+    {
+        constexpr double sampleRate = 48000.0;
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+
+        Buffers separate(blockSize), fused(blockSize);
+        juce::Random random(1);
+
+        TimingStats separateStats, fusedStats;
+        Stopwatch stopwatch;
+        float maxError = 0.f;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            fillWithNoise(separate.wet, random, 0.5f);
+            fillWithNoise(separate.pitch, random, 0.5f);
+            fillWithNoise(separate.tapFeedback, random, 0.1f);
+            fillWithNoise(separate.dry, random, 0.5f);
+
+            fused.wet.makeCopyOf(separate.wet, true);
+            fused.pitch.makeCopyOf(separate.pitch, true);
+            fused.tapFeedback.makeCopyOf(separate.tapFeedback, true);
+            fused.dry.makeCopyOf(separate.dry, true);
+
+            // Everything moving, as while a knob is turned
+            auto prev = 0.5f + 0.4f * std::sin(0.01f * static_cast<float>(block));
+            auto next = 0.5f + 0.4f * std::sin(0.01f * static_cast<float>(block + 1));
+            std::array<float, 4> prevGains { 0.5f * prev, 0.1f, 0.1f, 0.5f * prev };
+            std::array<float, 4> gains { 0.5f * next, 0.1f, 0.1f, 0.5f * next };
+
+            for (auto* buffers : { &separate, &fused })
+                for (int channel = 0; channel < 2; ++channel)
+                    buffers->delayLine.write(channel, separate.pitch.getReadPointer(channel), blockSize);
+
+            stopwatch.start();
+            runSeparate(separate, blockSize, withTaps, prev, next, prevGains, gains);
+            separateStats.add(stopwatch.getElapsedNs());
+
+            stopwatch.start();
+            runFused(fused, blockSize, withTaps, prev, next, prevGains, gains);
+            fusedStats.add(stopwatch.getElapsedNs());
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    maxError = juce::jmax(maxError, std::abs(separate.dry.getSample(channel, i) - fused.dry.getSample(channel, i)));
+
+            separate.delayLine.advance(blockSize);
+            fused.delayLine.advance(blockSize);
+        }
+
+        auto numFrames = static_cast<double>(numBlocks) * blockSize;
+        auto separateNs = separateStats.getTotalNs() / numFrames;
+        auto fusedNs = fusedStats.getTotalNs() / numFrames;
+
+        // Stereo, 4 bytes a sample. Separate: pitch 2 x (2 + 3), matrix 4 x 4, taps 2 x 4,
+        // output 2 x (2 + 3). Fused: crossfade 2 x 3, then wet, taps, delay, mirror, out 2 x (1 + 1 + 2 + 1 + 2).
+        auto separateBytes = 4.0 * (10 + 16 + (withTaps ? 8 : 0) + 10);
+        auto fusedBytes = 4.0 * (6 + 12 + (withTaps ? 2 : 0));
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("tapFeedback",          withTaps);
+        result->setProperty("blockSize",            blockSize);
+        result->setProperty("separateNsPerFrame",   separateNs);
+        result->setProperty("fusedNsPerFrame",      fusedNs);
+        result->setProperty("speedup",              fusedNs > 0.0 ? separateNs / fusedNs : 0.0);
+        result->setProperty("separateBytesPerFrame", separateBytes);
+        result->setProperty("fusedBytesPerFrame",   fusedBytes);
+        result->setProperty("separateGbPerSecond",  separateNs > 0.0 ? separateBytes / separateNs : 0.0);
+        result->setProperty("fusedGbPerSecond",     fusedNs > 0.0 ? fusedBytes / fusedNs : 0.0);
+        result->setProperty("maxError",             maxError);
+        result->setProperty("separateLatency",      separateStats.toVar());
+        result->setProperty("fusedLatency",         fusedStats.toVar());
+
+        return juce::var(result);
+    }
+}
+
+juce::var runOutputKernelBenchmark(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+
+    for (auto withTaps : { false, true })
+        for (auto blockSize : options.blockSizes)
+            results.add(run(withTaps, blockSize, options));
+
+    return results;
+}
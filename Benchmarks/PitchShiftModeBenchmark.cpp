@@ -0,0 +1,74 @@
+#include "Benchmark.h"
+#include <thread>
+
+// processBlock cost with the pitch shifter on the audio thread ("Realtime") against the worker
+// thread ("Background"), pitch shifting only. Blocks are paced to real time so the worker gets the
+// same time to keep up as it would in a host; underruns count blocks it failed to deliver in time.
+
+namespace
+{
+    juce::var runPitchShiftMode(int pitchShiftMode, int blockSize, const BenchmarkOptions& options)
+    {
+        constexpr double sampleRate = 48000.0;
+
+        HeadlessProcessor headless;
+        BenchmarkPreset { true, false, false, false }.apply(headless);
+        headless.setParameter("Pitch Shift Mode", static_cast<float>(pitchShiftMode));
+        headless.prepare(sampleRate, blockSize);
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> input(2, blockSize);
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        fillWithNoise(input, random, 0.25f);
+
+        auto warmUpBlocks = juce::jmax(1, static_cast<int>(options.warmUpSeconds * sampleRate / blockSize));
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+        auto blockPeriod = std::chrono::duration_cast<Stopwatch::Clock::duration>(std::chrono::duration<double>(blockSize / sampleRate));
+
+        TimingStats stats;
+        stats.reserve(static_cast<size_t>(numBlocks));
+        Stopwatch stopwatch;
+        juce::uint64 underrunsBefore = 0;
+        auto deadline = Stopwatch::Clock::now();
+
+        for (int block = 0; block < warmUpBlocks + numBlocks; ++block)
+        {
+            if (block == warmUpBlocks)
+                underrunsBefore = headless.processor.getBackgroundPitchShiftUnderruns();
+
+            buffer.makeCopyOf(input, true);
+
+            stopwatch.start();
+            headless.processor.processBlock(buffer, headless.midi);
+
+            if (block >= warmUpBlocks)
+                stats.add(stopwatch.getElapsedNs());
+
+            deadline += blockPeriod;
+            std::this_thread::sleep_until(deadline);
+        }
+
+        auto numSamples = static_cast<double>(numBlocks) * blockSize;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("mode",          pitchShiftMode == 1 ? "background" : "realtime");
+        result->setProperty("blockSize",     blockSize);
+        result->setProperty("latency",       headless.processor.getLatencySamples());
+        result->setProperty("underruns",     static_cast<juce::int64>(headless.processor.getBackgroundPitchShiftUnderruns() - underrunsBefore));
+        result->setProperty("nsPerSample",   stats.getTotalNs() / numSamples);
+        result->setProperty("blockLatency",  stats.toVar());
+
+        return juce::var(result);
+    }
+}
+
+juce::var runPitchShiftModeBenchmark(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+
+    for (auto blockSize : options.blockSizes)
+        for (auto pitchShiftMode : { 0, 1 })
+            results.add(runPitchShiftMode(pitchShiftMode, blockSize, options));
+
+    return results;
+}
@@ -0,0 +1,73 @@
+#include "Benchmark.h"
+
+// processBlock cost and pitch shifter latency for each Pitch Shift Quality setting, pitch shifting
+// only, on the audio thread.
+
+namespace
+{
+    const char* getQualityName(int choice)
+    {
+        switch (choice)
+        {
+            case 1:     return "eco";
+            case 2:     return "normal";
+            case 3:     return "high";
+            default:    return "auto";
+        }
+    }
+
+    juce::var runPitchShiftQuality(int qualityChoice, int blockSize, const BenchmarkOptions& options)
+    {
+        constexpr double sampleRate = 48000.0;
+
+        HeadlessProcessor headless;
+        BenchmarkPreset { true, false, false, false }.apply(headless);
+        headless.setParameter("Pitch Shift Quality", static_cast<float>(qualityChoice));
+        headless.prepare(sampleRate, blockSize);
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> input(2, blockSize);
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        fillWithNoise(input, random, 0.25f);
+
+        auto warmUpBlocks = juce::jmax(1, static_cast<int>(options.warmUpSeconds * sampleRate / blockSize));
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+
+        TimingStats stats;
+        stats.reserve(static_cast<size_t>(numBlocks));
+        Stopwatch stopwatch;
+
+        for (int block = 0; block < warmUpBlocks + numBlocks; ++block)
+        {
+            buffer.makeCopyOf(input, true);
+
+            stopwatch.start();
+            headless.processor.processBlock(buffer, headless.midi);
+
+            if (block >= warmUpBlocks)
+                stats.add(stopwatch.getElapsedNs());
+        }
+
+        auto numSamples = static_cast<double>(numBlocks) * blockSize;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("quality",       getQualityName(qualityChoice));
+        result->setProperty("blockSize",     blockSize);
+        result->setProperty("latency",       headless.processor.getPitchShiftLatencyInSamples());
+        result->setProperty("nsPerSample",   stats.getTotalNs() / numSamples);
+        result->setProperty("blockLatency",  stats.toVar());
+
+        return juce::var(result);
+    }
+}
+
+juce::var runPitchShiftQualityBenchmark(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+
+    for (auto blockSize : options.blockSizes)
+        for (auto qualityChoice : { 1, 2, 3 })
+            results.add(runPitchShiftQuality(qualityChoice, blockSize, options));
+
+    return results;
+}
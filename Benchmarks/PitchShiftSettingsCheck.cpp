@@ -0,0 +1,98 @@
+#include "Benchmark.h"
+
+// Changes Pitch Shift Quality and Pitch Shift Mode after prepareToPlay, as a user would while the host
+// plays, and checks both take effect: the realtime pitch shifter's latency becomes that of a processor
+// prepared at the new quality, and the latency reported to the host follows the mode there and back.
+//
+// Both are applied by the processor's message thread timer, which has no message loop to run it here,
+// so the pending timers are called between blocks.
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr int initialQuality = 1;   // eco
+    constexpr int changedQuality = 3;   // high
+
+    // Plenty for the timer, the spare stretcher's pre-roll and crossfade, and the worker to wake up
+    constexpr double settleSeconds = 2.0;
+
+    // Processes noise in roughly real time, calling due timers between blocks, until done() holds
+    template <typename Condition>
+    bool runUntil(HeadlessProcessor& headless, int blockSize, juce::Random& random, Condition done)
+    {
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        auto numBlocks = static_cast<int>(settleSeconds * sampleRate / blockSize);
+        auto blockMs = static_cast<int>(std::ceil(1000.0 * blockSize / sampleRate));
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            fillWithNoise(buffer, random, 0.25f);
+            headless.processor.processBlock(buffer, headless.midi);
+
+            juce::Thread::sleep(blockMs);
+            juce::Timer::callPendingTimersSynchronously();
+
+            if (done())
+                return true;
+        }
+
+        return false;
+    }
+
+    int getPreparedPitchShiftLatency(int quality, int blockSize)
+    {
+        HeadlessProcessor headless;
+        headless.setParameter("Pitch Shift Quality", static_cast<float>(quality));
+        headless.prepare(sampleRate, blockSize);
+
+        return headless.processor.getPitchShiftLatencyInSamples();
+    }
+}
+
+juce::var runPitchShiftSettingsCheck(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+    bool passed = true;
+
+    for (auto blockSize : options.blockSizes)
+    {
+        auto expectedQualityLatency = getPreparedPitchShiftLatency(changedQuality, blockSize);
+
+        HeadlessProcessor headless;
+        BenchmarkPreset { true, false, false, false }.apply(headless);
+        headless.setParameter("Pitch Shift Quality", static_cast<float>(initialQuality));
+        headless.setParameter("Pitch Shift Mode", 0.f);
+        headless.prepare(sampleRate, blockSize);
+
+        auto& processor = headless.processor;
+        juce::Random random(1);
+
+        headless.setParameter("Pitch Shift Quality", static_cast<float>(changedQuality));
+        auto qualityApplied = runUntil(headless, blockSize, random, [&] { return processor.getPitchShiftLatencyInSamples() == expectedQualityLatency; });
+
+        headless.setParameter("Pitch Shift Mode", 1.f);
+        auto backgroundReported = runUntil(headless, blockSize, random, [&] { return processor.getLatencySamples() == 2 * blockSize; });
+
+        headless.setParameter("Pitch Shift Mode", 0.f);
+        auto realtimeReported = runUntil(headless, blockSize, random, [&] { return processor.getLatencySamples() == 0; });
+
+        auto runPassed = qualityApplied && backgroundReported && realtimeReported;
+        passed = passed && runPassed;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("blockSize",              blockSize);
+        result->setProperty("expectedQualityLatency", expectedQualityLatency);
+        result->setProperty("pitchShiftLatency",      processor.getPitchShiftLatencyInSamples());
+        result->setProperty("qualityApplied",         qualityApplied);
+        result->setProperty("backgroundReported",     backgroundReported);
+        result->setProperty("realtimeReported",       realtimeReported);
+        result->setProperty("passed",                 runPassed);
+        results.add(juce::var(result));
+    }
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("runs",     results);
+    result->setProperty("passed",   passed);
+
+    return juce::var(result);
+}
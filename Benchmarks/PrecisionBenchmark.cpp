@@ -0,0 +1,250 @@
+#include "Benchmark.h"
+
+// processBlock in single and double precision, on the plain preset and with every stage on. Then the
+// same noise burst into a float and a double processor with 0.99 feedback on a 2.5 s delay through the
+// filters, rendered side by side: their difference is the error the float path accumulates in the loop.
+// Last, the frequency shifter's linear phase Hilbert FIR in float and double on the same double noise:
+// the double quadrature should differ from the float one by float rounding, and almost none of its
+// samples should be exactly representable in float, as they all were while it ran on float copies.
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr double burstSeconds = 0.25;
+    constexpr double driftSeconds = 60.0;
+    constexpr int driftBlockSize = 512;
+    constexpr int hilbertBlockSize = 512;
+    constexpr int hilbertBlocks = 200;
+
+    template <typename SampleType>
+    juce::AudioProcessor::ProcessingPrecision getPrecision()
+    {
+        return std::is_same_v<SampleType, double> ? juce::AudioProcessor::doublePrecision
+                                                  : juce::AudioProcessor::singlePrecision;
+    }
+
+    template <typename SampleType>
+    const char* getPrecisionName()
+    {
+        return std::is_same_v<SampleType, double> ? "double" : "single";
+    }
+
+    template <typename SampleType>
+    juce::var runProcessBlock(const BenchmarkPreset& preset, int blockSize, const BenchmarkOptions& options)
+    {
+        HeadlessProcessor headless;
+        preset.apply(headless);
+        headless.prepare(sampleRate, blockSize, getPrecision<SampleType>());
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> noise(2, blockSize);
+        fillWithNoise(noise, random, 0.25f);
+
+        juce::AudioBuffer<SampleType> input, buffer(2, blockSize);
+        input.makeCopyOf(noise);
+
+        auto warmUpBlocks = juce::jmax(1, static_cast<int>(options.warmUpSeconds * sampleRate / blockSize));
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+
+        for (int block = 0; block < warmUpBlocks; ++block)
+        {
+            buffer.makeCopyOf(input, true);
+            headless.processor.processBlock(buffer, headless.midi);
+        }
+
+        TimingStats stats;
+        stats.reserve(static_cast<size_t>(numBlocks));
+        Stopwatch stopwatch;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            buffer.makeCopyOf(input, true);
+
+            stopwatch.start();
+            headless.processor.processBlock(buffer, headless.midi);
+            stats.add(stopwatch.getElapsedNs());
+        }
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("preset",           preset.getName());
+        result->setProperty("precision",        getPrecisionName<SampleType>());
+        result->setProperty("blockSize",        blockSize);
+        result->setProperty("nsPerFrame",       stats.getTotalNs() / (static_cast<double>(numBlocks) * blockSize));
+        result->setProperty("blockLatency",     stats.toVar());
+
+        return juce::var(result);
+    }
+
+    void applyDriftSettings(HeadlessProcessor& headless)
+    {
+        BenchmarkPreset{ false, false, false, true }.apply(headless);
+
+        headless.setParameter("Delay Time",     2500.f);
+        headless.setParameter("Feedback",       0.99f);
+        headless.setParameter("Dry/Wet Mix",    1.f);
+    }
+
+    juce::var runDrift()
+    {
+        HeadlessProcessor single, reference;
+        applyDriftSettings(single);
+        applyDriftSettings(reference);
+        single.prepare(sampleRate, driftBlockSize, juce::AudioProcessor::singlePrecision);
+        reference.prepare(sampleRate, driftBlockSize, juce::AudioProcessor::doublePrecision);
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> singleBuffer(2, driftBlockSize);
+        juce::AudioBuffer<double> referenceBuffer(2, driftBlockSize);
+
+        auto burstSamples = static_cast<int>(burstSeconds * sampleRate);
+        auto numSamples = static_cast<int>(driftSeconds * sampleRate);
+        auto lastRepeatStart = numSamples - static_cast<int>(2.5 * sampleRate);
+
+        double maxDifference = 0.0;
+        double errorEnergy = 0.0, signalEnergy = 0.0;
+        double lastRepeatErrorEnergy = 0.0, lastRepeatSignalEnergy = 0.0;
+        double singleNs = 0.0, referenceNs = 0.0;
+        Stopwatch stopwatch;
+
+        for (int start = 0; start < numSamples; start += driftBlockSize)
+        {
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                for (int i = 0; i < driftBlockSize; ++i)
+                {
+                    auto sample = start + i < burstSamples ? 0.25f * (2.f * random.nextFloat() - 1.f) : 0.f;
+                    singleBuffer.setSample(channel, i, sample);
+                    referenceBuffer.setSample(channel, i, sample);
+                }
+            }
+
+            stopwatch.start();
+            single.processor.processBlock(singleBuffer, single.midi);
+            singleNs += stopwatch.getElapsedNs();
+
+            stopwatch.start();
+            reference.processor.processBlock(referenceBuffer, reference.midi);
+            referenceNs += stopwatch.getElapsedNs();
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                for (int i = 0; i < driftBlockSize; ++i)
+                {
+                    auto expected = referenceBuffer.getSample(channel, i);
+                    auto error = static_cast<double>(singleBuffer.getSample(channel, i)) - expected;
+
+                    maxDifference = juce::jmax(maxDifference, std::abs(error));
+                    errorEnergy += error * error;
+                    signalEnergy += expected * expected;
+
+                    if (start + i >= lastRepeatStart)
+                    {
+                        lastRepeatErrorEnergy += error * error;
+                        lastRepeatSignalEnergy += expected * expected;
+                    }
+                }
+            }
+        }
+
+        auto toDb = [](double error, double signal)
+        {
+            return signal > 0.0 ? 10.0 * std::log10(juce::jmax(error, 1.0e-30) / signal) : 0.0;
+        };
+
+        auto numFrames = static_cast<double>(numSamples);
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("stage",                     "drift");
+        result->setProperty("seconds",                   driftSeconds);
+        result->setProperty("blockSize",                 driftBlockSize);
+        result->setProperty("maxDifference",             maxDifference);
+        result->setProperty("errorToSignalDb",           toDb(errorEnergy, signalEnergy));
+        result->setProperty("lastRepeatErrorToSignalDb", toDb(lastRepeatErrorEnergy, lastRepeatSignalEnergy));
+        result->setProperty("singleNsPerFrame",          singleNs / numFrames);
+        result->setProperty("doubleNsPerFrame",          referenceNs / numFrames);
+
+        return juce::var(result);
+    }
+
+    template <typename SampleType>
+    void processQuadrature(FrequencyShifter<SampleType>& shifter, const juce::AudioBuffer<double>& input,
+                           juce::AudioBuffer<SampleType>& in, juce::AudioBuffer<SampleType>& outI, juce::AudioBuffer<SampleType>& outQ)
+    {
+        in.makeCopyOf(input, true);
+        shifter.processQuadrature(FrequencyShifter<SampleType>::QuadratureMode::linearPhase, shifter.inPhaseDelay,
+                                  in.getArrayOfWritePointers(), outI, outQ, in.getNumSamples());
+    }
+
+    juce::var runHilbert()
+    {
+        FrequencyShifter<float> single;
+        FrequencyShifter<double> reference;
+        single.prepare(static_cast<int>(sampleRate), hilbertBlockSize);
+        reference.prepare(static_cast<int>(sampleRate), hilbertBlockSize);
+
+        juce::Random random(1);
+        juce::AudioBuffer<double> input(2, hilbertBlockSize);
+        juce::AudioBuffer<float> singleIn(2, hilbertBlockSize), singleI(2, hilbertBlockSize), singleQ(2, hilbertBlockSize);
+        juce::AudioBuffer<double> referenceIn(2, hilbertBlockSize), referenceI(2, hilbertBlockSize), referenceQ(2, hilbertBlockSize);
+
+        double errorEnergy = 0.0, signalEnergy = 0.0;
+        int numRepresentable = 0, numCompared = 0;
+
+        for (int block = 0; block < hilbertBlocks; ++block)
+        {
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < hilbertBlockSize; ++i)
+                    input.setSample(channel, i, 0.5 * (2.0 * random.nextDouble() - 1.0));
+
+            processQuadrature(single, input, singleIn, singleI, singleQ);
+            processQuadrature(reference, input, referenceIn, referenceI, referenceQ);
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                for (int i = 0; i < hilbertBlockSize; ++i)
+                {
+                    auto expected = referenceQ.getSample(channel, i);
+                    auto error = static_cast<double>(singleQ.getSample(channel, i)) - expected;
+
+                    errorEnergy += error * error;
+                    signalEnergy += expected * expected;
+
+                    if (expected != 0.0)
+                    {
+                        numRepresentable += static_cast<double>(static_cast<float>(expected)) == expected ? 1 : 0;
+                        ++numCompared;
+                    }
+                }
+            }
+        }
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("stage",                        "hilbert");
+        result->setProperty("blockSize",                    hilbertBlockSize);
+        result->setProperty("errorToSignalDb",              signalEnergy > 0.0 ? 10.0 * std::log10(juce::jmax(errorEnergy, 1.0e-30) / signalEnergy) : 0.0);
+        result->setProperty("floatRepresentableFraction",   numCompared > 0 ? static_cast<double>(numRepresentable) / numCompared : 0.0);
+
+        return juce::var(result);
+    }
+}
+
+juce::var runPrecisionBenchmark(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+
+    const BenchmarkPreset presets[] = { { false, false, false, false }, { true, true, true, true } };
+
+    for (auto blockSize : options.blockSizes)
+    {
+        for (const auto& preset : presets)
+        {
+            results.add(runProcessBlock<float>(preset, blockSize, options));
+            results.add(runProcessBlock<double>(preset, blockSize, options));
+        }
+    }
+
+    results.add(runDrift());
+    results.add(runHilbert());
+
+    return results;
+}
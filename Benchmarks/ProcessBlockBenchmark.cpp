@@ -0,0 +1,76 @@
+#include "Benchmark.h"
+
+namespace
+{
+    juce::var runConfiguration(double sampleRate, int blockSize, const BenchmarkPreset& preset, const BenchmarkOptions& options)
+    {
+        HeadlessProcessor headless;
+        preset.apply(headless);
+        headless.prepare(sampleRate, blockSize);
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> input(2, blockSize);
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        fillWithNoise(input, random, 0.25f);
+
+        auto warmUpBlocks = juce::jmax(1, static_cast<int>(options.warmUpSeconds * sampleRate / blockSize));
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+
+        for (int block = 0; block < warmUpBlocks; ++block)
+        {
+            buffer.makeCopyOf(input, true);
+            headless.processor.processBlock(buffer, headless.midi);
+        }
+
+       #if STRANGE_ECHOES_PROFILING
+        headless.processor.getProfiler().requestReset();
+       #endif
+
+        TimingStats stats;
+        stats.reserve(static_cast<size_t>(numBlocks));
+        Stopwatch stopwatch;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            buffer.makeCopyOf(input, true);
+
+            stopwatch.start();
+            headless.processor.processBlock(buffer, headless.midi);
+            stats.add(stopwatch.getElapsedNs());
+        }
+
+        auto totalNs = stats.getTotalNs();
+        auto numSamples = static_cast<double>(numBlocks) * blockSize;
+        auto audioNs = numSamples / sampleRate * 1.0e9;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("preset",        preset.getName());
+        result->setProperty("sampleRate",    sampleRate);
+        result->setProperty("blockSize",     blockSize);
+        result->setProperty("subBlockSize",  headless.processor.getSubBlockSize());
+        result->setProperty("nsPerSample",   totalNs / numSamples);
+        // Fraction of real time spent processing, 1.0 means the instance uses a whole core
+        result->setProperty("realTimeFactor", totalNs / audioNs);
+        result->setProperty("deadlineUs",    blockSize / sampleRate * 1.0e6);
+        result->setProperty("blockLatency",  stats.toVar());
+
+        auto stageTimings = getStageTimings(headless.processor);
+
+        if (! stageTimings.isVoid())
+            result->setProperty("stages", stageTimings);
+
+        return juce::var(result);
+    }
+}
+
+juce::var runProcessBlockBenchmark(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+
+    for (auto sampleRate : options.sampleRates)
+        for (auto blockSize : options.blockSizes)
+            for (const auto& preset : BenchmarkPreset::getAll())
+                results.add(runConfiguration(sampleRate, blockSize, preset, options));
+
+    return results;
+}
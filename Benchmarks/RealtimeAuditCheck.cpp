@@ -0,0 +1,110 @@
+#include "Benchmark.h"
+#include <mutex>
+
+// Runs the preset matrix through processBlock with the realtime audit hooks active and
+// reports every configuration in which the audio thread allocated, freed or locked.
+// Halfway through each run the preset is switched, so parameter transitions are covered too.
+// The matrix runs with the trap on, after a self-test that the hooks see a deliberate allocation
+// and lock, keep the first violation and trap once per section.
+
+#if STRANGE_ECHOES_RT_AUDIT
+namespace
+{
+    bool runSelfTest()
+    {
+        RealtimeAudit::resetReport();
+
+        {
+            STRANGE_ECHOES_REALTIME_SECTION;
+
+            // Called directly, as a new-expression and its delete may be elided
+            auto* p = ::operator new(64);
+            ::operator delete(p);
+
+            std::mutex mutex;
+            const std::lock_guard<std::mutex> lock(mutex);
+        }
+
+        auto report = RealtimeAudit::getReport();
+
+        return report.allocations == 1 && report.deallocations == 1 && report.locks == 1
+            && report.firstViolation == RealtimeAudit::Violation::allocation
+            && report.traps == 1;
+    }
+}
+#endif
+
+juce::var runRealtimeAuditCheck(const BenchmarkOptions& options)
+{
+    auto* result = new juce::DynamicObject();
+
+   #if STRANGE_ECHOES_RT_AUDIT
+    RealtimeAudit::setTrapOnViolation(true);
+
+    auto selfTestPassed = runSelfTest();
+    auto selfTestReport = RealtimeAudit::getReport();
+
+    juce::Array<juce::var> failures;
+    int numConfigurations = 0;
+    auto presets = BenchmarkPreset::getAll();
+
+    for (auto sampleRate : options.sampleRates)
+    {
+        for (auto blockSize : options.blockSizes)
+        {
+            for (int i = 0; i < presets.size(); ++i)
+            {
+                const auto& preset = presets.getReference(i);
+                const auto& nextPreset = presets.getReference((i + 1) % presets.size());
+
+                HeadlessProcessor headless;
+                preset.apply(headless);
+                headless.prepare(sampleRate, blockSize);
+
+                juce::Random random(1);
+                juce::AudioBuffer<float> buffer(2, blockSize);
+                auto numBlocks = juce::jmax(2, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+
+                RealtimeAudit::resetReport();
+
+                for (int block = 0; block < numBlocks; ++block)
+                {
+                    if (block == numBlocks / 2)
+                        nextPreset.apply(headless);
+
+                    fillWithNoise(buffer, random, 0.25f);
+                    headless.processor.processBlock(buffer, headless.midi);
+                }
+
+                auto report = RealtimeAudit::getReport();
+                ++numConfigurations;
+
+                if (! report.isClean())
+                {
+                    auto* failure = new juce::DynamicObject();
+                    failure->setProperty("preset",        preset.getName() + " -> " + nextPreset.getName());
+                    failure->setProperty("sampleRate",    sampleRate);
+                    failure->setProperty("blockSize",     blockSize);
+                    failure->setProperty("allocations",   static_cast<juce::int64>(report.allocations));
+                    failure->setProperty("deallocations", static_cast<juce::int64>(report.deallocations));
+                    failure->setProperty("locks",         static_cast<juce::int64>(report.locks));
+                    failure->setProperty("first",         RealtimeAudit::getViolationName(report.firstViolation));
+                    failures.add(juce::var(failure));
+                }
+            }
+        }
+    }
+
+    RealtimeAudit::setTrapOnViolation(false);
+
+    result->setProperty("selfTest",       selfTestReport.toString() + ", traps: " + juce::String(selfTestReport.traps));
+    result->setProperty("configurations", numConfigurations);
+    result->setProperty("failures",       failures);
+    result->setProperty("passed",         selfTestPassed && failures.isEmpty());
+   #else
+    juce::ignoreUnused(options);
+    result->setProperty("skipped", "built without STRANGE_ECHOES_RT_AUDIT");
+   #endif
+
+    return juce::var(result);
+}
@@ -0,0 +1,69 @@
+#include "Benchmark.h"
+
+// Cost of the feedback saturation at each oversampling factor, stereo noise driven 12 dB into the
+// shaper, with the latency each factor adds to the loop.
+
+namespace
+{
+    const char* getOversamplingName(Saturator::Oversampling oversampling)
+    {
+        switch (oversampling)
+        {
+            case Saturator::Oversampling::none:         return "1x";
+            case Saturator::Oversampling::twoTimes:     return "2x";
+            case Saturator::Oversampling::fourTimes:    return "4x";
+        }
+
+        return "";
+    }
+
+    juce::var run(Saturator::Oversampling oversampling, int blockSize, const BenchmarkOptions& options)
+    {
+        constexpr double sampleRate = 48000.0;
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+        auto drive = juce::Decibels::decibelsToGain(12.f);
+
+        Saturator saturator;
+        saturator.prepare(2, sampleRate, blockSize);
+        saturator.setOversampling(oversampling);
+        saturator.setEnabled(true);
+        saturator.reset();
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> buffer(2, blockSize);
+
+        TimingStats stats;
+        Stopwatch stopwatch;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            fillWithNoise(buffer, random, 0.5f);
+
+            stopwatch.start();
+            saturator.process(buffer.getArrayOfWritePointers(), 2, blockSize, drive, drive);
+            stats.add(stopwatch.getElapsedNs());
+        }
+
+        auto numFrames = static_cast<double>(numBlocks) * blockSize;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("oversampling",     getOversamplingName(oversampling));
+        result->setProperty("blockSize",        blockSize);
+        result->setProperty("latency",          saturator.getLatencyInSamples());
+        result->setProperty("nsPerFrame",       stats.getTotalNs() / numFrames);
+        result->setProperty("blockLatency",     stats.toVar());
+
+        return juce::var(result);
+    }
+}
+
+juce::var runSaturationBenchmark(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+
+    for (auto oversampling : { Saturator::Oversampling::none, Saturator::Oversampling::twoTimes, Saturator::Oversampling::fourTimes })
+        for (auto blockSize : options.blockSizes)
+            results.add(run(oversampling, blockSize, options));
+
+    return results;
+}
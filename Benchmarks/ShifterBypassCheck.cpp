@@ -0,0 +1,100 @@
+#include "Benchmark.h"
+
+// Runs two frequency shifters on the same noise, each mode and a range of sideband mixes, in float
+// and double. Both start at 0 Hz or 100 Hz and are then set to 0 Hz; one goes into its bypass once the
+// oscillators have settled and the other is held engaged. Their outputs must match throughout.
+
+namespace
+{
+    constexpr int sampleRate = 48000;
+    constexpr int blockSize = 256;
+    constexpr int numBlocks = 60;
+    constexpr int zeroHzBlock = 10;
+
+    // Rounding of the per-sample mix against the bypass's two multiplies
+    constexpr double tolerance = 1.0e-6;
+
+    template <typename SampleType>
+    double runShifters(typename FrequencyShifter<SampleType>::QuadratureMode mode, float sideBandMix, float startFrequency)
+    {
+        FrequencyShifter<SampleType> bypassed, engaged;
+
+        for (auto* shifter : { &bypassed, &engaged })
+        {
+            shifter->setQuadratureMode(mode);
+            shifter->prepare(sampleRate, blockSize);
+            shifter->configure(startFrequency, sideBandMix);
+        }
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> noise(2, blockSize);
+        juce::AudioBuffer<SampleType> bypassedBuffer(2, blockSize), engagedBuffer(2, blockSize);
+        double maxError = 0.0;
+
+        for (int block = 0; block < numBlocks; ++block)
+        {
+            if (block == zeroHzBlock)
+            {
+                bypassed.configure(0.f, sideBandMix);
+                engaged.configure(0.f, sideBandMix);
+            }
+
+            // Held short of 1, so process() never takes the bypass
+            if (block >= zeroHzBlock)
+                engaged.bypassTimer.setCurrentAndTargetValue(0.f);
+
+            fillWithNoise(noise, random, 0.5f);
+            bypassedBuffer.makeCopyOf(noise, true);
+            engagedBuffer.makeCopyOf(noise, true);
+
+            bypassed.process(bypassedBuffer.getArrayOfWritePointers(), blockSize);
+            engaged.process(engagedBuffer.getArrayOfWritePointers(), blockSize);
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < blockSize; ++i)
+                    maxError = juce::jmax(maxError, static_cast<double>(std::abs(bypassedBuffer.getSample(channel, i) - engagedBuffer.getSample(channel, i))));
+        }
+
+        return maxError;
+    }
+}
+
+juce::var runShifterBypassCheck(const BenchmarkOptions& options)
+{
+    juce::ignoreUnused(options);
+
+    juce::Array<juce::var> failures;
+    double maxError = 0.0;
+
+    for (int mode = 0; mode < 3; ++mode)
+    {
+        for (auto sideBandMix : { 0.f, 0.25f, 0.5f, 1.f })
+        {
+            for (auto startFrequency : { 0.f, 100.f })
+            {
+                auto singleError = runShifters<float>(static_cast<FrequencyShifter<float>::QuadratureMode>(mode), sideBandMix, startFrequency);
+                auto doubleError = runShifters<double>(static_cast<FrequencyShifter<double>::QuadratureMode>(mode), sideBandMix, startFrequency);
+                maxError = juce::jmax(maxError, singleError, doubleError);
+
+                if (singleError > tolerance || doubleError > tolerance)
+                {
+                    auto* failure = new juce::DynamicObject();
+                    failure->setProperty("mode",            mode);
+                    failure->setProperty("sideBandMix",     sideBandMix);
+                    failure->setProperty("startFrequency",  startFrequency);
+                    failure->setProperty("singleError",     singleError);
+                    failure->setProperty("doubleError",     doubleError);
+                    failures.add(juce::var(failure));
+                }
+            }
+        }
+    }
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("maxAbsError",  maxError);
+    result->setProperty("tolerance",    tolerance);
+    result->setProperty("failures",     failures);
+    result->setProperty("passed",       failures.isEmpty());
+
+    return juce::var(result);
+}
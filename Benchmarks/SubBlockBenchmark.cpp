@@ -0,0 +1,62 @@
+#include "Benchmark.h"
+
+// processBlock cost with settings applied once per host block (sub-block size 0) against fixed
+// sub-block sizes, all stages on and the dry/wet mix automated every block so the ramps are live.
+
+namespace
+{
+    juce::var runSubBlockSize(int blockSize, int subBlockSize, const BenchmarkOptions& options)
+    {
+        constexpr double sampleRate = 48000.0;
+
+        HeadlessProcessor headless;
+        BenchmarkPreset { true, true, true, true }.apply(headless);
+        headless.processor.setSubBlockSize(subBlockSize);
+        headless.prepare(sampleRate, blockSize);
+
+        juce::Random random(1);
+        juce::AudioBuffer<float> input(2, blockSize);
+        juce::AudioBuffer<float> buffer(2, blockSize);
+        fillWithNoise(input, random, 0.25f);
+
+        auto warmUpBlocks = juce::jmax(1, static_cast<int>(options.warmUpSeconds * sampleRate / blockSize));
+        auto numBlocks = juce::jmax(1, static_cast<int>(options.secondsPerRun * sampleRate / blockSize));
+
+        TimingStats stats;
+        stats.reserve(static_cast<size_t>(numBlocks));
+        Stopwatch stopwatch;
+
+        for (int block = 0; block < warmUpBlocks + numBlocks; ++block)
+        {
+            headless.setParameter("Dry/Wet Mix", block % 2 == 0 ? 0.3f : 0.7f);
+            buffer.makeCopyOf(input, true);
+
+            stopwatch.start();
+            headless.processor.processBlock(buffer, headless.midi);
+
+            if (block >= warmUpBlocks)
+                stats.add(stopwatch.getElapsedNs());
+        }
+
+        auto numSamples = static_cast<double>(numBlocks) * blockSize;
+
+        auto* result = new juce::DynamicObject();
+        result->setProperty("blockSize",     blockSize);
+        result->setProperty("subBlockSize",  subBlockSize);
+        result->setProperty("nsPerSample",   stats.getTotalNs() / numSamples);
+        result->setProperty("blockLatency",  stats.toVar());
+
+        return juce::var(result);
+    }
+}
+
+juce::var runSubBlockBenchmark(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+
+    for (auto blockSize : options.blockSizes)
+        for (auto subBlockSize : { 0, 16, 32, 64, 128 })
+            results.add(runSubBlockSize(blockSize, subBlockSize, options));
+
+    return results;
+}
@@ -0,0 +1,148 @@
+#include "Benchmark.h"
+
+// Plays a burst of noise into each preset followed by silence, then the same burst again, and checks:
+//  - the tail reported to the host covers everything above the silence threshold after the first burst
+//  - processBlock has gone idle before the second burst
+//  - the second burst wakes it up in its first block and, where the wet chain has no free-running
+//    state (LFO, pitch shifter, frequency shifter oscillator), renders like the first one
+//  - after idling again and lengthening the delay while idle, a short third burst brings back nothing
+//    of the earlier bursts: the echoes read from before the wake-up must be silent
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr double burstSeconds = 0.25;
+    constexpr float wakeTolerance = 1.0e-3f;
+    constexpr double ghostBurstSeconds = 0.05;
+
+    // The delay time ramps up from 300 ms over 0.5 s after waking, so for this long every echo is
+    // read from before the wake-up
+    constexpr double ghostCheckSeconds = 2.0;
+
+    struct Render
+    {
+        int firstIdleSample{-1};
+        bool idleAfterFirstBlock{false};
+    };
+
+    // numSamples of output for noise during the first burstSamples and silence after
+    Render render(HeadlessProcessor& headless, juce::AudioBuffer<float>& output, int burstSamples, int blockSize)
+    {
+        juce::Random random(1);
+        juce::AudioBuffer<float> block(2, blockSize);
+        Render result;
+
+        for (int start = 0; start < output.getNumSamples(); start += blockSize)
+        {
+            auto num = juce::jmin(blockSize, output.getNumSamples() - start);
+            block.setSize(2, num, false, false, true);
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = 0; i < num; ++i)
+                    block.setSample(channel, i, start + i < burstSamples ? 0.25f * (2.f * random.nextFloat() - 1.f) : 0.f);
+
+            headless.processor.processBlock(block, headless.midi);
+
+            for (int channel = 0; channel < 2; ++channel)
+                output.copyFrom(channel, start, block, channel, 0, num);
+
+            if (start == 0)
+                result.idleAfterFirstBlock = headless.processor.isIdle();
+
+            if (result.firstIdleSample < 0 && headless.processor.isIdle())
+                result.firstIdleSample = start;
+        }
+
+        return result;
+    }
+}
+
+juce::var runTailCheck(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+    bool passed = true;
+
+    for (auto blockSize : options.blockSizes)
+    {
+        for (const auto& preset : BenchmarkPreset::getAll())
+        {
+            HeadlessProcessor headless;
+            preset.apply(headless);
+            headless.prepare(sampleRate, blockSize);
+
+            auto tailSeconds = headless.processor.getTailLengthSeconds();
+            auto burstSamples = static_cast<int>(burstSeconds * sampleRate);
+
+            // Long enough for the tail, then for idling to set in after the longest possible delay
+            juce::AudioBuffer<float> first(2, burstSamples + static_cast<int>((tailSeconds + 3.5) * sampleRate));
+            auto firstRender = render(headless, first, burstSamples, blockSize);
+
+            int lastAudible = burstSamples;
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = burstSamples; i < first.getNumSamples(); ++i)
+                    if (std::abs(first.getSample(channel, i)) >= IdleDetector::silenceThreshold)
+                        lastAudible = juce::jmax(lastAudible, i);
+
+            auto audibleTailSeconds = (lastAudible - burstSamples) / sampleRate;
+            auto wasIdle = headless.processor.isIdle();
+
+            juce::AudioBuffer<float> second(2, burstSamples + static_cast<int>(0.5 * sampleRate));
+            auto secondRender = render(headless, second, burstSamples, blockSize);
+
+            // Idle again, then lengthened to reach back past what was there when it went idle
+            juce::AudioBuffer<float> settle(2, static_cast<int>((tailSeconds + 3.5) * sampleRate));
+            render(headless, settle, 0, blockSize);
+            auto idleBeforeDelayChange = headless.processor.isIdle();
+            headless.setParameter("Delay Time", 2500.f);
+
+            auto ghostBurstSamples = static_cast<int>(ghostBurstSeconds * sampleRate);
+            juce::AudioBuffer<float> third(2, static_cast<int>(ghostCheckSeconds * sampleRate));
+            render(headless, third, ghostBurstSamples, blockSize);
+
+            float ghostLevel = 0.f;
+
+            for (int channel = 0; channel < 2; ++channel)
+                for (int i = ghostBurstSamples; i < third.getNumSamples(); ++i)
+                    ghostLevel = juce::jmax(ghostLevel, std::abs(third.getSample(channel, i)));
+
+            float wakeDifference = 0.f;
+            auto deterministic = ! (preset.lfo || preset.pitchShift || preset.freqShift);
+
+            if (deterministic)
+                for (int channel = 0; channel < 2; ++channel)
+                    for (int i = 0; i < second.getNumSamples(); ++i)
+                        wakeDifference = juce::jmax(wakeDifference, std::abs(second.getSample(channel, i) - first.getSample(channel, i)));
+
+            auto presetPassed = audibleTailSeconds <= tailSeconds
+                             && wasIdle
+                             && ! secondRender.idleAfterFirstBlock
+                             && wakeDifference <= wakeTolerance
+                             && idleBeforeDelayChange
+                             && ghostLevel < IdleDetector::silenceThreshold;
+
+            passed = passed && presetPassed;
+
+            auto* result = new juce::DynamicObject();
+            result->setProperty("preset",             preset.getName());
+            result->setProperty("blockSize",          blockSize);
+            result->setProperty("tailSeconds",        tailSeconds);
+            result->setProperty("audibleTailSeconds", audibleTailSeconds);
+            result->setProperty("idleAfterSeconds",   firstRender.firstIdleSample >= 0 ? (firstRender.firstIdleSample - burstSamples) / sampleRate : -1.0);
+            result->setProperty("wokeUp",             ! secondRender.idleAfterFirstBlock);
+            result->setProperty("ghostLevel",         ghostLevel);
+
+            if (deterministic)
+                result->setProperty("wakeDifference", wakeDifference);
+
+            result->setProperty("passed",             presetPassed);
+            results.add(juce::var(result));
+        }
+    }
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("presets", results);
+    result->setProperty("passed",  passed);
+
+    return juce::var(result);
+}
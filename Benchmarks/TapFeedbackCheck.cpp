@@ -0,0 +1,109 @@
+#include "Benchmark.h"
+
+// Turns all eight taps up to their maximum feedback send on short delays, with the main feedback off,
+// halfway and at its maximum, in float and double. Plays a burst of noise followed by silence and
+// checks the output stays finite and has decayed by the end, rather than building up.
+
+namespace
+{
+    constexpr double sampleRate = 48000.0;
+    constexpr double burstSeconds = 0.5;
+    constexpr double renderSeconds = 10.0;
+
+    struct Render
+    {
+        bool finite{true};
+        float burstPeak{0.f};
+        float endPeak{0.f};
+    };
+
+    template <typename SampleType>
+    Render render(HeadlessProcessor& headless, int blockSize)
+    {
+        juce::Random random(1);
+        juce::AudioBuffer<float> noise(2, blockSize);
+        juce::AudioBuffer<SampleType> block(2, blockSize);
+        Render result;
+
+        auto burstSamples = static_cast<int>(burstSeconds * sampleRate);
+        auto totalSamples = static_cast<int>(renderSeconds * sampleRate);
+        auto endStart = totalSamples - static_cast<int>(sampleRate);
+
+        for (int start = 0; start < totalSamples; start += blockSize)
+        {
+            fillWithNoise(noise, random, start < burstSamples ? 0.25f : 0.f);
+            block.makeCopyOf(noise, true);
+
+            headless.processor.processBlock(block, headless.midi);
+
+            for (int channel = 0; channel < 2; ++channel)
+            {
+                for (int i = 0; i < blockSize; ++i)
+                {
+                    auto sample = static_cast<float>(block.getSample(channel, i));
+                    result.finite = result.finite && std::isfinite(sample);
+
+                    if (start < burstSamples)
+                        result.burstPeak = juce::jmax(result.burstPeak, std::abs(sample));
+                    else if (start >= endStart)
+                        result.endPeak = juce::jmax(result.endPeak, std::abs(sample));
+                }
+            }
+        }
+
+        return result;
+    }
+}
+
+juce::var runTapFeedbackCheck(const BenchmarkOptions& options)
+{
+    juce::Array<juce::var> results;
+    bool passed = true;
+
+    for (auto blockSize : options.blockSizes)
+    {
+        for (auto feedback : { 0.f, 0.5f, 0.99f })
+        {
+            for (auto precision : { juce::AudioProcessor::singlePrecision, juce::AudioProcessor::doublePrecision })
+            {
+                HeadlessProcessor headless;
+                headless.setParameter("Delay Time",     40.f);
+                headless.setParameter("Feedback",       feedback);
+                headless.setParameter("Dry/Wet Mix",    1.f);
+                headless.setParameter("Taps",           static_cast<float>(maxDelayTaps));
+
+                for (int k = 0; k < maxDelayTaps; ++k)
+                {
+                    auto tapName = "Tap " + juce::String(k + 1);
+                    headless.setParameter(tapName + " Time",        5.f * static_cast<float>(k + 1));
+                    headless.setParameter(tapName + " Gain",        1.f);
+                    headless.setParameter(tapName + " Feedback",    0.99f);
+                }
+
+                headless.prepare(sampleRate, blockSize, precision);
+
+                auto run = precision == juce::AudioProcessor::doublePrecision ? render<double>(headless, blockSize)
+                                                                              : render<float>(headless, blockSize);
+
+                auto runPassed = run.finite && run.endPeak < run.burstPeak;
+                passed = passed && runPassed;
+
+                auto* result = new juce::DynamicObject();
+                result->setProperty("blockSize",    blockSize);
+                result->setProperty("feedback",     feedback);
+                result->setProperty("precision",    precision == juce::AudioProcessor::doublePrecision ? "double" : "single");
+                result->setProperty("finite",       run.finite);
+                result->setProperty("burstPeak",    run.burstPeak);
+                result->setProperty("endPeak",      run.endPeak);
+                result->setProperty("passed",       runPassed);
+                results.add(juce::var(result));
+            }
+        }
+    }
+
+    auto* result = new juce::DynamicObject();
+    result->setProperty("runs",     results);
+    result->setProperty("passed",   passed);
+
+    return juce::var(result);
+}
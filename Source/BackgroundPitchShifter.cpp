@@ -0,0 +1,267 @@
+#include "BackgroundPitchShifter.h"
+
+BackgroundPitchShifter::BackgroundPitchShifter()
+    : juce::Thread("Pitch Shifter")
+{
+}
+
+BackgroundPitchShifter::~BackgroundPitchShifter()
+{
+    stop();
+}
+
+void BackgroundPitchShifter::prepare(int newNumChannels, double sampleRate, int maximumBlockSize, int latencyInSamples, PitchShiftQuality quality)
+{
+    jassert(newNumChannels > 0 && maximumBlockSize > 0 && latencyInSamples >= maximumBlockSize);
+
+    stop();
+
+    this->numChannels = newNumChannels;
+    this->maxBlockSize = maximumBlockSize;
+    this->latency = latencyInSamples;
+
+    // The worker gets one block period to produce each block, so it may start at most a quarter late
+    this->pollIntervalMs = 250.0 * maximumBlockSize / sampleRate;
+
+    // The input holds at most what the worker is behind by, the output at most the latency plus
+    // the block just pushed. AbstractFifo keeps one slot free.
+    auto fifoSize = latencyInSamples + 2 * maximumBlockSize + 1;
+
+    this->inputFifo.setTotalSize(fifoSize);
+    this->outputFifo.setTotalSize(fifoSize);
+    this->inputRing.setSize(newNumChannels, fifoSize);
+    this->outputRing.setSize(newNumChannels, fifoSize);
+
+    this->shifter.prepare(newNumChannels, sampleRate, maximumBlockSize, quality);
+
+    this->workerInput.setSize(newNumChannels, maximumBlockSize);
+    this->workerOutput.setSize(newNumChannels, maximumBlockSize);
+
+    this->inputFifo.reset();
+    this->outputFifo.reset();
+    this->inputRing.clear();
+    this->outputRing.clear();
+
+    this->flushRequested.store(false);
+    this->awaitingFlush = false;
+    this->outputOffset = -latencyInSamples;
+    this->underruns.store(0);
+}
+
+void BackgroundPitchShifter::start()
+{
+    this->workerTransposeSemitones = this->transposeSemitones.load();
+    this->shifter.setTransposeSemitones(this->workerTransposeSemitones);
+    this->shifter.reset();
+
+    startThread(juce::Thread::Priority::highest);
+}
+
+void BackgroundPitchShifter::stop()
+{
+    stopThread(1000);
+    this->workerAwake.store(false);
+}
+
+void BackgroundPitchShifter::setActive(bool shouldBeActive)
+{
+    if (this->activeRequested.exchange(shouldBeActive, std::memory_order_acq_rel) == shouldBeActive)
+        return;
+
+    // A signal sent before the worker waits is kept until it does
+    if (shouldBeActive)
+        notify();
+}
+
+bool BackgroundPitchShifter::isActive() const
+{
+    return this->activeRequested.load(std::memory_order_acquire) && this->workerAwake.load(std::memory_order_acquire);
+}
+
+void BackgroundPitchShifter::setTransposeSemitones(float semitones)
+{
+    this->transposeSemitones.store(semitones, std::memory_order_relaxed);
+}
+
+void BackgroundPitchShifter::setQuality(PitchShiftQuality newQuality)
+{
+    this->shifter.setQuality(newQuality);
+}
+
+void BackgroundPitchShifter::reset()
+{
+    this->flushRequested.store(true, std::memory_order_release);
+    this->awaitingFlush = true;
+}
+
+void BackgroundPitchShifter::process(const float* const* in, float* const* out, int numSamples)
+{
+    if (this->awaitingFlush)
+    {
+        if (this->flushRequested.load(std::memory_order_acquire))
+        {
+            for (int channel = 0; channel < this->numChannels; ++channel)
+                juce::FloatVectorOperations::clear(out[channel], numSamples);
+
+            return;
+        }
+
+        // Everything the worker wrote before the flush is stale
+        this->outputFifo.finishedRead(this->outputFifo.getNumReady());
+        this->outputOffset = -this->latency;
+        this->awaitingFlush = false;
+    }
+
+    if (this->inputFifo.getFreeSpace() < numSamples)
+    {
+        // The worker is hopelessly behind: start over rather than lose track of which output belongs where
+        for (int channel = 0; channel < this->numChannels; ++channel)
+            juce::FloatVectorOperations::clear(out[channel], numSamples);
+
+        this->underruns.store(this->underruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        reset();
+        return;
+    }
+
+    pushInput(in, numSamples);
+
+    if (this->outputOffset > 0)
+    {
+        auto numToSkip = juce::jmin(this->outputOffset, this->outputFifo.getNumReady());
+        this->outputFifo.finishedRead(numToSkip);
+        this->outputOffset -= numToSkip;
+    }
+
+    int numDone = 0;
+
+    if (this->outputOffset < 0)
+    {
+        numDone = juce::jmin(-this->outputOffset, numSamples);
+
+        for (int channel = 0; channel < this->numChannels; ++channel)
+            juce::FloatVectorOperations::clear(out[channel], numDone);
+
+        this->outputOffset += numDone;
+    }
+
+    if (this->outputOffset == 0)
+        numDone += pullOutput(out, numDone, numSamples - numDone);
+
+    if (numDone < numSamples)
+    {
+        // Underrun: fill with silence and skip the late samples when they turn up
+        for (int channel = 0; channel < this->numChannels; ++channel)
+            juce::FloatVectorOperations::clear(out[channel] + numDone, numSamples - numDone);
+
+        this->outputOffset += numSamples - numDone;
+        this->underruns.store(this->underruns.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+}
+
+void BackgroundPitchShifter::pushInput(const float* const* in, int numSamples)
+{
+    int start1, size1, start2, size2;
+    this->inputFifo.prepareToWrite(numSamples, start1, size1, start2, size2);
+
+    for (int channel = 0; channel < this->numChannels; ++channel)
+    {
+        if (size1 > 0)
+            this->inputRing.copyFrom(channel, start1, in[channel], size1);
+
+        if (size2 > 0)
+            this->inputRing.copyFrom(channel, start2, in[channel] + size1, size2);
+    }
+
+    this->inputFifo.finishedWrite(size1 + size2);
+}
+
+int BackgroundPitchShifter::pullOutput(float* const* out, int startSample, int numSamples)
+{
+    int start1, size1, start2, size2;
+    this->outputFifo.prepareToRead(numSamples, start1, size1, start2, size2);
+
+    for (int channel = 0; channel < this->numChannels; ++channel)
+    {
+        if (size1 > 0)
+            juce::FloatVectorOperations::copy(out[channel] + startSample, this->outputRing.getReadPointer(channel, start1), size1);
+
+        if (size2 > 0)
+            juce::FloatVectorOperations::copy(out[channel] + startSample + size1, this->outputRing.getReadPointer(channel, start2), size2);
+    }
+
+    this->outputFifo.finishedRead(size1 + size2);
+    return size1 + size2;
+}
+
+void BackgroundPitchShifter::run()
+{
+    while (! threadShouldExit())
+    {
+        if (! this->activeRequested.load(std::memory_order_acquire))
+        {
+            // Woken by setActive(true), or by stopThread()
+            this->workerAwake.store(false, std::memory_order_release);
+            wait(-1);
+            continue;
+        }
+
+        this->workerAwake.store(true, std::memory_order_release);
+
+        if (this->flushRequested.load(std::memory_order_acquire))
+        {
+            // The audio thread stops pushing until the flag is cleared
+            this->shifter.reset();
+            this->inputFifo.finishedRead(this->inputFifo.getNumReady());
+            this->flushRequested.store(false, std::memory_order_release);
+        }
+
+        // Retried on every pass while a previous swap is still crossfading
+        this->shifter.updateConfiguration();
+
+        auto numToProcess = juce::jmin(this->inputFifo.getNumReady(), this->outputFifo.getFreeSpace(), this->maxBlockSize);
+
+        if (numToProcess == 0)
+        {
+            // Nothing signals new input, see the class comment
+            wait(this->pollIntervalMs);
+            continue;
+        }
+
+        auto semitones = this->transposeSemitones.load(std::memory_order_relaxed);
+
+        if (semitones != this->workerTransposeSemitones)
+        {
+            this->shifter.setTransposeSemitones(semitones);
+            this->workerTransposeSemitones = semitones;
+        }
+
+        int start1, size1, start2, size2;
+        this->inputFifo.prepareToRead(numToProcess, start1, size1, start2, size2);
+
+        for (int channel = 0; channel < this->numChannels; ++channel)
+        {
+            if (size1 > 0)
+                this->workerInput.copyFrom(channel, 0, this->inputRing, channel, start1, size1);
+
+            if (size2 > 0)
+                this->workerInput.copyFrom(channel, size1, this->inputRing, channel, start2, size2);
+        }
+
+        this->inputFifo.finishedRead(numToProcess);
+
+        this->shifter.process(this->workerInput.getArrayOfReadPointers(), this->workerOutput.getArrayOfWritePointers(), numToProcess);
+
+        this->outputFifo.prepareToWrite(numToProcess, start1, size1, start2, size2);
+
+        for (int channel = 0; channel < this->numChannels; ++channel)
+        {
+            if (size1 > 0)
+                this->outputRing.copyFrom(channel, start1, this->workerOutput, channel, 0, size1);
+
+            if (size2 > 0)
+                this->outputRing.copyFrom(channel, start2, this->workerOutput, channel, size1, size2);
+        }
+
+        this->outputFifo.finishedWrite(numToProcess);
+    }
+}
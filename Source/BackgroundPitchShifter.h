@@ -0,0 +1,91 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <atomic>
+#include "CrossfadingPitchShifter.h"
+
+// CrossfadingPitchShifter running on a worker thread. The audio thread pushes its input into one
+// lock-free single producer/single consumer FIFO (juce::AbstractFifo) and pulls the output from
+// another, so the only work left on the audio callback is copying.
+//
+// The audio thread never signals the worker, which would take the thread event's mutex: it only
+// publishes through the FIFOs and atomic flags, and the worker polls them, sleeping for a quarter
+// of a block period whenever it has caught up. The worker only polls while setActive(true): otherwise
+// it waits until the message thread wakes it, so an instance left in realtime mode costs nothing.
+//
+// The output is the stretcher's output delayed by a fixed getLatencyInSamples(), which is how much
+// time the worker has to keep up. If it still falls behind, the missing output is replaced with
+// silence and the late samples are skipped once they arrive, so the delay never drifts.
+class BackgroundPitchShifter : private juce::Thread
+{
+public:
+    BackgroundPitchShifter();
+    ~BackgroundPitchShifter() override;
+
+    // Non-realtime, stops the worker
+    void prepare(int numChannels, double sampleRate, int maximumBlockSize, int latencyInSamples, PitchShiftQuality quality);
+    void start();
+    void stop();
+
+    int getLatencyInSamples() const { return latency; }
+
+    // Not the audio thread. Wakes the worker, or lets it sleep indefinitely after its next poll.
+    void setActive(bool shouldBeActive);
+
+    // Any thread: true once the worker has woken up after setActive(true), so process() may be used
+    bool isActive() const;
+
+    // Any thread: the worker reconfigures and crossfades to the new quality on its next poll while active
+    void setQuality(PitchShiftQuality newQuality);
+
+    // Audio thread. Applied by the worker before it processes its next chunk.
+    void setTransposeSemitones(float semitones);
+
+    // Audio thread. Flushes the stretcher and both FIFOs; the output is silent until the worker has done so.
+    void reset();
+
+    // Audio thread. out receives the output for the input pushed getLatencyInSamples() earlier,
+    // in-place use (out == in) is allowed.
+    void process(const float* const* in, float* const* out, int numSamples);
+
+    // Any thread: calls to process() in which the worker had not produced enough output in time
+    juce::uint64 getNumUnderruns() const { return underruns.load(std::memory_order_relaxed); }
+
+private:
+    void run() override;
+
+    void pushInput(const float* const* in, int numSamples);
+    int pullOutput(float* const* out, int startSample, int numSamples);
+
+    CrossfadingPitchShifter shifter;
+
+    // Audio thread -> worker, and worker -> audio thread
+    juce::AbstractFifo inputFifo{1}, outputFifo{1};
+    juce::AudioBuffer<float> inputRing, outputRing;
+
+    // Worker scratch, one chunk
+    juce::AudioBuffer<float> workerInput, workerOutput;
+
+    // Message thread -> worker, and whether the worker has seen it yet
+    std::atomic<bool> activeRequested{false};
+    std::atomic<bool> workerAwake{false};
+
+    std::atomic<float> transposeSemitones{0.f};
+    float workerTransposeSemitones{0.f};
+
+    // Set by the audio thread, cleared by the worker once the stretcher and input FIFO are flushed
+    std::atomic<bool> flushRequested{false};
+    bool awaitingFlush{false};
+
+    // Audio thread: produced samples still to skip after an underrun (> 0), or silent samples still
+    // to emit after a flush (< 0), before the produced stream lines up with the input again
+    int outputOffset{0};
+
+    std::atomic<juce::uint64> underruns{0};
+
+    int numChannels{0};
+    int maxBlockSize{0};
+    int latency{0};
+    double pollIntervalMs{1.0};
+};
@@ -0,0 +1,80 @@
+#include "BlockDelayLine.h"
+#include <algorithm>
+#include <cstring>
+
+template <typename SampleType>
+void BlockDelayLine<SampleType>::prepare(int numChannels, int maximumDelayInSamples, int maximumBlockSize)
+{
+    jassert(maximumDelayInSamples >= 0 && maximumBlockSize > 0);
+
+    // Reading numSamples starting delayInSamples behind the write position must not reach
+    // anything this block has already overwritten
+    this->capacity = maximumDelayInSamples + maximumBlockSize;
+    this->maxBlockSize = maximumBlockSize;
+    this->delayInSamples = juce::jmin(this->delayInSamples, maximumDelayInSamples);
+
+    this->mirrored.assign(static_cast<size_t>(numChannels), std::vector<SampleType>(static_cast<size_t>(2 * this->capacity), SampleType()));
+    this->writePositions.assign(static_cast<size_t>(numChannels), 0);
+}
+
+template <typename SampleType>
+void BlockDelayLine<SampleType>::setDelay(int newDelayInSamples)
+{
+    jassert(newDelayInSamples >= 0 && newDelayInSamples <= this->capacity - this->maxBlockSize);
+
+    this->delayInSamples = newDelayInSamples;
+    reset();
+}
+
+template <typename SampleType>
+void BlockDelayLine<SampleType>::reset()
+{
+    for (auto& buffer : this->mirrored)
+        std::fill(buffer.begin(), buffer.end(), SampleType());
+
+    std::fill(this->writePositions.begin(), this->writePositions.end(), 0);
+}
+
+template <typename SampleType>
+void BlockDelayLine<SampleType>::process(int channel, const SampleType* in, SampleType* out, int numSamples)
+{
+    for (int start = 0; start < numSamples; start += this->maxBlockSize)
+    {
+        auto num = std::min(this->maxBlockSize, numSamples - start);
+        processChunk(channel, in + start, out + start, num);
+    }
+}
+
+template <typename SampleType>
+void BlockDelayLine<SampleType>::processChunk(int channel, const SampleType* in, SampleType* out, int numSamples)
+{
+    SampleType* data = this->mirrored[(size_t) channel].data();
+    int& writePos = this->writePositions[(size_t) channel];
+
+    // Write into both halves, split where the ring wraps
+    auto numToEnd = std::min(numSamples, this->capacity - writePos);
+    auto numWrapped = numSamples - numToEnd;
+
+    std::memcpy(data + writePos, in, sizeof(SampleType) * (size_t) numToEnd);
+    std::memcpy(data + writePos + this->capacity, in, sizeof(SampleType) * (size_t) numToEnd);
+
+    if (numWrapped > 0)
+    {
+        std::memcpy(data, in + numToEnd, sizeof(SampleType) * (size_t) numWrapped);
+        std::memcpy(data + this->capacity, in + numToEnd, sizeof(SampleType) * (size_t) numWrapped);
+    }
+
+    // Start of the delayed run lies in the first half, so the whole run is contiguous
+    auto readPos = writePos - this->delayInSamples;
+    if (readPos < 0)
+        readPos += this->capacity;
+
+    std::memcpy(out, data + readPos, sizeof(SampleType) * (size_t) numSamples);
+
+    writePos += numSamples;
+    if (writePos >= this->capacity)
+        writePos -= this->capacity;
+}
+
+template class BlockDelayLine<float>;
+template class BlockDelayLine<double>;
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <vector>
+
+// Fixed integer delay for whole blocks, with a separate write position per channel.
+//
+// Each channel's ring is stored twice back to back (a mirrored buffer of 2 * capacity), so the
+// delayed run of any block is contiguous: a block costs one copy in (two at the wrap, each written
+// to both halves) and one copy out, with no per-sample index arithmetic. SampleType is float or double.
+template <typename SampleType>
+class BlockDelayLine
+{
+public:
+    // Non-realtime
+    void prepare(int numChannels, int maximumDelayInSamples, int maximumBlockSize);
+
+    // Clears the history, delays of 0 ... maximumDelayInSamples
+    void setDelay(int newDelayInSamples);
+    int getDelay() const { return delayInSamples; }
+
+    void reset();
+
+    // In-place use (out == in) is allowed
+    void process(int channel, const SampleType* in, SampleType* out, int numSamples);
+
+private:
+    void processChunk(int channel, const SampleType* in, SampleType* out, int numSamples);
+
+    std::vector<std::vector<SampleType>> mirrored;  // per channel, 2 * capacity
+    std::vector<int> writePositions;                // per channel, 0 ... capacity - 1
+
+    int capacity{0};
+    int maxBlockSize{0};
+    int delayInSamples{0};
+};
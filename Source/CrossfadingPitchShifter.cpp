@@ -0,0 +1,146 @@
+#include "CrossfadingPitchShifter.h"
+
+void CrossfadingPitchShifter::prepare(int newNumChannels, double newSampleRate, int maximumBlockSize, PitchShiftQuality quality)
+{
+    jassert(newNumChannels > 0 && maximumBlockSize > 0);
+
+    this->numChannels = newNumChannels;
+    this->sampleRate = newSampleRate;
+    this->maxBlockSize = maximumBlockSize;
+
+    this->live = 0;
+    configure(this->stretchers[0], newNumChannels, newSampleRate, quality);
+    this->stretchers[0].setTransposeSemitones(this->transposeSemitones);
+
+    this->requestedQuality.store(static_cast<int>(quality));
+    this->liveQuality.store(static_cast<int>(quality));
+    this->spareState.store(spareIdle);
+    this->latency.store(getStretchLatency(this->stretchers[0]));
+
+    this->crossfadeLength = static_cast<int>(0.05 * newSampleRate);
+    this->spareOutput.setSize(newNumChannels, maximumBlockSize);
+}
+
+void CrossfadingPitchShifter::setQuality(PitchShiftQuality newQuality)
+{
+    this->requestedQuality.store(static_cast<int>(newQuality), std::memory_order_relaxed);
+}
+
+bool CrossfadingPitchShifter::updateConfiguration()
+{
+    // Only this thread moves the spare out of idle, and the processing thread hands it back
+    if (this->spareState.load(std::memory_order_acquire) != spareIdle)
+        return false;
+
+    auto requested = this->requestedQuality.load(std::memory_order_relaxed);
+
+    if (requested == this->liveQuality.load(std::memory_order_relaxed))
+        return true;
+
+    this->spareState.store(spareConfiguring, std::memory_order_relaxed);
+
+    auto& spare = this->stretchers[(size_t) (1 - this->live)];
+    configure(spare, this->numChannels, this->sampleRate, static_cast<PitchShiftQuality>(requested));
+    spare.reset();
+    this->spareQuality = requested;
+
+    this->spareState.store(spareReady, std::memory_order_release);
+    return true;
+}
+
+void CrossfadingPitchShifter::setTransposeSemitones(float semitones)
+{
+    this->transposeSemitones = semitones;
+    this->stretchers[(size_t) this->live].setTransposeSemitones(semitones);
+
+    if (this->spareState.load(std::memory_order_relaxed) == spareSwapping)
+        this->stretchers[(size_t) (1 - this->live)].setTransposeSemitones(semitones);
+}
+
+void CrossfadingPitchShifter::reset()
+{
+    // Nothing to crossfade from after a flush, a pending spare takes over straight away
+    auto state = this->spareState.load(std::memory_order_acquire);
+
+    if (state == spareReady || state == spareSwapping)
+    {
+        this->stretchers[(size_t) (1 - this->live)].setTransposeSemitones(this->transposeSemitones);
+        finishSwap();
+    }
+
+    this->stretchers[(size_t) this->live].reset();
+}
+
+void CrossfadingPitchShifter::process(const float* const* in, float* const* out, int numSamples)
+{
+    jassert(numSamples <= this->maxBlockSize);
+
+    auto state = this->spareState.load(std::memory_order_acquire);
+
+    if (state == spareReady)
+    {
+        this->stretchers[(size_t) (1 - this->live)].setTransposeSemitones(this->transposeSemitones);
+        this->swapPreRoll = getStretchLatency(this->stretchers[(size_t) (1 - this->live)]);
+        this->swapPosition = 0;
+
+        this->spareState.store(spareSwapping, std::memory_order_relaxed);
+        state = spareSwapping;
+    }
+
+    this->stretchers[(size_t) this->live].process(in, numSamples, out, numSamples);
+
+    if (state != spareSwapping)
+        return;
+
+    // The spare's output only counts once it has run for its own latency
+    auto* const* spareChannels = this->spareOutput.getArrayOfWritePointers();
+    this->stretchers[(size_t) (1 - this->live)].process(in, numSamples, spareChannels, numSamples);
+
+    auto fadeStart = this->swapPosition - this->swapPreRoll;
+    auto fadeStep = 1.f / static_cast<float>(juce::jmax(1, this->crossfadeLength));
+
+    for (int channel = 0; channel < this->numChannels; ++channel)
+    {
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto gain = juce::jlimit(0.f, 1.f, static_cast<float>(fadeStart + i) * fadeStep);
+            out[channel][i] += gain * (spareChannels[channel][i] - out[channel][i]);
+        }
+    }
+
+    this->swapPosition += numSamples;
+
+    if (this->swapPosition >= this->swapPreRoll + this->crossfadeLength)
+        finishSwap();
+}
+
+void CrossfadingPitchShifter::finishSwap()
+{
+    this->live = 1 - this->live;
+    this->liveQuality.store(this->spareQuality, std::memory_order_relaxed);
+    this->latency.store(getStretchLatency(this->stretchers[(size_t) this->live]), std::memory_order_relaxed);
+
+    // Hands the old live stretcher to the configuring thread as the next spare
+    this->spareState.store(spareIdle, std::memory_order_release);
+}
+
+void CrossfadingPitchShifter::configure(Stretch& stretch, int channels, double rate, PitchShiftQuality quality)
+{
+    switch (quality)
+    {
+        case PitchShiftQuality::eco:
+            stretch.configure(channels, static_cast<int>(rate * 0.05), static_cast<int>(rate * 0.02));
+            break;
+        case PitchShiftQuality::normal:
+            stretch.configure(channels, static_cast<int>(rate * 0.1), static_cast<int>(rate * 0.04));
+            break;
+        case PitchShiftQuality::high:
+            stretch.configure(channels, static_cast<int>(rate * 0.12), static_cast<int>(rate * 0.03));
+            break;
+    }
+}
+
+int CrossfadingPitchShifter::getStretchLatency(Stretch& stretch)
+{
+    return stretch.inputLatency() + stretch.outputLatency();
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include "signalsmith-stretch/signalsmith-stretch.h"
+
+// SignalsmithStretch block and interval sizes, cheapest first
+enum class PitchShiftQuality
+{
+    eco,        // 50 ms blocks, 20 ms interval
+    normal,     // 100 ms blocks, 40 ms interval (presetCheaper)
+    high        // 120 ms blocks, 30 ms interval (presetDefault)
+};
+
+// A pitch shifter whose quality can change while it runs. There are two stretchers, a live one and
+// a spare: a quality change configures the spare off the processing thread (configure() allocates),
+// then the processing thread runs it silently for its latency so its buffers are full, crossfades
+// to it and swaps, leaving the old one as the next spare.
+class CrossfadingPitchShifter
+{
+public:
+    // Non-realtime, nothing else may use the shifter meanwhile
+    void prepare(int numChannels, double sampleRate, int maximumBlockSize, PitchShiftQuality quality);
+
+    // Any thread
+    void setQuality(PitchShiftQuality newQuality);
+
+    // One configuring thread, or the processing thread between process() calls (which then waits for
+    // the allocation). Configures the spare if the requested quality differs from the live one.
+    // Returns false if it couldn't because a swap is still in progress, so it should be called again.
+    bool updateConfiguration();
+
+    // Any thread: the live stretcher's input plus output latency
+    int getLatencyInSamples() const { return latency.load(std::memory_order_relaxed); }
+
+    // Processing thread (the audio thread, or the worker of a BackgroundPitchShifter)
+    void setTransposeSemitones(float semitones);
+    void reset();
+
+    // Processing thread, up to maximumBlockSize samples. in and out must not overlap.
+    void process(const float* const* in, float* const* out, int numSamples);
+
+private:
+    using Stretch = signalsmith::stretch::SignalsmithStretch<float>;
+
+    enum SpareState
+    {
+        spareIdle,          // owned by the configuring thread
+        spareConfiguring,
+        spareReady,         // owned by the processing thread from here on
+        spareSwapping
+    };
+
+    static void configure(Stretch& stretch, int channels, double rate, PitchShiftQuality quality);
+    static int getStretchLatency(Stretch& stretch);
+
+    void finishSwap();
+
+    std::array<Stretch, 2> stretchers;
+    int live{0};
+
+    std::atomic<int> requestedQuality{static_cast<int>(PitchShiftQuality::normal)};
+    std::atomic<int> liveQuality{static_cast<int>(PitchShiftQuality::normal)};
+    std::atomic<int> spareState{spareIdle};
+    int spareQuality{0};
+
+    std::atomic<int> latency{0};
+
+    // Processing thread: progress of the current swap, pre-roll then crossfade
+    int swapPosition{0};
+    int swapPreRoll{0};
+    int crossfadeLength{0};
+
+    float transposeSemitones{0.f};
+
+    juce::AudioBuffer<float> spareOutput;
+
+    int numChannels{0};
+    double sampleRate{44100.0};
+    int maxBlockSize{0};
+};
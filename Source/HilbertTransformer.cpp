@@ -0,0 +1,392 @@
+#include "HilbertTransformer.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined(__AVX__)
+ #include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define STRANGE_ECHOES_HILBERT_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #include <arm_neon.h>
+#endif
+
+namespace
+{
+    // A register of consecutive interleaved frames: lane k holds frame k / 2, channel k % 2
+   #if defined(__AVX__)
+    struct FrameVector
+    {
+        static constexpr int numFloats = 8;
+        __m256 v;
+
+        static FrameVector zero() noexcept                       { return { _mm256_setzero_ps() }; }
+        static FrameVector load(const float* p) noexcept         { return { _mm256_loadu_ps(p) }; }
+        void multiplyAdd(FrameVector a, FrameVector b) noexcept  { v = _mm256_add_ps(v, _mm256_mul_ps(a.v, b.v)); }
+        void store(float* p) const noexcept                      { _mm256_storeu_ps(p, v); }
+    };
+   #elif STRANGE_ECHOES_HILBERT_SSE
+    struct FrameVector
+    {
+        static constexpr int numFloats = 4;
+        __m128 v;
+
+        static FrameVector zero() noexcept                       { return { _mm_setzero_ps() }; }
+        static FrameVector load(const float* p) noexcept         { return { _mm_loadu_ps(p) }; }
+        void multiplyAdd(FrameVector a, FrameVector b) noexcept  { v = _mm_add_ps(v, _mm_mul_ps(a.v, b.v)); }
+        void store(float* p) const noexcept                      { _mm_storeu_ps(p, v); }
+    };
+   #elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    struct FrameVector
+    {
+        static constexpr int numFloats = 4;
+        float32x4_t v;
+
+        static FrameVector zero() noexcept                       { return { vdupq_n_f32(0.f) }; }
+        static FrameVector load(const float* p) noexcept         { return { vld1q_f32(p) }; }
+        void multiplyAdd(FrameVector a, FrameVector b) noexcept  { v = vmlaq_f32(v, a.v, b.v); }
+        void store(float* p) const noexcept                      { vst1q_f32(p, v); }
+    };
+   #else
+    struct FrameVector
+    {
+        static constexpr int numFloats = 4;
+        float v[4];
+
+        static FrameVector zero() noexcept                       { return { { 0.f, 0.f, 0.f, 0.f } }; }
+        static FrameVector load(const float* p) noexcept         { return { { p[0], p[1], p[2], p[3] } }; }
+        void multiplyAdd(FrameVector a, FrameVector b) noexcept  { for (int i = 0; i < 4; ++i) v[i] += a.v[i] * b.v[i]; }
+        void store(float* p) const noexcept                      { std::copy(v, v + 4, p); }
+    };
+   #endif
+
+    constexpr int framesPerVector = FrameVector::numFloats / 2;
+}
+
+std::vector<float> designHilbertKernel(int numTaps)
+{
+    jassert(numTaps % 2 == 1);
+
+    std::vector<float> taps(static_cast<size_t>(numTaps), 0.f);
+    const int centre = numTaps / 2;
+
+    for (int n = 1; n <= centre; n += 2)
+    {
+        auto phase = juce::MathConstants<double>::pi * (centre + n) / (numTaps - 1);
+        auto window = 0.42 - 0.5 * std::cos(2.0 * phase) + 0.08 * std::cos(4.0 * phase);
+        auto tap = static_cast<float>(window * 2.0 / (juce::MathConstants<double>::pi * n));
+
+        taps[static_cast<size_t>(centre + n)] = tap;
+        taps[static_cast<size_t>(centre - n)] = -tap;
+    }
+
+    return taps;
+}
+
+void HilbertTransformer::setKernel(const float* taps, int numTaps)
+{
+    jassert(numTaps % 2 == 1);
+
+    this->kernelSize = numTaps;
+    this->oddTaps.clear();
+    this->splatTaps.clear();
+
+    for (int i = 0; i < numTaps; ++i)
+    {
+        if (i % 2 == 0)
+        {
+            jassert(taps[i] == 0.f);
+            continue;
+        }
+
+        this->oddTaps.push_back(taps[i]);
+        this->splatTaps.insert(this->splatTaps.end(), FrameVector::numFloats, taps[i]);
+    }
+
+    // Output frame n reads frames n - 1 ... n - (numTaps - 2), keep an even number of history frames
+    this->historyFrames = numTaps - 1;
+
+    prepare(this->maxBlockSize);
+}
+
+void HilbertTransformer::prepare(int maximumBlockSize)
+{
+    this->maxBlockSize = maximumBlockSize;
+    this->frames.assign(static_cast<size_t>(2 * (this->historyFrames + maximumBlockSize)), 0.f);
+}
+
+void HilbertTransformer::reset()
+{
+    std::fill(this->frames.begin(), this->frames.end(), 0.f);
+}
+
+void HilbertTransformer::process(const float* inL, const float* inR, float* outL, float* outR, int numSamples)
+{
+    jassert(this->maxBlockSize > 0);
+
+    for (int start = 0; start < numSamples; start += this->maxBlockSize)
+    {
+        auto num = std::min(this->maxBlockSize, numSamples - start);
+        processChunk(inL + start, inR + start, outL + start, outR + start, num);
+    }
+}
+
+void HilbertTransformer::pushHistory(const float* inL, const float* inR, int numSamples)
+{
+    float* x = this->frames.data();
+    const int numNew = std::min(numSamples, this->historyFrames);
+    const int numKept = this->historyFrames - numNew;
+    const int firstNew = numSamples - numNew;
+
+    std::memmove(x, x + 2 * numNew, sizeof(float) * static_cast<size_t>(2 * numKept));
+
+    for (int i = 0; i < numNew; ++i)
+    {
+        x[2 * (numKept + i)]     = inL[firstNew + i];
+        x[2 * (numKept + i) + 1] = inR[firstNew + i];
+    }
+}
+
+void HilbertTransformer::processChunk(const float* inL, const float* inR, float* outL, float* outR, int numSamples)
+{
+    float* x = this->frames.data();
+    const float* taps = this->oddTaps.data();
+    const int numOddTaps = static_cast<int>(this->oddTaps.size());
+    const int first = this->historyFrames;
+    const int end = first + numSamples;
+
+    // Append the block to the interleaved history
+    for (int i = 0; i < numSamples; ++i)
+    {
+        x[2 * (first + i)]     = inL[i];
+        x[2 * (first + i) + 1] = inR[i];
+    }
+
+    // Frames p ... p + framesPerVector - 1 at once: for tap j, one load starting at frame p - 1 - 2j
+    // lines up with exactly the input frame each of those outputs needs. Several independent
+    // accumulators are run side by side so the adds are not bound by their own latency.
+    const float* splat = this->splatTaps.data();
+    int p = first;
+
+    auto storeFrames = [&](const FrameVector& acc, int frame)
+    {
+        float result[FrameVector::numFloats];
+        acc.store(result);
+
+        for (int k = 0; k < framesPerVector; ++k)
+        {
+            outL[frame - first + k] = result[2 * k];
+            outR[frame - first + k] = result[2 * k + 1];
+        }
+    };
+
+    for (; p + 4 * framesPerVector <= end; p += 4 * framesPerVector)
+    {
+        auto acc0 = FrameVector::zero(), acc1 = FrameVector::zero(), acc2 = FrameVector::zero(), acc3 = FrameVector::zero();
+        const float* src = x + 2 * (p - 1);
+
+        for (int j = 0; j < numOddTaps; ++j)
+        {
+            auto tap = FrameVector::load(splat + j * FrameVector::numFloats);
+            const float* s = src - 4 * j;
+
+            acc0.multiplyAdd(tap, FrameVector::load(s));
+            acc1.multiplyAdd(tap, FrameVector::load(s + FrameVector::numFloats));
+            acc2.multiplyAdd(tap, FrameVector::load(s + 2 * FrameVector::numFloats));
+            acc3.multiplyAdd(tap, FrameVector::load(s + 3 * FrameVector::numFloats));
+        }
+
+        storeFrames(acc0, p);
+        storeFrames(acc1, p + framesPerVector);
+        storeFrames(acc2, p + 2 * framesPerVector);
+        storeFrames(acc3, p + 3 * framesPerVector);
+    }
+
+    for (; p + framesPerVector <= end; p += framesPerVector)
+    {
+        auto acc = FrameVector::zero();
+        const float* src = x + 2 * (p - 1);
+
+        for (int j = 0; j < numOddTaps; ++j)
+            acc.multiplyAdd(FrameVector::load(splat + j * FrameVector::numFloats), FrameVector::load(src - 4 * j));
+
+        storeFrames(acc, p);
+    }
+
+    for (; p < end; ++p)
+    {
+        float sumL = 0.f, sumR = 0.f;
+        const float* src = x + 2 * (p - 1);
+
+        for (int j = 0; j < numOddTaps; ++j)
+        {
+            sumL += taps[j] * src[-4 * j];
+            sumR += taps[j] * src[-4 * j + 1];
+        }
+
+        outL[p - first] = sumL;
+        outR[p - first] = sumR;
+    }
+
+    // Keep the most recent frames as history for the next block
+    std::memmove(x, x + 2 * numSamples, sizeof(float) * static_cast<size_t>(2 * first));
+}
+
+//==============================================================================
+void DoubleHilbertTransformer::setKernel(const float* taps, int numTaps)
+{
+    jassert(numTaps % 2 == 1);
+
+    this->kernelSize = numTaps;
+    this->oddTaps.clear();
+
+    for (int i = 1; i < numTaps; i += 2)
+    {
+        jassert(taps[i - 1] == 0.f);
+        this->oddTaps.push_back(static_cast<double>(taps[i]));
+    }
+
+    // Output sample n reads samples n - 1 ... n - (numTaps - 2)
+    this->historySamples = numTaps - 1;
+
+    prepare(this->maxBlockSize);
+}
+
+void DoubleHilbertTransformer::prepare(int maximumBlockSize)
+{
+    this->maxBlockSize = maximumBlockSize;
+
+    for (auto& channel : this->history)
+        channel.assign(static_cast<size_t>(this->historySamples + maximumBlockSize), 0.0);
+}
+
+void DoubleHilbertTransformer::reset()
+{
+    for (auto& channel : this->history)
+        std::fill(channel.begin(), channel.end(), 0.0);
+}
+
+void DoubleHilbertTransformer::process(const double* inL, const double* inR, double* outL, double* outR, int numSamples)
+{
+    jassert(this->maxBlockSize > 0);
+
+    for (int start = 0; start < numSamples; start += this->maxBlockSize)
+    {
+        auto num = std::min(this->maxBlockSize, numSamples - start);
+        const double* in[2] = { inL + start, inR + start };
+        double* out[2] = { outL + start, outR + start };
+        processChunk(in, out, num);
+    }
+}
+
+void DoubleHilbertTransformer::pushHistory(const double* inL, const double* inR, int numSamples)
+{
+    const double* in[2] = { inL, inR };
+    const int numNew = std::min(numSamples, this->historySamples);
+    const int numKept = this->historySamples - numNew;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        double* x = this->history[static_cast<size_t>(channel)].data();
+
+        std::memmove(x, x + numNew, sizeof(double) * static_cast<size_t>(numKept));
+        std::memcpy(x + numKept, in[channel] + numSamples - numNew, sizeof(double) * static_cast<size_t>(numNew));
+    }
+}
+
+void DoubleHilbertTransformer::processChunk(const double* const* in, double* const* out, int numSamples)
+{
+    const double* taps = this->oddTaps.data();
+    const int numOddTaps = static_cast<int>(this->oddTaps.size());
+    const int first = this->historySamples;
+
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        double* x = this->history[static_cast<size_t>(channel)].data();
+
+        // Append the block first, so the output may overwrite the input
+        std::memcpy(x + first, in[channel], sizeof(double) * static_cast<size_t>(numSamples));
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            // Tap 2j + 1 multiplies the sample 2j + 1 before this one
+            const double* src = x + first + i - 1;
+            double sum = 0.0;
+
+            for (int j = 0; j < numOddTaps; ++j)
+                sum += taps[j] * src[-2 * j];
+
+            out[channel][i] = sum;
+        }
+
+        // Keep the most recent samples as history for the next block
+        std::memmove(x, x + numSamples, sizeof(double) * static_cast<size_t>(first));
+    }
+}
+
+//==============================================================================
+template <typename SampleType>
+AllpassHilbertTransformer<SampleType>::AllpassHilbertTransformer()
+{
+    static constexpr double inPhaseCoeffs[4]    = { 0.4021921162426, 0.8561710882420, 0.9722909545651, 0.9952884791278 };
+    static constexpr double quadratureCoeffs[4] = { 0.6923878,       0.9360654322959, 0.9882295226860, 0.9987488452737 };
+
+    for (auto& channel : this->channels)
+    {
+        for (size_t i = 0; i < 4; ++i)
+        {
+            channel.inPhase[i].coeff = static_cast<SampleType>(inPhaseCoeffs[i] * inPhaseCoeffs[i]);
+            channel.quadrature[i].coeff = static_cast<SampleType>(quadratureCoeffs[i] * quadratureCoeffs[i]);
+        }
+    }
+}
+
+template <typename SampleType>
+void AllpassHilbertTransformer<SampleType>::reset()
+{
+    for (auto& channel : this->channels)
+    {
+        for (auto* chain : { &channel.inPhase, &channel.quadrature })
+            for (auto& section : *chain)
+                section.x1 = section.x2 = section.y1 = section.y2 = 0;
+
+        channel.quadratureDelay = 0;
+    }
+}
+
+template <typename SampleType>
+void AllpassHilbertTransformer<SampleType>::process(const SampleType* inL, const SampleType* inR,
+                                                    SampleType* inPhaseL, SampleType* inPhaseR,
+                                                    SampleType* quadratureL, SampleType* quadratureR,
+                                                    int numSamples)
+{
+    processChannel(this->channels[0], inL, inPhaseL, quadratureL, numSamples);
+    processChannel(this->channels[1], inR, inPhaseR, quadratureR, numSamples);
+}
+
+template <typename SampleType>
+void AllpassHilbertTransformer<SampleType>::processChannel(Channel& channel, const SampleType* in, SampleType* inPhaseOut,
+                                                           SampleType* quadratureOut, int numSamples) noexcept
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto x = in[i];
+        auto inPhase = x;
+        auto quadrature = x;
+
+        for (auto& section : channel.inPhase)
+            inPhase = section.process(inPhase);
+
+        for (auto& section : channel.quadrature)
+            quadrature = section.process(quadrature);
+
+        // The quadrature chain is followed by a one sample delay
+        inPhaseOut[i] = inPhase;
+        quadratureOut[i] = channel.quadratureDelay;
+        channel.quadratureDelay = quadrature;
+    }
+}
+
+template struct AllpassHilbertTransformer<float>;
+template struct AllpassHilbertTransformer<double>;
@@ -0,0 +1,346 @@
+#include "Lfo.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define STRANGE_ECHOES_LFO_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #include <arm_neon.h>
+ #define STRANGE_ECHOES_LFO_NEON 1
+#endif
+
+namespace
+{
+    // 4 consecutive values, and the phases they are computed from
+   #if STRANGE_ECHOES_LFO_SSE
+    struct Vector
+    {
+        __m128 v;
+
+        static Vector fill(float x) noexcept                    { return { _mm_set1_ps(x) }; }
+        void store(float* p) const noexcept                     { _mm_storeu_ps(p, v); }
+
+        Vector operator+(Vector o) const noexcept               { return { _mm_add_ps(v, o.v) }; }
+        Vector operator-(Vector o) const noexcept               { return { _mm_sub_ps(v, o.v) }; }
+        Vector operator*(Vector o) const noexcept               { return { _mm_mul_ps(v, o.v) }; }
+
+        Vector abs() const noexcept                             { return { _mm_andnot_ps(_mm_set1_ps(-0.f), v) }; }
+        Vector min(Vector o) const noexcept                     { return { _mm_min_ps(v, o.v) }; }
+        Vector max(Vector o) const noexcept                     { return { _mm_max_ps(v, o.v) }; }
+    };
+
+    struct PhaseVector
+    {
+        __m128i v;
+
+        static PhaseVector lanes(uint32_t phase, uint32_t increment) noexcept
+        {
+            return { _mm_setr_epi32(static_cast<int>(phase), static_cast<int>(phase + increment),
+                                    static_cast<int>(phase + 2 * increment), static_cast<int>(phase + 3 * increment)) };
+        }
+
+        static PhaseVector fill(uint32_t x) noexcept            { return { _mm_set1_epi32(static_cast<int>(x)) }; }
+
+        PhaseVector operator+(PhaseVector o) const noexcept     { return { _mm_add_epi32(v, o.v) }; }
+
+        // The top 24 bits as a position in the cycle, 0 ... 1
+        Vector toUnit() const noexcept
+        {
+            return { _mm_mul_ps(_mm_cvtepi32_ps(_mm_srli_epi32(v, 8)), _mm_set1_ps(1.f / 16777216.f)) };
+        }
+    };
+   #elif STRANGE_ECHOES_LFO_NEON
+    struct Vector
+    {
+        float32x4_t v;
+
+        static Vector fill(float x) noexcept                    { return { vdupq_n_f32(x) }; }
+        void store(float* p) const noexcept                     { vst1q_f32(p, v); }
+
+        Vector operator+(Vector o) const noexcept               { return { vaddq_f32(v, o.v) }; }
+        Vector operator-(Vector o) const noexcept               { return { vsubq_f32(v, o.v) }; }
+        Vector operator*(Vector o) const noexcept               { return { vmulq_f32(v, o.v) }; }
+
+        Vector abs() const noexcept                             { return { vabsq_f32(v) }; }
+        Vector min(Vector o) const noexcept                     { return { vminq_f32(v, o.v) }; }
+        Vector max(Vector o) const noexcept                     { return { vmaxq_f32(v, o.v) }; }
+    };
+
+    struct PhaseVector
+    {
+        uint32x4_t v;
+
+        static PhaseVector lanes(uint32_t phase, uint32_t increment) noexcept
+        {
+            const uint32_t l[4] = { phase, phase + increment, phase + 2 * increment, phase + 3 * increment };
+            return { vld1q_u32(l) };
+        }
+
+        static PhaseVector fill(uint32_t x) noexcept            { return { vdupq_n_u32(x) }; }
+
+        PhaseVector operator+(PhaseVector o) const noexcept     { return { vaddq_u32(v, o.v) }; }
+
+        Vector toUnit() const noexcept
+        {
+            return { vmulq_f32(vcvtq_f32_u32(vshrq_n_u32(v, 8)), vdupq_n_f32(1.f / 16777216.f)) };
+        }
+    };
+   #else
+    struct Vector
+    {
+        float v[4];
+
+        static Vector fill(float x) noexcept                    { return { { x, x, x, x } }; }
+        void store(float* p) const noexcept                     { for (int k = 0; k < 4; ++k) p[k] = v[k]; }
+
+        Vector operator+(Vector o) const noexcept               { Vector r; for (int k = 0; k < 4; ++k) r.v[k] = v[k] + o.v[k]; return r; }
+        Vector operator-(Vector o) const noexcept               { Vector r; for (int k = 0; k < 4; ++k) r.v[k] = v[k] - o.v[k]; return r; }
+        Vector operator*(Vector o) const noexcept               { Vector r; for (int k = 0; k < 4; ++k) r.v[k] = v[k] * o.v[k]; return r; }
+
+        Vector abs() const noexcept                             { Vector r; for (int k = 0; k < 4; ++k) r.v[k] = std::abs(v[k]); return r; }
+        Vector min(Vector o) const noexcept                     { Vector r; for (int k = 0; k < 4; ++k) r.v[k] = juce::jmin(v[k], o.v[k]); return r; }
+        Vector max(Vector o) const noexcept                     { Vector r; for (int k = 0; k < 4; ++k) r.v[k] = juce::jmax(v[k], o.v[k]); return r; }
+    };
+
+    struct PhaseVector
+    {
+        uint32_t v[4];
+
+        static PhaseVector lanes(uint32_t phase, uint32_t increment) noexcept
+        {
+            return { { phase, phase + increment, phase + 2 * increment, phase + 3 * increment } };
+        }
+
+        static PhaseVector fill(uint32_t x) noexcept            { return { { x, x, x, x } }; }
+
+        PhaseVector operator+(PhaseVector o) const noexcept     { PhaseVector r; for (int k = 0; k < 4; ++k) r.v[k] = v[k] + o.v[k]; return r; }
+
+        Vector toUnit() const noexcept
+        {
+            Vector r;
+            for (int k = 0; k < 4; ++k)
+                r.v[k] = static_cast<float>(v[k] >> 8) * (1.f / 16777216.f);
+            return r;
+        }
+    };
+   #endif
+
+    constexpr int vectorSize = 4;
+
+    // 0 at the start of the cycle, 1 a quarter in, -1 three quarters in, the same phase as the sine.
+    // The quarter cycle shift is done on the integer phase, where it wraps for free.
+    Vector triangle(PhaseVector phase) noexcept
+    {
+        auto u = (phase + PhaseVector::fill(0xc0000000u)).toUnit();
+        return (u * Vector::fill(4.f) - Vector::fill(2.f)).abs() - Vector::fill(1.f);
+    }
+
+    // sin(pi/2 * t) on the triangle, Taylor series to the 9th power, within 4e-6 of std::sin
+    Vector sine(PhaseVector phase) noexcept
+    {
+        auto t = triangle(phase);
+        auto t2 = t * t;
+
+        auto series = Vector::fill(1.60441e-4f);
+        series = Vector::fill(4.681754e-3f) - t2 * series;
+        series = Vector::fill(7.969263e-2f) - t2 * series;
+        series = Vector::fill(6.459641e-1f) - t2 * series;
+        series = Vector::fill(1.570796f) - t2 * series;
+
+        return t * series;
+    }
+
+    // Rises over the first 15/16 of the cycle and falls back in the last 1/16
+    Vector saw(PhaseVector phase) noexcept
+    {
+        auto u = phase.toUnit();
+        auto rise = u * Vector::fill(32.f / 15.f) - Vector::fill(1.f);
+        auto fall = Vector::fill(31.f) - u * Vector::fill(32.f);
+        return rise.min(fall);
+    }
+
+    // The triangle's middle 1/8 scaled up to the full range, so each edge takes 1/16 of a cycle
+    Vector square(PhaseVector phase) noexcept
+    {
+        return (triangle(phase) * Vector::fill(8.f)).min(Vector::fill(1.f)).max(Vector::fill(-1.f));
+    }
+
+    template <typename ShapeFunction>
+    void renderShape(float* out, uint32_t phase, uint32_t increment, int numSamples, ShapeFunction&& shape)
+    {
+        auto phases = PhaseVector::lanes(phase, increment);
+        auto step = PhaseVector::fill(increment * vectorSize);
+        int i = 0;
+
+        for (; i + vectorSize <= numSamples; i += vectorSize)
+        {
+            shape(phases).store(out + i);
+            phases = phases + step;
+        }
+
+        if (i < numSamples)
+        {
+            float last[vectorSize];
+            shape(phases).store(last);
+
+            for (int k = 0; i < numSamples; ++i, ++k)
+                out[i] = last[k];
+        }
+    }
+}
+
+void Lfo::prepare(double newSampleRate)
+{
+    this->sampleRate = newSampleRate;
+    this->increment = 0;
+    reset();
+}
+
+void Lfo::reset()
+{
+    this->offset = this->targetOffset;
+
+    for (size_t c = 0; c < this->channels.size(); ++c)
+    {
+        auto& channel = this->channels[c];
+        channel.phase = c == 1 ? this->offset : 0;
+
+        // Seeded, so renders come out the same every time
+        channel.random.setSeed(static_cast<juce::int64>(c + 1));
+        channel.from = 0.f;
+        channel.to = 2.f * channel.random.nextFloat() - 1.f;
+    }
+}
+
+void Lfo::setRate(double hz)
+{
+    this->increment = toPhase(hz / this->sampleRate);
+}
+
+void Lfo::setStereoOffset(double cycles)
+{
+    this->targetOffset = toPhase(cycles);
+}
+
+void Lfo::setPhase(double cycles)
+{
+    this->channels[0].phase = toPhase(cycles);
+    this->channels[1].phase = this->channels[0].phase + this->offset;
+}
+
+void Lfo::process(float* const* out, int numChannels, int numSamples)
+{
+    jassert(numChannels <= maxChannels);
+    run(out, numChannels, numSamples);
+}
+
+void Lfo::advance(int numSamples)
+{
+    run(nullptr, 0, numSamples);
+}
+
+void Lfo::run(float* const* out, int numChannels, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    // The right channel runs faster or slower until it reaches the new offset. A change smaller than
+    // one step per sample is made at once, it's less than a millionth of a cycle.
+    auto maxOffsetStep = static_cast<juce::int64>(4294967296.0 / this->sampleRate);
+    auto offsetDelta = static_cast<int32_t>(this->targetOffset - this->offset);
+    auto offsetStep = juce::jlimit(-maxOffsetStep, maxOffsetStep, static_cast<juce::int64>(offsetDelta) / numSamples);
+
+    if (offsetStep == 0)
+    {
+        this->channels[1].phase += static_cast<uint32_t>(offsetDelta);
+        this->offset = this->targetOffset;
+    }
+    else
+    {
+        this->offset += static_cast<uint32_t>(offsetStep * numSamples);
+    }
+
+    // Both channels always move on, so the offset holds when the channel count changes
+    for (size_t c = 0; c < this->channels.size(); ++c)
+    {
+        auto& channel = this->channels[c];
+        auto channelIncrement = static_cast<juce::int64>(this->increment) + (c == 1 ? offsetStep : 0);
+        auto phaseIncrement = static_cast<uint32_t>(channelIncrement);
+
+        for (int i = 0; i < numSamples;)
+        {
+            // Rendered in runs up to the next wrap, which starts a new random level. The right channel
+            // runs backwards while its offset comes down at a slow rate.
+            auto length = numSamples - i;
+            juce::int64 untilWrap = length + 1;
+
+            if (channelIncrement > 0)
+                untilWrap = ((juce::int64(1) << 32) - channel.phase + channelIncrement - 1) / channelIncrement;
+            else if (channelIncrement < 0)
+                untilWrap = channel.phase / -channelIncrement + 1;
+
+            auto wraps = untilWrap <= length;
+
+            if (wraps)
+                length = static_cast<int>(untilWrap);
+
+            if (out != nullptr && static_cast<int>(c) < numChannels)
+                render(out[c] + i, channel, phaseIncrement, length);
+
+            channel.phase += phaseIncrement * static_cast<uint32_t>(length);
+            i += length;
+
+            if (wraps)
+            {
+                channel.from = channel.to;
+                channel.to = 2.f * channel.random.nextFloat() - 1.f;
+            }
+        }
+    }
+}
+
+void Lfo::render(float* out, const Channel& channel, uint32_t phaseIncrement, int numSamples) const
+{
+    auto from = Vector::fill(channel.from);
+    auto difference = Vector::fill(channel.to - channel.from);
+
+    switch (this->shape)
+    {
+        case Shape::sine:
+            renderShape(out, channel.phase, phaseIncrement, numSamples, sine);
+            break;
+
+        case Shape::triangle:
+            renderShape(out, channel.phase, phaseIncrement, numSamples, triangle);
+            break;
+
+        case Shape::saw:
+            renderShape(out, channel.phase, phaseIncrement, numSamples, saw);
+            break;
+
+        case Shape::square:
+            renderShape(out, channel.phase, phaseIncrement, numSamples, square);
+            break;
+
+        case Shape::sampleAndHold:
+            renderShape(out, channel.phase, phaseIncrement, numSamples, [=](PhaseVector phase)
+            {
+                auto glide = (phase.toUnit() * Vector::fill(16.f)).min(Vector::fill(1.f));
+                return from + difference * glide;
+            });
+            break;
+
+        case Shape::smoothRandom:
+            renderShape(out, channel.phase, phaseIncrement, numSamples, [=](PhaseVector phase)
+            {
+                auto u = phase.toUnit();
+                return from + difference * u * u * (Vector::fill(3.f) - u * Vector::fill(2.f));
+            });
+            break;
+    }
+}
+
+uint32_t Lfo::toPhase(double cycles)
+{
+    auto fraction = cycles - std::floor(cycles);
+    return static_cast<uint32_t>(static_cast<juce::uint64>(fraction * 4294967296.0) & 0xffffffffu);
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <cstdint>
+
+// Delay time modulation, one value in -1 ... 1 per sample and channel. The phase is a 32 bit
+// accumulator, so it wraps exactly and lands on the same values however a block is split. Shapes are
+// evaluated 4 samples at a time with SSE or NEON where available; the sine is a polynomial on a folded
+// triangle rather than a std::sin per sample.
+//
+// Saw, square and sample-and-hold make their jumps over 1/16 of a cycle, since a jump in delay time
+// is a click. The random shapes draw a new level per cycle, each channel from its own sequence.
+class Lfo
+{
+public:
+    // Index of the "LFO Shape" choice
+    enum class Shape { sine, triangle, saw, square, sampleAndHold, smoothRandom };
+
+    static constexpr int maxChannels = 2;
+
+    // Non-realtime
+    void prepare(double sampleRate);
+    void reset();
+
+    // Audio thread
+    void setShape(Shape newShape) { shape = newShape; }
+    void setRate(double hz);
+
+    // How far the right channel runs ahead of the left, in cycles (0 ... 1). Changes slew at one
+    // cycle per second so moving it doesn't jump the delay time.
+    void setStereoOffset(double cycles);
+
+    // Moves the left channel to the given position in its cycle, the right one keeps its offset
+    void setPhase(double cycles);
+
+    // Writes the next numSamples values of the first numChannels channels
+    void process(float* const* out, int numChannels, int numSamples);
+
+    // Moves on as process() would without computing anything, so the phase keeps running while the
+    // modulation is off
+    void advance(int numSamples);
+
+private:
+    struct Channel
+    {
+        uint32_t phase{0};
+        float from{0.f}, to{0.f};  // random levels of the previous and the current cycle
+        juce::Random random;
+    };
+
+    void run(float* const* out, int numChannels, int numSamples);
+    void render(float* out, const Channel& channel, uint32_t increment, int numSamples) const;
+
+    static uint32_t toPhase(double cycles);
+
+    double sampleRate{44100.0};
+    Shape shape{Shape::sine};
+    uint32_t increment{0};
+    uint32_t offset{0}, targetOffset{0};
+
+    std::array<Channel, maxChannels> channels;
+};
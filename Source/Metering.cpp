@@ -0,0 +1,127 @@
+#include "Metering.h"
+#include <cmath>
+
+void LevelMeter::prepare(double newSampleRate)
+{
+    this->sampleRate = newSampleRate;
+
+    for (size_t channel = 0; channel < 2; ++channel)
+    {
+        this->peaks[channel].store(0.f);
+        this->rms[channel].store(0.f);
+        this->meanSquares[channel] = 0.f;
+    }
+}
+
+template <typename SampleType>
+void LevelMeter::measure(const SampleType* const* channels, int numChannels, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    // One-pole average of each block's mean square, with a 300 ms time constant
+    auto coefficient = static_cast<float>(1.0 - std::exp(-numSamples / (0.3 * this->sampleRate)));
+
+    for (int channel = 0; channel < juce::jmin(numChannels, 2); ++channel)
+    {
+        auto range = juce::FloatVectorOperations::findMinAndMax(channels[channel], numSamples);
+        auto blockPeak = static_cast<float>(juce::jmax(-range.getStart(), range.getEnd()));
+
+        SampleType sumOfSquares = 0;
+        for (int i = 0; i < numSamples; ++i)
+            sumOfSquares += channels[channel][i] * channels[channel][i];
+
+        auto& meanSquare = this->meanSquares[(size_t) channel];
+        meanSquare += coefficient * (static_cast<float>(sumOfSquares) / static_cast<float>(numSamples) - meanSquare);
+
+        this->rms[(size_t) channel].store(std::sqrt(meanSquare), std::memory_order_relaxed);
+
+        // The reader resets the peak, so it is only ever raised here
+        auto& peak = this->peaks[(size_t) channel];
+        auto previous = peak.load(std::memory_order_relaxed);
+
+        while (blockPeak > previous && ! peak.compare_exchange_weak(previous, blockPeak, std::memory_order_relaxed))
+        {
+        }
+    }
+}
+
+template void LevelMeter::measure<float>(const float* const*, int, int);
+template void LevelMeter::measure<double>(const double* const*, int, int);
+
+float LevelMeter::getAndResetPeak(int channel)
+{
+    return this->peaks[(size_t) channel].exchange(0.f, std::memory_order_relaxed);
+}
+
+void EchoEnvelopeFifo::prepare(double sampleRate)
+{
+    this->samplesPerPoint = juce::jmax(1, juce::roundToInt(sampleRate / pointsPerSecond));
+    this->samplesInPoint = 0;
+    this->current = { 0.f, 0.f };
+}
+
+template <typename SampleType>
+void EchoEnvelopeFifo::push(const SampleType* const* dry, const SampleType* const* wet, int numChannels, int numSamples)
+{
+    for (int start = 0; start < numSamples;)
+    {
+        auto num = juce::jmin(numSamples - start, this->samplesPerPoint - this->samplesInPoint);
+
+        this->current.dry = juce::jmax(this->current.dry, getPeak(dry, numChannels, start, num));
+
+        if (wet != nullptr)
+            this->current.wet = juce::jmax(this->current.wet, getPeak(wet, numChannels, start, num));
+
+        this->samplesInPoint += num;
+        start += num;
+
+        if (this->samplesInPoint == this->samplesPerPoint)
+        {
+            const auto scope = this->fifo.write(1);
+
+            if (scope.blockSize1 > 0)
+                this->points[(size_t) scope.startIndex1] = this->current;
+
+            this->current = { 0.f, 0.f };
+            this->samplesInPoint = 0;
+        }
+    }
+}
+
+template void EchoEnvelopeFifo::push<float>(const float* const*, const float* const*, int, int);
+template void EchoEnvelopeFifo::push<double>(const double* const*, const double* const*, int, int);
+
+int EchoEnvelopeFifo::pop(Point* dest, int maxPoints)
+{
+    const auto scope = this->fifo.read(juce::jmin(maxPoints, this->fifo.getNumReady()));
+
+    for (int i = 0; i < scope.blockSize1; ++i)
+        dest[i] = this->points[(size_t) (scope.startIndex1 + i)];
+
+    for (int i = 0; i < scope.blockSize2; ++i)
+        dest[scope.blockSize1 + i] = this->points[(size_t) (scope.startIndex2 + i)];
+
+    return scope.blockSize1 + scope.blockSize2;
+}
+
+template <typename SampleType>
+float EchoEnvelopeFifo::getPeak(const SampleType* const* channels, int numChannels, int start, int numSamples)
+{
+    SampleType peak = 0;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        auto range = juce::FloatVectorOperations::findMinAndMax(channels[channel] + start, numSamples);
+        peak = juce::jmax(peak, -range.getStart(), range.getEnd());
+    }
+
+    return static_cast<float>(peak);
+}
+
+void Metering::prepare(double sampleRate)
+{
+    this->input.prepare(sampleRate);
+    this->output.prepare(sampleRate);
+    this->echoes.prepare(sampleRate);
+}
@@ -0,0 +1,86 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <vector>
+
+// Peak and RMS levels of a stereo signal. The audio thread measures each block and publishes the
+// results in atomics, the editor reads them whenever it redraws.
+class LevelMeter
+{
+public:
+    // Non-realtime
+    void prepare(double sampleRate);
+
+    // Audio thread, float or double samples
+    template <typename SampleType>
+    void measure(const SampleType* const* channels, int numChannels, int numSamples);
+
+    // Any thread: highest absolute sample since the previous call
+    float getAndResetPeak(int channel);
+
+    // Any thread: RMS over roughly the last 300 ms
+    float getRms(int channel) const { return rms[(size_t) channel].load(std::memory_order_relaxed); }
+
+private:
+    std::array<std::atomic<float>, 2> peaks{};
+    std::array<std::atomic<float>, 2> rms{};
+
+    // Audio thread
+    std::array<float, 2> meanSquares{};
+    double sampleRate{44100.0};
+};
+
+// Dry and wet envelopes for the editor's echo display. The audio thread reduces them to one point
+// (the absolute peak over both channels) per 1 / pointsPerSecond, and hands the points over through
+// a lock-free FIFO. Points that don't fit while nobody drains it are dropped.
+class EchoEnvelopeFifo
+{
+public:
+    struct Point
+    {
+        float dry, wet;
+    };
+
+    static constexpr int pointsPerSecond = 120;
+
+    // Non-realtime
+    void prepare(double sampleRate);
+
+    // Audio thread, wet may be nullptr for silence. Float or double samples.
+    template <typename SampleType>
+    void push(const SampleType* const* dry, const SampleType* const* wet, int numChannels, int numSamples);
+
+    // Reader thread, returns the number of points copied into dest
+    int pop(Point* dest, int maxPoints);
+
+private:
+    static constexpr int capacity = 1024;
+
+    template <typename SampleType>
+    static float getPeak(const SampleType* const* channels, int numChannels, int start, int numSamples);
+
+    juce::AbstractFifo fifo{capacity};
+    std::vector<Point> points = std::vector<Point>(capacity);
+
+    // Audio thread: the point being accumulated
+    Point current{0.f, 0.f};
+    int samplesPerPoint{1};
+    int samplesInPoint{0};
+};
+
+// Everything the processor publishes for the editor
+struct Metering
+{
+    // Non-realtime
+    void prepare(double sampleRate);
+
+    LevelMeter input, output;
+    EchoEnvelopeFifo echoes;
+
+    // Current echo settings, so the editor can mark where the repeats land
+    std::atomic<float> delayTimeMs{0.f};
+    std::atomic<float> feedback{0.f};
+};
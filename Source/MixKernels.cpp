@@ -0,0 +1,185 @@
+#include "MixKernels.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+ #include <emmintrin.h>
+ #define STRANGE_ECHOES_MIX_SSE 1
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+ #include <arm_neon.h>
+ #define STRANGE_ECHOES_MIX_NEON 1
+#endif
+
+namespace
+{
+    // 4 consecutive samples
+   #if STRANGE_ECHOES_MIX_SSE
+    struct Vector
+    {
+        __m128 v;
+
+        static Vector load(const float* p) noexcept             { return { _mm_loadu_ps(p) }; }
+        static Vector fill(float x) noexcept                    { return { _mm_set1_ps(x) }; }
+        static Vector lanes() noexcept                          { return { _mm_setr_ps(0.f, 1.f, 2.f, 3.f) }; }
+        void store(float* p) const noexcept                     { _mm_storeu_ps(p, v); }
+
+        Vector operator+(Vector o) const noexcept               { return { _mm_add_ps(v, o.v) }; }
+        Vector operator-(Vector o) const noexcept               { return { _mm_sub_ps(v, o.v) }; }
+        Vector operator*(Vector o) const noexcept               { return { _mm_mul_ps(v, o.v) }; }
+    };
+   #elif STRANGE_ECHOES_MIX_NEON
+    struct Vector
+    {
+        float32x4_t v;
+
+        static Vector load(const float* p) noexcept             { return { vld1q_f32(p) }; }
+        static Vector fill(float x) noexcept                    { return { vdupq_n_f32(x) }; }
+        static Vector lanes() noexcept                          { const float l[4] = { 0.f, 1.f, 2.f, 3.f }; return { vld1q_f32(l) }; }
+        void store(float* p) const noexcept                     { vst1q_f32(p, v); }
+
+        Vector operator+(Vector o) const noexcept               { return { vaddq_f32(v, o.v) }; }
+        Vector operator-(Vector o) const noexcept               { return { vsubq_f32(v, o.v) }; }
+        Vector operator*(Vector o) const noexcept               { return { vmulq_f32(v, o.v) }; }
+    };
+   #else
+    struct Vector
+    {
+        float v[4];
+
+        static Vector load(const float* p) noexcept             { return { { p[0], p[1], p[2], p[3] } }; }
+        static Vector fill(float x) noexcept                    { return { { x, x, x, x } }; }
+        static Vector lanes() noexcept                          { return { { 0.f, 1.f, 2.f, 3.f } }; }
+        void store(float* p) const noexcept                     { for (int k = 0; k < 4; ++k) p[k] = v[k]; }
+
+        Vector operator+(Vector o) const noexcept               { Vector r; for (int k = 0; k < 4; ++k) r.v[k] = v[k] + o.v[k]; return r; }
+        Vector operator-(Vector o) const noexcept               { Vector r; for (int k = 0; k < 4; ++k) r.v[k] = v[k] - o.v[k]; return r; }
+        Vector operator*(Vector o) const noexcept               { Vector r; for (int k = 0; k < 4; ++k) r.v[k] = v[k] * o.v[k]; return r; }
+    };
+   #endif
+
+    constexpr int vectorSize = 4;
+
+    // A ramp's values at samples i ... i + 3
+    struct RampVector
+    {
+        explicit RampVector(MixKernels::Ramp ramp)
+            : start(ramp.start), step(ramp.step), lanesStep(Vector::lanes() * Vector::fill(ramp.step)) {}
+
+        Vector at(int i) const noexcept     { return Vector::fill(start + step * static_cast<float>(i)) + lanesStep; }
+        float scalarAt(int i) const noexcept { return start + step * static_cast<float>(i); }
+
+        float start, step;
+        Vector lanesStep;
+    };
+}
+
+void MixKernels::crossfade(float* dest, const float* src, int numSamples, Ramp amount)
+{
+    RampVector a(amount);
+    int i = 0;
+
+    for (; i + vectorSize <= numSamples; i += vectorSize)
+    {
+        auto d = Vector::load(dest + i);
+        (d + a.at(i) * (Vector::load(src + i) - d)).store(dest + i);
+    }
+
+    for (; i < numSamples; ++i)
+        dest[i] += a.scalarAt(i) * (src[i] - dest[i]);
+}
+
+void MixKernels::feedbackAndMix(const FeedbackAndMixRun<float>& run, int numSamples)
+{
+    RampVector gLL(run.gains[0]), gRL(run.gains[1]), gLR(run.gains[2]), gRR(run.gains[3]);
+    RampVector mix(run.mix);
+
+    const float* wetL = run.wet[0];
+    const float* wetR = run.wet[1];
+    const bool hasExtra = run.extra[0] != nullptr;
+
+    int i = 0;
+
+    for (; i + vectorSize <= numSamples; i += vectorSize)
+    {
+        auto l = Vector::load(wetL + i);
+        auto r = Vector::load(wetR + i);
+
+        auto feedbackL = Vector::load(run.delay[0] + i) + l * gLL.at(i) + r * gRL.at(i);
+        auto feedbackR = Vector::load(run.delay[1] + i) + l * gLR.at(i) + r * gRR.at(i);
+
+        if (hasExtra)
+        {
+            feedbackL = feedbackL + Vector::load(run.extra[0] + i);
+            feedbackR = feedbackR + Vector::load(run.extra[1] + i);
+        }
+
+        feedbackL.store(run.delay[0] + i);
+        feedbackL.store(run.mirror[0] + i);
+        feedbackR.store(run.delay[1] + i);
+        feedbackR.store(run.mirror[1] + i);
+
+        auto m = mix.at(i);
+        auto outL = Vector::load(run.out[0] + i);
+        auto outR = Vector::load(run.out[1] + i);
+        (outL + m * (l - outL)).store(run.out[0] + i);
+        (outR + m * (r - outR)).store(run.out[1] + i);
+    }
+
+    for (; i < numSamples; ++i)
+    {
+        auto l = wetL[i];
+        auto r = wetR[i];
+
+        auto feedbackL = run.delay[0][i] + l * gLL.scalarAt(i) + r * gRL.scalarAt(i);
+        auto feedbackR = run.delay[1][i] + l * gLR.scalarAt(i) + r * gRR.scalarAt(i);
+
+        if (hasExtra)
+        {
+            feedbackL += run.extra[0][i];
+            feedbackR += run.extra[1][i];
+        }
+
+        run.delay[0][i] = run.mirror[0][i] = feedbackL;
+        run.delay[1][i] = run.mirror[1][i] = feedbackR;
+
+        auto m = mix.scalarAt(i);
+        run.out[0][i] += m * (l - run.out[0][i]);
+        run.out[1][i] += m * (r - run.out[1][i]);
+    }
+}
+
+void MixKernels::crossfade(double* dest, const double* src, int numSamples, Ramp amount)
+{
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto a = static_cast<double>(amount.start + amount.step * static_cast<float>(i));
+        dest[i] += a * (src[i] - dest[i]);
+    }
+}
+
+void MixKernels::feedbackAndMix(const FeedbackAndMixRun<double>& run, int numSamples)
+{
+    const bool hasExtra = run.extra[0] != nullptr;
+
+    auto at = [](Ramp ramp, int i) { return static_cast<double>(ramp.start + ramp.step * static_cast<float>(i)); };
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto l = run.wet[0][i];
+        auto r = run.wet[1][i];
+
+        auto feedbackL = run.delay[0][i] + l * at(run.gains[0], i) + r * at(run.gains[1], i);
+        auto feedbackR = run.delay[1][i] + l * at(run.gains[2], i) + r * at(run.gains[3], i);
+
+        if (hasExtra)
+        {
+            feedbackL += run.extra[0][i];
+            feedbackR += run.extra[1][i];
+        }
+
+        run.delay[0][i] = run.mirror[0][i] = feedbackL;
+        run.delay[1][i] = run.mirror[1][i] = feedbackR;
+
+        auto m = at(run.mix, i);
+        run.out[0][i] += m * (l - run.out[0][i]);
+        run.out[1][i] += m * (r - run.out[1][i]);
+    }
+}
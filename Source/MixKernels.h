@@ -0,0 +1,44 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Per-sample mixes for the end of processBlock. Each one is a single pass over its buffers, 4 samples
+// at a time with SSE or NEON where available, so a sample of the wet signal is loaded once for
+// everything it contributes to. The double versions, for double precision processing, are plain loops.
+namespace MixKernels
+{
+    // A gain ramped linearly over a block: start + step * i at sample i
+    struct Ramp
+    {
+        float start, step;
+
+        static Ramp between(float startValue, float endValue, int numSamples)
+        {
+            return { startValue, numSamples > 0 ? (endValue - startValue) / static_cast<float>(numSamples) : 0.f };
+        }
+
+        Ramp advancedBy(int numSamples) const { return { start + step * static_cast<float>(numSamples), step }; }
+    };
+
+    // dest[i] += amount * (src[i] - dest[i])
+    void crossfade(float* dest, const float* src, int numSamples, Ramp amount);
+    void crossfade(double* dest, const double* src, int numSamples, Ramp amount);
+
+    // Stereo feedback write and dry/wet output over one contiguous run of a delay line:
+    //   delay[c][i] += wet[0][i] * gains[2c] + wet[1][i] * gains[2c + 1] + extra[c][i], also stored to mirror[c][i]
+    //   out[c][i]   += mix * (wet[c][i] - out[c][i])
+    template <typename SampleType>
+    struct FeedbackAndMixRun
+    {
+        const SampleType* wet[2];
+        const SampleType* extra[2]; // added to the feedback as is, both nullptr for none
+        SampleType* delay[2];
+        SampleType* mirror[2];
+        SampleType* out[2];
+        Ramp gains[4];              // left to left, right to left, left to right, right to right
+        Ramp mix;
+    };
+
+    void feedbackAndMix(const FeedbackAndMixRun<float>& run, int numSamples);
+    void feedbackAndMix(const FeedbackAndMixRun<double>& run, int numSamples);
+}
@@ -0,0 +1,254 @@
+#include "ModulatedDelayLine.h"
+#include "MixKernels.h"
+#include <algorithm>
+#include <utility>
+
+template <typename SampleType>
+void ModulatedDelayLine<SampleType>::prepare(int numChannels, int maximumDelayInSamples, int maximumBlockSize)
+{
+    jassert(maximumDelayInSamples >= 1 && maximumBlockSize > 0);
+
+    // Holds the oldest interpolation point of the longest delay after the current block is written
+    this->capacity = maximumDelayInSamples + maximumBlockSize + guardSamples;
+
+    this->mirrored.assign(static_cast<size_t>(numChannels), std::vector<SampleType>(static_cast<size_t>(2 * this->capacity), SampleType()));
+    this->allpassState.assign(static_cast<size_t>(numChannels), SampleType());
+
+    this->baseIndices.assign(static_cast<size_t>(maximumBlockSize), 0);
+    this->fractions.assign(static_cast<size_t>(maximumBlockSize), SampleType());
+
+    reset();
+}
+
+template <typename SampleType>
+void ModulatedDelayLine<SampleType>::reset()
+{
+    for (auto& buffer : this->mirrored)
+        std::fill(buffer.begin(), buffer.end(), SampleType());
+
+    std::fill(this->allpassState.begin(), this->allpassState.end(), SampleType());
+    this->writePos = 0;
+}
+
+template <typename SampleType>
+void ModulatedDelayLine<SampleType>::setInterpolation(DelayInterpolation newInterpolation)
+{
+    if (newInterpolation == this->interpolation)
+        return;
+
+    this->interpolation = newInterpolation;
+    std::fill(this->allpassState.begin(), this->allpassState.end(), SampleType());
+}
+
+template <typename SampleType>
+void ModulatedDelayLine<SampleType>::write(int channel, const SampleType* in, int numSamples)
+{
+    writeMirrored(channel, this->writePos, in, numSamples, 1.f, 1.f, true);
+}
+
+template <typename SampleType>
+void ModulatedDelayLine<SampleType>::addWithRamp(int channel, const SampleType* in, int numSamples, float startGain, float endGain)
+{
+    writeMirrored(channel, this->writePos, in, numSamples, startGain, endGain, false);
+}
+
+template <typename SampleType>
+void ModulatedDelayLine<SampleType>::addFeedbackAndMix(const SampleType* const* wet, const SampleType* const* extraFeedback, int numSamples,
+                                           const std::array<float, 4>& startGains, const std::array<float, 4>& endGains,
+                                           SampleType* const* out, float startMix, float endMix)
+{
+    jassert(this->mirrored.size() >= 2);
+
+    MixKernels::FeedbackAndMixRun<SampleType> run;
+
+    for (size_t j = 0; j < 4; ++j)
+        run.gains[j] = MixKernels::Ramp::between(startGains[j], endGains[j], numSamples);
+
+    run.mix = MixKernels::Ramp::between(startMix, endMix, numSamples);
+
+    // At most two contiguous runs, either side of the end of the buffer
+    auto numToEnd = std::min(numSamples, this->capacity - this->writePos);
+    int done = 0;
+
+    for (auto [writeStart, num] : { std::pair<int, int>(this->writePos, numToEnd), std::pair<int, int>(0, numSamples - numToEnd) })
+    {
+        if (num <= 0)
+            continue;
+
+        for (int c = 0; c < 2; ++c)
+        {
+            run.wet[c] = wet[c] + done;
+            run.extra[c] = extraFeedback != nullptr ? extraFeedback[c] + done : nullptr;
+            run.delay[c] = this->mirrored[(size_t) c].data() + writeStart;
+            run.mirror[c] = run.delay[c] + this->capacity;
+            run.out[c] = out[c] + done;
+        }
+
+        MixKernels::feedbackAndMix(run, num);
+
+        for (auto& gain : run.gains)
+            gain = gain.advancedBy(num);
+
+        run.mix = run.mix.advancedBy(num);
+        done += num;
+    }
+}
+
+template <typename SampleType>
+void ModulatedDelayLine<SampleType>::writeMirrored(int channel, int start, const SampleType* in, int numSamples, float startGain, float endGain, bool replacing)
+{
+    SampleType* data = this->mirrored[(size_t) channel].data();
+    auto numToEnd = std::min(numSamples, this->capacity - start);
+    auto gainStep = numSamples > 0 ? (endGain - startGain) / static_cast<float>(numSamples) : 0.f;
+
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto index = i < numToEnd ? start + i : start + i - this->capacity;
+        auto value = replacing ? in[i] : data[index] + in[i] * (startGain + gainStep * static_cast<float>(i));
+
+        data[index] = value;
+        data[index + this->capacity] = value;
+    }
+}
+
+template <typename SampleType>
+void ModulatedDelayLine<SampleType>::read(int channel, const float* delayInSamples, SampleType* out, int numSamples)
+{
+    jassert(numSamples <= static_cast<int>(this->baseIndices.size()));
+
+    const SampleType* x = this->mirrored[(size_t) channel].data();
+    int* base = this->baseIndices.data();
+    SampleType* frac = this->fractions.data();
+
+    // Sample i of the block sits at writePos + i; its delayed value lies between base[i] and
+    // base[i] + 1 at frac[i]. Splitting the delay into whole and fractional parts keeps the
+    // fraction exact however large the buffer index gets.
+    for (int i = 0; i < numSamples; ++i)
+    {
+        auto whole = static_cast<int>(delayInSamples[i]);
+        auto index = this->writePos + i - whole - 1;
+
+        base[i] = index < 1 ? index + this->capacity : index;
+        frac[i] = 1.f - (delayInSamples[i] - static_cast<float>(whole));
+    }
+
+    switch (this->interpolation)
+    {
+        case DelayInterpolation::linear:
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const SampleType* p = x + base[i];
+                out[i] = p[0] + frac[i] * (p[1] - p[0]);
+            }
+            break;
+
+        case DelayInterpolation::hermite:
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const SampleType* p = x + base[i];
+                auto f = frac[i];
+                auto c1 = 0.5f * (p[1] - p[-1]);
+                auto c2 = p[-1] - 2.5f * p[0] + 2.f * p[1] - 0.5f * p[2];
+                auto c3 = 0.5f * (p[2] - p[-1]) + 1.5f * (p[0] - p[1]);
+                out[i] = ((c3 * f + c2) * f + c1) * f + p[0];
+            }
+            break;
+
+        case DelayInterpolation::lagrange:
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const SampleType* p = x + base[i];
+                auto f = frac[i];
+                auto fPlus1 = f + 1.f, fMinus1 = f - 1.f, fMinus2 = f - 2.f;
+                auto h0 = -f * fMinus1 * fMinus2 * (1.f / 6.f);
+                auto h1 = fPlus1 * fMinus1 * fMinus2 * 0.5f;
+                auto h2 = -fPlus1 * f * fMinus2 * 0.5f;
+                auto h3 = fPlus1 * f * fMinus1 * (1.f / 6.f);
+                out[i] = h0 * p[-1] + h1 * p[0] + h2 * p[1] + h3 * p[2];
+            }
+            break;
+
+        case DelayInterpolation::allpass:
+        {
+            // Delay behind the newer point kept within 0.618 ... 1.618, away from the pole at -1
+            SampleType previous = this->allpassState[(size_t) channel];
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                const SampleType* p = x + base[i] + 1;
+                auto delta = 1.f - frac[i];
+
+                if (delta < 0.618f)
+                {
+                    delta += 1.f;
+                    ++p;
+                }
+
+                auto a = (1.f - delta) / (1.f + delta);
+                previous = a * p[0] + p[-1] - a * previous;
+                out[i] = previous;
+            }
+
+            this->allpassState[(size_t) channel] = previous;
+            break;
+        }
+    }
+}
+
+template <typename SampleType>
+void ModulatedDelayLine<SampleType>::addTaps(int channel, const DelayTap* taps, int numTaps, SampleType* out, int numSamples)
+{
+    const SampleType* x = this->mirrored[(size_t) channel].data();
+    auto blockStep = numSamples > 0 ? 1.f / static_cast<float>(numSamples) : 0.f;
+
+    for (int k = 0; k < numTaps; ++k)
+    {
+        const auto& tap = taps[k];
+
+        if (tap.startGain == 0.f && tap.endGain == 0.f)
+            continue;
+
+        auto gainStep = (tap.endGain - tap.startGain) * blockStep;
+
+        if (tap.startDelay == tap.endDelay)
+        {
+            // Same split into base index and fraction as read(), once for the whole block. The mirror
+            // keeps base + numSamples inside the buffer.
+            auto whole = static_cast<int>(tap.startDelay);
+            auto index = this->writePos - whole - 1;
+            auto frac = 1.f - (tap.startDelay - static_cast<float>(whole));
+
+            const SampleType* p = x + (index < 1 ? index + this->capacity : index);
+
+            for (int i = 0; i < numSamples; ++i)
+                out[i] += (tap.startGain + gainStep * static_cast<float>(i)) * (p[i] + frac * (p[i + 1] - p[i]));
+        }
+        else
+        {
+            auto delayStep = (tap.endDelay - tap.startDelay) * blockStep;
+
+            for (int i = 0; i < numSamples; ++i)
+            {
+                auto delay = tap.startDelay + delayStep * static_cast<float>(i);
+                auto whole = static_cast<int>(delay);
+                auto index = this->writePos + i - whole - 1;
+                auto frac = 1.f - (delay - static_cast<float>(whole));
+
+                const SampleType* p = x + (index < 1 ? index + this->capacity : index);
+                out[i] += (tap.startGain + gainStep * static_cast<float>(i)) * (p[0] + frac * (p[1] - p[0]));
+            }
+        }
+    }
+}
+
+template <typename SampleType>
+void ModulatedDelayLine<SampleType>::advance(int numSamples)
+{
+    this->writePos += numSamples;
+
+    if (this->writePos >= this->capacity)
+        this->writePos -= this->capacity;
+}
+
+template class ModulatedDelayLine<float>;
+template class ModulatedDelayLine<double>;
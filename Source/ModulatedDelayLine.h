@@ -0,0 +1,89 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <vector>
+
+enum class DelayInterpolation
+{
+    linear,     // 2 points
+    hermite,    // 4 point cubic Hermite (Catmull-Rom)
+    lagrange,   // 4 point 3rd order Lagrange
+    allpass     // 1st order allpass, flat magnitude but best for slow modulation
+};
+
+// One tap for ModulatedDelayLine::addTaps, its delay and gain ramped linearly over the block
+struct DelayTap
+{
+    float startDelay{1.f}, endDelay{1.f};   // in samples, 1 ... maximumDelayInSamples
+    float startGain{0.f}, endGain{0.f};
+};
+
+// Multichannel delay line read at a fractional delay given for every sample, so modulation
+// does not depend on the host block size.
+//
+// Each channel is stored twice back to back (mirrored), so every interpolation point of a read is
+// at a plain offset from one base index with no wrap checks. A read first computes the base
+// indices and fractions for the whole block, then runs the interpolation over them.
+//
+// Per block: write() the input, read() any number of times, optionally addWithRamp() feedback into
+// the block just written, then advance().
+//
+// SampleType is the stored and interpolated sample, float or double. Delays and gains are float either
+// way.
+template <typename SampleType>
+class ModulatedDelayLine
+{
+public:
+    // Non-realtime
+    void prepare(int numChannels, int maximumDelayInSamples, int maximumBlockSize);
+    void reset();
+
+    void setInterpolation(DelayInterpolation newInterpolation);
+    DelayInterpolation getInterpolation() const { return interpolation; }
+
+    // Replaces the current block of a channel
+    void write(int channel, const SampleType* in, int numSamples);
+
+    // Adds into the current block of a channel with a linear gain ramp
+    void addWithRamp(int channel, const SampleType* in, int numSamples, float startGain, float endGain);
+
+    // Stereo only: adds a 2x2 mix of both wet channels into the current block of both channels, each
+    // of the four gains { left to left, right to left, left to right, right to right } ramped linearly
+    // from startGains to endGains, plus extraFeedback (or nullptr) unscaled, fused with the dry/wet
+    // output mix out[c] += mix * (wet[c] - out[c]), mix ramped from startMix to endMix.
+    // Every wet sample is loaded once for both, see MixKernels::feedbackAndMix.
+    void addFeedbackAndMix(const SampleType* const* wet, const SampleType* const* extraFeedback, int numSamples,
+                           const std::array<float, 4>& startGains, const std::array<float, 4>& endGains,
+                           SampleType* const* out, float startMix, float endMix);
+
+    // out[i] is the input of sample i of the current block delayed by delayInSamples[i], which must be
+    // within 1 ... maximumDelayInSamples. Delays below numSamples read parts of the current block.
+    void read(int channel, const float* delayInSamples, SampleType* out, int numSamples);
+
+    // Adds numTaps taps of the same buffer to out, linearly interpolated whatever the interpolation
+    // mode. A tap whose delay doesn't move over the block is one contiguous run at a fixed fraction.
+    void addTaps(int channel, const DelayTap* taps, int numTaps, SampleType* out, int numSamples);
+
+    void advance(int numSamples);
+
+    int getMaximumDelayInSamples() const { return capacity - guardSamples; }
+
+private:
+    void writeMirrored(int channel, int start, const SampleType* in, int numSamples, float startGain, float endGain, bool replacing);
+
+    // Interpolation points run from base - 1 to base + 2
+    static constexpr int guardSamples = 4;
+
+    std::vector<std::vector<SampleType>> mirrored;  // per channel, 2 * capacity
+    std::vector<SampleType> allpassState;           // per channel, previous allpass output
+
+    // Per read scratch
+    std::vector<int> baseIndices;
+    std::vector<SampleType> fractions;
+
+    DelayInterpolation interpolation{DelayInterpolation::hermite};
+
+    int capacity{0};
+    int writePos{0};
+};
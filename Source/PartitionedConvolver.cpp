@@ -0,0 +1,145 @@
+#include "PartitionedConvolver.h"
+#include <algorithm>
+#include <cstring>
+
+void PartitionedConvolver::prepare(const float* kernel, int kernelSize, int partitionSize, int numChannels)
+{
+    jassert(juce::isPowerOfTwo(partitionSize) && kernelSize > 0);
+
+    this->blockSize = partitionSize;
+    this->numBins = partitionSize + 1;
+    this->numPartitions = (kernelSize + partitionSize - 1) / partitionSize;
+
+    const int fftSize = 2 * partitionSize;
+    this->fft = std::make_unique<juce::dsp::FFT>(juce::exactLog2(fftSize));
+    this->fftBuffer.assign(static_cast<size_t>(2 * fftSize), 0.f);
+
+    const auto spectrumSize = static_cast<size_t>(this->numPartitions * this->numBins);
+    this->kernelRe.assign(spectrumSize, 0.f);
+    this->kernelIm.assign(spectrumSize, 0.f);
+
+    // Each partition zero padded to the FFT size
+    for (int p = 0; p < this->numPartitions; ++p)
+    {
+        std::fill(this->fftBuffer.begin(), this->fftBuffer.end(), 0.f);
+
+        auto start = p * partitionSize;
+        auto num = std::min(partitionSize, kernelSize - start);
+        std::copy(kernel + start, kernel + start + num, this->fftBuffer.begin());
+
+        this->fft->performRealOnlyForwardTransform(this->fftBuffer.data(), true);
+
+        for (int k = 0; k < this->numBins; ++k)
+        {
+            this->kernelRe[(size_t) (p * this->numBins + k)] = this->fftBuffer[(size_t) (2 * k)];
+            this->kernelIm[(size_t) (p * this->numBins + k)] = this->fftBuffer[(size_t) (2 * k + 1)];
+        }
+    }
+
+    this->sumRe.assign((size_t) this->numBins, 0.f);
+    this->sumIm.assign((size_t) this->numBins, 0.f);
+
+    this->channels.resize((size_t) numChannels);
+
+    for (auto& channel : this->channels)
+    {
+        channel.input.assign(static_cast<size_t>(2 * partitionSize), 0.f);
+        channel.output.assign(static_cast<size_t>(partitionSize), 0.f);
+        channel.spectraRe.assign(spectrumSize, 0.f);
+        channel.spectraIm.assign(spectrumSize, 0.f);
+    }
+
+    reset();
+}
+
+void PartitionedConvolver::reset()
+{
+    for (auto& channel : this->channels)
+    {
+        std::fill(channel.input.begin(), channel.input.end(), 0.f);
+        std::fill(channel.output.begin(), channel.output.end(), 0.f);
+        std::fill(channel.spectraRe.begin(), channel.spectraRe.end(), 0.f);
+        std::fill(channel.spectraIm.begin(), channel.spectraIm.end(), 0.f);
+        channel.fill = 0;
+        channel.newestSpectrum = 0;
+    }
+}
+
+void PartitionedConvolver::process(int channelIndex, const float* in, float* out, int numSamples)
+{
+    auto& channel = this->channels[(size_t) channelIndex];
+    int done = 0;
+
+    while (done < numSamples)
+    {
+        auto num = std::min(this->blockSize - channel.fill, numSamples - done);
+
+        // Read the input before writing the output so in-place processing works
+        std::memcpy(channel.input.data() + this->blockSize + channel.fill, in + done, sizeof(float) * (size_t) num);
+        std::memcpy(out + done, channel.output.data() + channel.fill, sizeof(float) * (size_t) num);
+
+        channel.fill += num;
+        done += num;
+
+        if (channel.fill == this->blockSize)
+        {
+            processPartition(channel);
+            channel.fill = 0;
+        }
+    }
+}
+
+void PartitionedConvolver::processPartition(Channel& channel)
+{
+    const int bins = this->numBins;
+    const int fftSize = 2 * this->blockSize;
+
+    // Spectrum of the last two partitions of input
+    std::copy(channel.input.begin(), channel.input.end(), this->fftBuffer.begin());
+    std::fill(this->fftBuffer.begin() + fftSize, this->fftBuffer.end(), 0.f);
+    this->fft->performRealOnlyForwardTransform(this->fftBuffer.data(), true);
+
+    channel.newestSpectrum = (channel.newestSpectrum + 1) % this->numPartitions;
+    float* newestRe = channel.spectraRe.data() + channel.newestSpectrum * bins;
+    float* newestIm = channel.spectraIm.data() + channel.newestSpectrum * bins;
+
+    for (int k = 0; k < bins; ++k)
+    {
+        newestRe[k] = this->fftBuffer[(size_t) (2 * k)];
+        newestIm[k] = this->fftBuffer[(size_t) (2 * k + 1)];
+    }
+
+    // Sum over partitions of kernel spectrum p times the input spectrum from p partitions ago
+    std::fill(this->sumRe.begin(), this->sumRe.end(), 0.f);
+    std::fill(this->sumIm.begin(), this->sumIm.end(), 0.f);
+
+    float* accRe = this->sumRe.data();
+    float* accIm = this->sumIm.data();
+
+    for (int p = 0; p < this->numPartitions; ++p)
+    {
+        auto slot = (channel.newestSpectrum - p + this->numPartitions) % this->numPartitions;
+        const float* xRe = channel.spectraRe.data() + slot * bins;
+        const float* xIm = channel.spectraIm.data() + slot * bins;
+        const float* hRe = this->kernelRe.data() + p * bins;
+        const float* hIm = this->kernelIm.data() + p * bins;
+
+        for (int k = 0; k < bins; ++k)
+        {
+            accRe[k] += hRe[k] * xRe[k] - hIm[k] * xIm[k];
+            accIm[k] += hRe[k] * xIm[k] + hIm[k] * xRe[k];
+        }
+    }
+
+    for (int k = 0; k < bins; ++k)
+    {
+        this->fftBuffer[(size_t) (2 * k)] = accRe[k];
+        this->fftBuffer[(size_t) (2 * k + 1)] = accIm[k];
+    }
+
+    this->fft->performRealOnlyInverseTransform(this->fftBuffer.data());
+
+    // Overlap-save: only the second half of the circular convolution is valid
+    std::copy(this->fftBuffer.begin() + this->blockSize, this->fftBuffer.begin() + fftSize, channel.output.begin());
+    std::copy(channel.input.begin() + this->blockSize, channel.input.end(), channel.input.begin());
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <memory>
+#include <vector>
+
+// Uniformly partitioned overlap-save convolution with one long FIR kernel, for any number of
+// channels sharing that kernel. The kernel is split into partitions of partitionSize taps whose
+// spectra are precomputed; every partitionSize input samples cost one forward and one inverse
+// FFT of 2 * partitionSize plus one complex multiply-add per partition and bin, so the cost per
+// sample grows with kernelSize / partitionSize instead of kernelSize.
+//
+// Output is delayed by partitionSize samples on top of the kernel's own delay.
+struct PartitionedConvolver
+{
+    // Non-realtime. partitionSize must be a power of two.
+    void prepare(const float* kernel, int kernelSize, int partitionSize, int numChannels);
+    void reset();
+
+    // In-place use (out == in) is allowed. All channels must be fed the same number of samples.
+    void process(int channel, const float* in, float* out, int numSamples);
+
+    int getLatencyInSamples() const { return blockSize; }
+
+private:
+    struct Channel
+    {
+        std::vector<float> input;       // previous and current partition, 2 * blockSize
+        std::vector<float> output;      // last computed output partition, blockSize
+        std::vector<float> spectraRe;   // frequency domain delay line, numPartitions * numBins
+        std::vector<float> spectraIm;
+        int fill{0};
+        int newestSpectrum{0};
+    };
+
+    void processPartition(Channel& channel);
+
+    std::unique_ptr<juce::dsp::FFT> fft;
+
+    std::vector<float> kernelRe, kernelIm;  // numPartitions * numBins
+    std::vector<float> fftBuffer;           // 2 * fftSize, as juce::dsp::FFT requires
+    std::vector<float> sumRe, sumIm;        // numBins
+
+    std::vector<Channel> channels;
+
+    int blockSize{0};
+    int numBins{0};
+    int numPartitions{0};
+};
@@ -0,0 +1,282 @@
+#include "RealtimeAudit.h"
+
+#if STRANGE_ECHOES_RT_AUDIT
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+#if JUCE_LINUX
+ #include <dlfcn.h>
+ #include <pthread.h>
+#elif JUCE_WINDOWS
+ #include <malloc.h>
+#endif
+
+namespace
+{
+    // Plain thread_local PODs: no constructors, so touching them never allocates
+    thread_local int realtimeDepth = 0;
+    thread_local int allowanceDepth = 0;
+    thread_local bool isReporting = false;
+    thread_local bool hasTrappedInSection = false;
+
+    std::atomic<juce::uint64> numAllocations { 0 }, numDeallocations { 0 }, numLocks { 0 }, numTraps { 0 };
+    std::atomic<int> firstViolation { -1 };
+    std::atomic<bool> trapOnViolation { false };
+
+   #if JUCE_LINUX && defined(__GLIBC__)
+    extern "C" void* __libc_malloc(size_t) noexcept;
+    extern "C" void* __libc_calloc(size_t, size_t) noexcept;
+    extern "C" void* __libc_realloc(void*, size_t) noexcept;
+    extern "C" void* __libc_memalign(size_t, size_t) noexcept;
+    extern "C" void  __libc_free(void*) noexcept;
+
+    void* rawAlloc(size_t size)                     { return __libc_malloc(size); }
+    void* rawAlignedAlloc(size_t size, size_t align) { return __libc_memalign(align, size); }
+    void  rawFree(void* p)                          { __libc_free(p); }
+    void  rawAlignedFree(void* p)                   { __libc_free(p); }
+   #elif JUCE_WINDOWS
+    void* rawAlloc(size_t size)                     { return std::malloc(size); }
+    void* rawAlignedAlloc(size_t size, size_t align) { return _aligned_malloc(size, align); }
+    void  rawFree(void* p)                          { std::free(p); }
+    void  rawAlignedFree(void* p)                   { _aligned_free(p); }
+   #else
+    void* rawAlloc(size_t size)                     { return std::malloc(size); }
+    void* rawAlignedAlloc(size_t size, size_t align) { return std::aligned_alloc(align, (size + align - 1) / align * align); }
+    void  rawFree(void* p)                          { std::free(p); }
+    void  rawAlignedFree(void* p)                   { std::free(p); }
+   #endif
+
+    void* allocate(size_t size)
+    {
+        RealtimeAudit::notify(RealtimeAudit::Violation::allocation);
+        return rawAlloc(size == 0 ? 1 : size);
+    }
+
+    void* allocateAligned(size_t size, std::align_val_t align)
+    {
+        RealtimeAudit::notify(RealtimeAudit::Violation::allocation);
+        return rawAlignedAlloc(size == 0 ? 1 : size, static_cast<size_t>(align));
+    }
+
+    void deallocate(void* p)
+    {
+        if (p != nullptr)
+        {
+            RealtimeAudit::notify(RealtimeAudit::Violation::deallocation);
+            rawFree(p);
+        }
+    }
+
+    void deallocateAligned(void* p)
+    {
+        if (p != nullptr)
+        {
+            RealtimeAudit::notify(RealtimeAudit::Violation::deallocation);
+            rawAlignedFree(p);
+        }
+    }
+}
+
+//==============================================================================
+juce::String RealtimeAudit::Report::toString() const
+{
+    auto text = "allocations: " + juce::String(allocations)
+              + ", deallocations: " + juce::String(deallocations)
+              + ", locks: " + juce::String(locks);
+
+    if (! isClean())
+        text << ", first: " << getViolationName(firstViolation);
+
+    return text;
+}
+
+const char* RealtimeAudit::getViolationName(Violation violation) noexcept
+{
+    switch (violation)
+    {
+        case Violation::allocation:   return "allocation";
+        case Violation::deallocation: return "deallocation";
+        case Violation::lock:         return "lock";
+    }
+
+    return "";
+}
+
+RealtimeAudit::ScopedRealtimeSection::ScopedRealtimeSection() noexcept
+{
+    if (realtimeDepth++ == 0)
+        hasTrappedInSection = false;
+}
+
+RealtimeAudit::ScopedRealtimeSection::~ScopedRealtimeSection() noexcept { --realtimeDepth; }
+
+RealtimeAudit::ScopedAllowance::ScopedAllowance() noexcept  { ++allowanceDepth; }
+RealtimeAudit::ScopedAllowance::~ScopedAllowance() noexcept { --allowanceDepth; }
+
+bool RealtimeAudit::isInRealtimeSection() noexcept
+{
+    return realtimeDepth > 0 && allowanceDepth == 0 && ! isReporting;
+}
+
+void RealtimeAudit::notify(Violation violation) noexcept
+{
+    if (! isInRealtimeSection())
+        return;
+
+    switch (violation)
+    {
+        case Violation::allocation:   numAllocations.fetch_add(1, std::memory_order_relaxed);   break;
+        case Violation::deallocation: numDeallocations.fetch_add(1, std::memory_order_relaxed); break;
+        case Violation::lock:         numLocks.fetch_add(1, std::memory_order_relaxed);         break;
+    }
+
+    // Only the first one is kept, later violations are just counted
+    auto none = -1;
+    firstViolation.compare_exchange_strong(none, static_cast<int>(violation), std::memory_order_relaxed);
+
+    if (trapOnViolation.load(std::memory_order_relaxed) && ! hasTrappedInSection)
+    {
+        hasTrappedInSection = true;
+        numTraps.fetch_add(1, std::memory_order_relaxed);
+
+        // The assertion handler may allocate or lock itself, so stop auditing while it runs
+        isReporting = true;
+        jassertfalse;
+        isReporting = false;
+    }
+}
+
+RealtimeAudit::Report RealtimeAudit::getReport() noexcept
+{
+    Report report;
+    report.allocations   = numAllocations.load();
+    report.deallocations = numDeallocations.load();
+    report.locks         = numLocks.load();
+    report.traps         = numTraps.load();
+
+    auto first = firstViolation.load();
+    if (first >= 0)
+        report.firstViolation = static_cast<Violation>(first);
+
+    return report;
+}
+
+void RealtimeAudit::resetReport() noexcept
+{
+    numAllocations = 0;
+    numDeallocations = 0;
+    numLocks = 0;
+    numTraps = 0;
+    firstViolation = -1;
+}
+
+void RealtimeAudit::setTrapOnViolation(bool shouldTrap) noexcept
+{
+    trapOnViolation = shouldTrap;
+}
+
+//==============================================================================
+void* operator new(size_t size)
+{
+    if (auto* p = allocate(size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+    if (auto* p = allocate(size))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, std::align_val_t align)
+{
+    if (auto* p = allocateAligned(size, align))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new[](size_t size, std::align_val_t align)
+{
+    if (auto* p = allocateAligned(size, align))
+        return p;
+
+    throw std::bad_alloc();
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept                             { return allocate(size); }
+void* operator new[](size_t size, const std::nothrow_t&) noexcept                           { return allocate(size); }
+void* operator new(size_t size, std::align_val_t align, const std::nothrow_t&) noexcept     { return allocateAligned(size, align); }
+void* operator new[](size_t size, std::align_val_t align, const std::nothrow_t&) noexcept   { return allocateAligned(size, align); }
+
+void operator delete(void* p) noexcept                                          { deallocate(p); }
+void operator delete[](void* p) noexcept                                        { deallocate(p); }
+void operator delete(void* p, size_t) noexcept                                  { deallocate(p); }
+void operator delete[](void* p, size_t) noexcept                                { deallocate(p); }
+void operator delete(void* p, const std::nothrow_t&) noexcept                   { deallocate(p); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept                 { deallocate(p); }
+void operator delete(void* p, std::align_val_t) noexcept                        { deallocateAligned(p); }
+void operator delete[](void* p, std::align_val_t) noexcept                      { deallocateAligned(p); }
+void operator delete(void* p, size_t, std::align_val_t) noexcept                { deallocateAligned(p); }
+void operator delete[](void* p, size_t, std::align_val_t) noexcept              { deallocateAligned(p); }
+void operator delete(void* p, std::align_val_t, const std::nothrow_t&) noexcept   { deallocateAligned(p); }
+void operator delete[](void* p, std::align_val_t, const std::nothrow_t&) noexcept { deallocateAligned(p); }
+
+//==============================================================================
+#if JUCE_LINUX && defined(__GLIBC__)
+extern "C"
+{
+    void* malloc(size_t size) noexcept
+    {
+        RealtimeAudit::notify(RealtimeAudit::Violation::allocation);
+        return __libc_malloc(size);
+    }
+
+    void* calloc(size_t count, size_t size) noexcept
+    {
+        RealtimeAudit::notify(RealtimeAudit::Violation::allocation);
+        return __libc_calloc(count, size);
+    }
+
+    void* realloc(void* p, size_t size) noexcept
+    {
+        RealtimeAudit::notify(RealtimeAudit::Violation::allocation);
+        return __libc_realloc(p, size);
+    }
+
+    void free(void* p) noexcept
+    {
+        if (p != nullptr)
+            RealtimeAudit::notify(RealtimeAudit::Violation::deallocation);
+
+        __libc_free(p);
+    }
+
+    int pthread_mutex_lock(pthread_mutex_t* mutex) noexcept
+    {
+        using LockFunction = int (*)(pthread_mutex_t*);
+
+        // Safe as a function-local static: a constant-initialised atomic has no initialisation guard,
+        // which could itself take a lock
+        static std::atomic<LockFunction> realLock { nullptr };
+        auto lock = realLock.load(std::memory_order_acquire);
+
+        if (lock == nullptr)
+        {
+            lock = reinterpret_cast<LockFunction>(dlsym(RTLD_NEXT, "pthread_mutex_lock"));
+            realLock.store(lock, std::memory_order_release);
+        }
+
+        RealtimeAudit::notify(RealtimeAudit::Violation::lock);
+        return lock(mutex);
+    }
+}
+#endif
+
+#endif
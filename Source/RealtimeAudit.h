@@ -0,0 +1,75 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+
+// Realtime-safety audit for debug builds (STRANGE_ECHOES_RT_AUDIT=1).
+// While a thread is inside a realtime section (processBlock), heap allocations,
+// frees and mutex locks made on that thread are counted and can optionally trap.
+// operator new/delete are replaced everywhere; malloc/free and pthread_mutex_lock
+// are interposed on Linux. RealtimeAudit.cpp is only ever built into the headless
+// benchmark harness, never into the plugin, so a shipped binary keeps the host's
+// allocator whatever the build options.
+
+#ifndef STRANGE_ECHOES_RT_AUDIT
+ #define STRANGE_ECHOES_RT_AUDIT 0
+#endif
+
+namespace RealtimeAudit
+{
+    enum class Violation
+    {
+        allocation,
+        deallocation,
+        lock
+    };
+
+    const char* getViolationName(Violation violation) noexcept;
+
+    struct Report
+    {
+        juce::uint64 allocations{0}, deallocations{0}, locks{0};
+
+        // Kind of the first violation since the last resetReport(), valid when ! isClean()
+        Violation firstViolation{Violation::allocation};
+
+        // Sections that hit the trap, see setTrapOnViolation()
+        juce::uint64 traps{0};
+
+        bool isClean() const { return allocations == 0 && deallocations == 0 && locks == 0; }
+        juce::String toString() const;
+    };
+
+    // Marks the calling thread as realtime for the lifetime of the object, may be nested
+    struct ScopedRealtimeSection
+    {
+        ScopedRealtimeSection() noexcept;
+        ~ScopedRealtimeSection() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedRealtimeSection)
+    };
+
+    // Temporarily allows allocations/locks inside a realtime section (e.g. a known, accepted call)
+    struct ScopedAllowance
+    {
+        ScopedAllowance() noexcept;
+        ~ScopedAllowance() noexcept;
+
+        JUCE_DECLARE_NON_COPYABLE(ScopedAllowance)
+    };
+
+    bool isInRealtimeSection() noexcept;
+    void notify(Violation violation) noexcept;
+
+    Report getReport() noexcept;
+    void resetReport() noexcept;
+
+    // When enabled, the first violation in each outermost section hits jassertfalse so it stops in
+    // the debugger; later ones in the same section are only counted
+    void setTrapOnViolation(bool shouldTrap) noexcept;
+}
+
+#if STRANGE_ECHOES_RT_AUDIT
+ #define STRANGE_ECHOES_REALTIME_SECTION    RealtimeAudit::ScopedRealtimeSection realtimeAuditSection
+#else
+ #define STRANGE_ECHOES_REALTIME_SECTION
+#endif
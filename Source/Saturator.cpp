@@ -0,0 +1,109 @@
+#include "Saturator.h"
+
+void Saturator::prepare(int numChannels, double sampleRate, int maximumBlockSize)
+{
+    this->amount.reset(sampleRate, 0.02);
+
+    for (size_t i = 0; i < this->oversamplers.size(); ++i)
+    {
+        // Factor is the number of 2x stages, latency rounded up to whole samples so it can be
+        // taken off the delay time exactly
+        this->oversamplers[i] = std::make_unique<juce::dsp::Oversampling<float>>(
+            static_cast<size_t>(numChannels), i + 1, juce::dsp::Oversampling<float>::filterHalfBandPolyphaseIIR, true, true);
+
+        this->oversamplers[i]->initProcessing(static_cast<size_t>(maximumBlockSize));
+    }
+}
+
+void Saturator::reset()
+{
+    for (auto& oversampler : this->oversamplers)
+        if (oversampler != nullptr)
+            oversampler->reset();
+
+    this->amount.setCurrentAndTargetValue(this->amount.getTargetValue());
+}
+
+void Saturator::setOversampling(Oversampling newOversampling)
+{
+    if (newOversampling == this->oversampling)
+        return;
+
+    this->oversampling = newOversampling;
+
+    if (auto* oversampler = getOversampler())
+        oversampler->reset();
+}
+
+void Saturator::setEnabled(bool shouldBeEnabled)
+{
+    this->amount.setTargetValue(shouldBeEnabled ? 1.f : 0.f);
+}
+
+int Saturator::getLatencyInSamples() const
+{
+    auto* oversampler = getOversampler();
+    return oversampler != nullptr ? juce::roundToInt(oversampler->getLatencyInSamples()) : 0;
+}
+
+void Saturator::process(float* const* channels, int numChannels, int numSamples, float startDrive, float endDrive)
+{
+    auto* oversampler = getOversampler();
+    auto startAmount = this->amount.getCurrentValue();
+    auto endAmount = this->amount.skip(numSamples);
+    auto shaping = startAmount != 0.f || endAmount != 0.f;
+
+    if (oversampler == nullptr)
+    {
+        if (shaping)
+            shape(channels, numChannels, numSamples, startDrive, endDrive, startAmount, endAmount);
+
+        return;
+    }
+
+    // Run while off too, so the latency stays put
+    juce::dsp::AudioBlock<float> block(channels, static_cast<size_t>(numChannels), static_cast<size_t>(numSamples));
+    auto oversampled = oversampler->processSamplesUp(block);
+
+    if (shaping)
+    {
+        float* oversampledChannels[2] = { oversampled.getChannelPointer(0), numChannels > 1 ? oversampled.getChannelPointer(1) : nullptr };
+        shape(oversampledChannels, numChannels, static_cast<int>(oversampled.getNumSamples()), startDrive, endDrive, startAmount, endAmount);
+    }
+
+    oversampler->processSamplesDown(block);
+}
+
+void Saturator::shape(float* const* channels, int numChannels, int numSamples, float startDrive, float endDrive,
+                      float startAmount, float endAmount)
+{
+    auto driveStep = numSamples > 0 ? (endDrive - startDrive) / static_cast<float>(numSamples) : 0.f;
+    auto amountStep = numSamples > 0 ? (endAmount - startAmount) / static_cast<float>(numSamples) : 0.f;
+
+    for (int channel = 0; channel < numChannels; ++channel)
+    {
+        float* data = channels[channel];
+
+        for (int i = 0; i < numSamples; ++i)
+        {
+            auto drive = startDrive + driveStep * static_cast<float>(i);
+            auto mix = startAmount + amountStep * static_cast<float>(i);
+
+            // The approximation holds within +-5, where tanh is already within 1e-4 of its limit
+            auto x = juce::jlimit(-5.f, 5.f, drive * data[i]);
+            data[i] += mix * (juce::dsp::FastMathApproximations::tanh(x) / drive - data[i]);
+        }
+    }
+}
+
+juce::dsp::Oversampling<float>* Saturator::getOversampler() const
+{
+    switch (this->oversampling)
+    {
+        case Oversampling::none:        return nullptr;
+        case Oversampling::twoTimes:    return this->oversamplers[0].get();
+        case Oversampling::fourTimes:   return this->oversamplers[1].get();
+    }
+
+    return nullptr;
+}
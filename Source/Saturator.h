@@ -0,0 +1,57 @@
+#pragma once
+
+#include <juce_dsp/juce_dsp.h>
+#include <array>
+#include <memory>
+
+// Soft clipping for the wet signal inside the feedback loop: tanh(drive * x) / drive, so quiet
+// echoes pass at unity gain and only loud ones are squashed, and the loop gain never goes up.
+//
+// A waveshaper adds harmonics well above the input's bandwidth, which fold back as aliasing at the
+// base rate. The shaper can run inside juce::dsp::Oversampling with polyphase IIR half-band filters
+// at 2x or 4x instead; both oversamplers are prepared up front so switching never allocates.
+//
+// Switching the saturation on or off crossfades the shaper in or out while the oversampler keeps
+// running, so the latency only depends on the oversampling factor and the echoes don't jump.
+class Saturator
+{
+public:
+    // Index of the "Saturation Oversampling" choice
+    enum class Oversampling { none, twoTimes, fourTimes };
+
+    // Non-realtime
+    void prepare(int numChannels, double sampleRate, int maximumBlockSize);
+
+    // Clears the oversampling filters and finishes any fade
+    void reset();
+
+    // Audio thread. A newly selected oversampler starts from silence.
+    void setOversampling(Oversampling newOversampling);
+    Oversampling getOversampling() const { return oversampling; }
+
+    // Audio thread. The shaper fades in or out over 20 ms.
+    void setEnabled(bool shouldBeEnabled);
+
+    // Whether process() changes anything: false once faded out at 1x, where there is no latency to keep
+    bool isActive() const { return oversampling != Oversampling::none || amount.getCurrentValue() != 0.f || amount.isSmoothing(); }
+
+    // Delay added by the oversampling filters, a whole number of samples
+    int getLatencyInSamples() const;
+
+    // In place, drive (as a gain) ramped linearly from startDrive to endDrive. numSamples must not
+    // be more than the prepared maximum block size.
+    void process(float* const* channels, int numChannels, int numSamples, float startDrive, float endDrive);
+
+private:
+    // Mixes the shaped signal in by amount, ramped from startAmount to endAmount like the drive
+    static void shape(float* const* channels, int numChannels, int numSamples, float startDrive, float endDrive,
+                      float startAmount, float endAmount);
+
+    juce::dsp::Oversampling<float>* getOversampler() const;
+
+    std::array<std::unique_ptr<juce::dsp::Oversampling<float>>, 2> oversamplers; // 2x, 4x
+    Oversampling oversampling{Oversampling::none};
+
+    // 0 off ... 1 on
+    juce::SmoothedValue<float> amount;
+};
@@ -0,0 +1,217 @@
+#pragma once
+
+#include <juce_core/juce_core.h>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <limits>
+
+// Per-stage timing counters for processBlock.
+// The audio thread is the only writer (plain relaxed stores, no locks, no RMW);
+// any other thread may take a snapshot at any time. Values in a snapshot can be
+// a block apart from each other, which is fine for profiling.
+// Everything here is compiled out unless STRANGE_ECHOES_PROFILING is set to 1.
+
+#ifndef STRANGE_ECHOES_PROFILING
+ #define STRANGE_ECHOES_PROFILING 0
+#endif
+
+enum class DspStage
+{
+    delayIO,
+    filters,
+    pitchShifter,
+    frequencyShifter,
+    saturation,
+    output,
+    total,
+    numStages
+};
+
+class StageProfiler
+{
+public:
+    static constexpr int numStages = static_cast<int>(DspStage::numStages);
+
+    // Bucket b counts durations in [2^b, 2^(b+1)) nanoseconds
+    static constexpr int numBuckets = 32;
+
+    struct StageSnapshot
+    {
+        juce::uint64 calls{0}, totalNs{0}, minNs{0}, maxNs{0};
+        std::array<juce::uint64, numBuckets> histogram{};
+
+        double getMeanNs() const { return calls > 0 ? static_cast<double>(totalNs) / static_cast<double>(calls) : 0.0; }
+
+        // Upper edge of the histogram bucket holding the given percentile
+        double getPercentileNs(double percentile) const
+        {
+            auto target = static_cast<juce::uint64>(std::ceil(juce::jlimit(0.0, 100.0, percentile) / 100.0 * static_cast<double>(calls)));
+            juce::uint64 count = 0;
+
+            for (int bucket = 0; bucket < numBuckets; ++bucket)
+            {
+                count += histogram[(size_t) bucket];
+
+                if (count >= target && count > 0)
+                    return juce::jmin(static_cast<double>(maxNs), std::ldexp(1.0, bucket + 1));
+            }
+
+            return static_cast<double>(maxNs);
+        }
+    };
+
+    using Snapshot = std::array<StageSnapshot, numStages>;
+
+    StageProfiler()
+    {
+        clear();
+    }
+
+    static const char* getStageName(DspStage stage)
+    {
+        switch (stage)
+        {
+            case DspStage::delayIO:          return "delayIO";
+            case DspStage::filters:          return "filters";
+            case DspStage::pitchShifter:     return "pitchShifter";
+            case DspStage::frequencyShifter: return "frequencyShifter";
+            case DspStage::saturation:       return "saturation";
+            case DspStage::output:           return "output";
+            case DspStage::total:            return "total";
+            case DspStage::numStages:        break;
+        }
+
+        return "";
+    }
+
+    // Audio thread: call once at the start of each block
+    void beginBlock() noexcept
+    {
+        if (resetRequested.exchange(false, std::memory_order_acquire))
+            clear();
+    }
+
+    // Audio thread only
+    void record(DspStage stage, juce::uint64 ns) noexcept
+    {
+        auto& c = counters[(size_t) stage];
+
+        c.calls.store(c.calls.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        c.totalNs.store(c.totalNs.load(std::memory_order_relaxed) + ns, std::memory_order_relaxed);
+
+        if (ns < c.minNs.load(std::memory_order_relaxed))
+            c.minNs.store(ns, std::memory_order_relaxed);
+
+        if (ns > c.maxNs.load(std::memory_order_relaxed))
+            c.maxNs.store(ns, std::memory_order_relaxed);
+
+        auto clamped = static_cast<juce::uint32>(juce::jlimit<juce::uint64>(1, std::numeric_limits<juce::uint32>::max(), ns));
+        auto& bucket = c.histogram[(size_t) juce::jmin(numBuckets - 1, juce::findHighestSetBit(clamped))];
+        bucket.store(bucket.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+
+    // Any thread
+    Snapshot getSnapshot() const noexcept
+    {
+        Snapshot snapshot;
+
+        for (size_t i = 0; i < counters.size(); ++i)
+        {
+            auto& c = counters[i];
+            auto& s = snapshot[i];
+
+            s.calls   = c.calls.load(std::memory_order_relaxed);
+            s.totalNs = c.totalNs.load(std::memory_order_relaxed);
+            s.minNs   = s.calls > 0 ? c.minNs.load(std::memory_order_relaxed) : 0;
+            s.maxNs   = c.maxNs.load(std::memory_order_relaxed);
+
+            for (size_t b = 0; b < s.histogram.size(); ++b)
+                s.histogram[b] = c.histogram[b].load(std::memory_order_relaxed);
+        }
+
+        return snapshot;
+    }
+
+    // Any thread: the counters are cleared by the audio thread at the next beginBlock()
+    void requestReset() noexcept
+    {
+        resetRequested.store(true, std::memory_order_release);
+    }
+
+    // Times consecutive stages of one block, the whole lifetime is recorded as DspStage::total
+    class BlockTimer
+    {
+    public:
+        explicit BlockTimer(StageProfiler& p) noexcept : profiler(p)
+        {
+            profiler.beginBlock();
+            blockStart = stageStart = Clock::now();
+        }
+
+        ~BlockTimer() noexcept
+        {
+            auto now = Clock::now();
+            finishStage(now);
+            profiler.record(DspStage::total, toNs(now - blockStart));
+        }
+
+        void enter(DspStage stage) noexcept
+        {
+            auto now = Clock::now();
+            finishStage(now);
+            currentStage = stage;
+            stageStart = now;
+        }
+
+    private:
+        using Clock = std::chrono::steady_clock;
+
+        static juce::uint64 toNs(Clock::duration d) noexcept
+        {
+            return static_cast<juce::uint64>(std::chrono::duration_cast<std::chrono::nanoseconds>(d).count());
+        }
+
+        void finishStage(Clock::time_point now) noexcept
+        {
+            if (currentStage != DspStage::numStages)
+                profiler.record(currentStage, toNs(now - stageStart));
+        }
+
+        StageProfiler& profiler;
+        DspStage currentStage { DspStage::numStages };
+        Clock::time_point blockStart, stageStart;
+    };
+
+private:
+    struct StageCounters
+    {
+        std::atomic<juce::uint64> calls, totalNs, minNs, maxNs;
+        std::array<std::atomic<juce::uint64>, numBuckets> histogram;
+    };
+
+    void clear() noexcept
+    {
+        for (auto& c : counters)
+        {
+            c.calls.store(0, std::memory_order_relaxed);
+            c.totalNs.store(0, std::memory_order_relaxed);
+            c.minNs.store(std::numeric_limits<juce::uint64>::max(), std::memory_order_relaxed);
+            c.maxNs.store(0, std::memory_order_relaxed);
+
+            for (auto& bucket : c.histogram)
+                bucket.store(0, std::memory_order_relaxed);
+        }
+    }
+
+    std::array<StageCounters, numStages> counters;
+    std::atomic<bool> resetRequested { false };
+};
+
+#if STRANGE_ECHOES_PROFILING
+ #define STRANGE_ECHOES_PROFILE_BLOCK(profiler)   StageProfiler::BlockTimer stageProfilerBlockTimer(profiler)
+ #define STRANGE_ECHOES_PROFILE_STAGE(stage)      stageProfilerBlockTimer.enter(stage)
+#else
+ #define STRANGE_ECHOES_PROFILE_BLOCK(profiler)
+ #define STRANGE_ECHOES_PROFILE_STAGE(stage)
+#endif
@@ -1,374 +1,679 @@
-#include "StrangeEchoesProcessor.h"
-#include "StrangeEchoesEditor.h"
-
-
-void LookAndFeel::drawRotarySlider(juce::Graphics & g,
-                                   int x,
-                                   int y,
-                                   int width,
-                                   int height,
-                                   float sliderPosProportional,
-                                   float rotaryStartAngle,
-                                   float rotaryEndAngle,
-                                   juce::Slider & slider)
-{
-    using namespace juce;
-    
-    auto bounds = Rectangle<float>(x, y, width, height);
-    g.setColour(Colour(197u, 124u, 49u));
-    
-    
-    g.fillEllipse(bounds);
-    
-    g.setColour(Colour(0u,0u,0u));
-    g.drawEllipse(bounds, 1.f);
-    
-    if (auto* rslw = dynamic_cast<RotarySliderWithLabels*>(&slider))
-    {
-        auto center = bounds.getCentre();
-        
-        Path p;
-        
-        Rectangle<float> r;
-        r.setLeft(center.getX()-1.5);
-        r.setRight(center.getX()+1.5);
-        r.setTop(bounds.getY());
-        r.setBottom(center.getY() - rslw->getTextHeight() * 2.0);
-        
-        p.addRoundedRectangle(r, 1.f);
-         
-        jassert(rotaryStartAngle<rotaryEndAngle);
-        auto sliderAngRad = jmap(sliderPosProportional, 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
-        
-        p.applyTransform(AffineTransform().rotated(sliderAngRad, center.getX(), center.getY()));
-        g.fillPath(p);
-        
-        // draw parameter value string in middle
-        g.setFont(rslw->getTextHeight());
-        auto text = rslw->getDisplayString();
-        auto strWidth = g.getCurrentFont().getStringWidth(text);
-        r.setSize(strWidth + 4, rslw->getTextHeight() + 2);
-        r.setCentre(bounds.getCentre());
-        
-        //g.setColour(Colour(41u,83u,77u));
-        g.setColour(Colours::black.withAlpha(0.0f));
-        g.fillRoundedRectangle(r, 2.f);
-        //g.fillRect(r);
-        g.setColour(Colours::black);
-        g.drawFittedText(text, r.toNearestInt(),juce::Justification::centred,1);
-        
-        // draw parameter title string at top
-        auto titleStr = rslw->getTitleString();
-        strWidth = g.getCurrentFont().getStringWidth(titleStr);
-        r.setSize(strWidth + 4, rslw->getTextHeight() + 2);
-        r.setCentre(bounds.getCentreX(), bounds.getCentreY() - bounds.getHeight() / 2 - 8);
-        g.setColour(Colours::black.withAlpha(0.0f));
-        g.fillRect(r);
-        g.setColour(Colours::whitesmoke);
-        g.drawFittedText(titleStr, r.toNearestInt(),juce::Justification::centred,1);
-    }
-    
-}
-
-
-void RotarySliderWithLabels::paint(juce::Graphics & g)
-{
-    using namespace juce;
-    
-    auto startAng = degreesToRadians(180.0f + 45.0f);
-    auto endAng = degreesToRadians(180.0f - 45.0f) + MathConstants<float>::twoPi;
-    auto range = getRange();
-    
-    auto sliderBounds = getSliderBounds();
-    
-//    g.setColour(Colours::red);
-//    g.drawRect(getLocalBounds());
-//    g.setColour(Colours::yellow);
-//    g.drawRect(sliderBounds);
-    
-    getLookAndFeel().drawRotarySlider(g,
-                                      sliderBounds.getX(),
-                                      sliderBounds.getY(),
-                                      sliderBounds.getWidth(),
-                                      sliderBounds.getHeight(),
-                                      jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0),
-                                      startAng,
-                                      endAng,
-                                      *this);
-}
-
-juce::Rectangle<int> RotarySliderWithLabels::getSliderBounds() const
-{
-    auto bounds = getLocalBounds();
-    auto size = juce::jmin(bounds.getWidth(), bounds.getHeight());
-    
-    size -= getTextHeight() * 1.2;
-    
-    juce::Rectangle<int> r;
-    r.setSize(size, size);
-    r.setCentre(bounds.getCentreX(), 0);
-    r.setY(15);
-    
-    return r;
-    
-}
-
-juce::String RotarySliderWithLabels::getTitleString() const
-{
-    juce::String str;
-    
-    if (auto* floatParam = dynamic_cast<juce::AudioParameterFloat*>(param))
-        str = floatParam->name;
-    
-    return str;
-}
-
-juce::String RotarySliderWithLabels::getDisplayString() const
-{
-    if (auto* choiceParam = dynamic_cast<juce::AudioParameterChoice*>(param))
-        return choiceParam->getCurrentChoiceName();
-    
-    juce::String str;
-    bool addK = false;
-    
-    if (auto* floatParam = dynamic_cast<juce::AudioParameterFloat*>(param))
-    {
-        float val = getValue();
-        
-        
-        if (suffix == "Hz" && val > 999.f)
-        {
-            val /= 1000.f;
-            addK = true;
-        }
-        
-        if (suffix == "%")
-        {
-            val *= 100.f;
-            str = juce::String(val, 0);
-        }
-        else
-        {
-            str = juce::String(val,(addK ? 2 : 0));
-        }
-    }
-    else
-    {
-        jassertfalse;
-    }
-    
-    if (suffix.isNotEmpty())
-    {
-        str << " ";
-        if (addK)
-            str << "k";
-
-        str << suffix;
-    }
-        
-    return str;
-}
-
-//==============================================================================
-StrangeEchoesAudioProcessorEditor::StrangeEchoesAudioProcessorEditor (StrangeEchoesAudioProcessor& p)
-    : AudioProcessorEditor (&p), processorRef (p),
-dryWetSlider            (*processorRef.apvts.getParameter("Dry/Wet Mix"),       "%"),
-delayTimeSlider         (*processorRef.apvts.getParameter("Delay Time"),        "ms"),
-feedbackSlider          (*processorRef.apvts.getParameter("Feedback"),          "%"),
-freqShiftSlider         (*processorRef.apvts.getParameter("Frequency Shift"),   "Hz"),
-sidebandSlider          (*processorRef.apvts.getParameter("Sideband Mix"),      "%"),
-pitchShiftSlider        (*processorRef.apvts.getParameter("Pitch Shift"),       "st"),
-pitchShiftAmountSlider  (*processorRef.apvts.getParameter("Pitch Shift Amount"),"%"),
-//lowPassSlider           (*processorRef.apvts.getParameter("LowPass Freq"),      "Hz"),
-//highPassSlider          (*processorRef.apvts.getParameter("HighPass Freq"),     "Hz"),
-lfoAmountSlider         (*processorRef.apvts.getParameter("LFO Amount"),        "ms"),
-lfoRateSlider           (*processorRef.apvts.getParameter("LFO Rate"),          "Hz"),
-
-dryWetSliderAttachment          (processorRef.apvts, "Dry/Wet Mix",                 dryWetSlider),
-delayTimeSliderAttachment       (processorRef.apvts, "Delay Time",                  delayTimeSlider),
-feedbackSliderAttachment        (processorRef.apvts, "Feedback",                    feedbackSlider),
-freqShiftSliderAttachment       (processorRef.apvts, "Frequency Shift",             freqShiftSlider),
-sidebandSliderAttachment        (processorRef.apvts, "Sideband Mix",                sidebandSlider),
-pitchShiftSliderAttachment      (processorRef.apvts, "Pitch Shift",                 pitchShiftSlider),
-pitchShiftAmountSliderAttachment(processorRef.apvts, "Pitch Shift Amount",          pitchShiftAmountSlider),
-lowPassSliderAttachment         (processorRef.apvts, "LowPass Freq",                lowPassSlider),
-highPassSliderAttachment        (processorRef.apvts, "HighPass Freq",               highPassSlider),
-lfoAmountSliderAttachment       (processorRef.apvts, "LFO Amount",                  lfoAmountSlider),
-lfoRateSliderAttachment         (processorRef.apvts, "LFO Rate",                    lfoRateSlider),
-syncSliderAttachment            (processorRef.apvts, "Sync Options",                syncSlider),
-noteTypeSliderAttachment        (processorRef.apvts, "Note Type",                   noteTypeSlider),
-noteSelectorAttachment          (processorRef.apvts, "Tempo-Relative Delay Time",   noteSelector)
-{
-    juce::ignoreUnused (processorRef);
-
-    setSize (500, 400);
-
-    syncLookAndFeel.setColour (juce::Slider::thumbColourId, juce::Colour(197u, 124u, 49u));
-    syncLookAndFeel.setColour (juce::Slider::textBoxOutlineColourId, juce::Colours::black.withAlpha(0.0f));
-    syncLookAndFeel.setColour (juce::Slider::textBoxTextColourId, juce::Colours::whitesmoke);
-    
-    syncSlider.setLookAndFeel(&syncLookAndFeel);
-    noteSelector.setLookAndFeel(&syncLookAndFeel);
-    noteTypeSlider.setLookAndFeel(&syncLookAndFeel);
-    lowPassSlider.setLookAndFeel(&syncLookAndFeel);
-    highPassSlider.setLookAndFeel(&syncLookAndFeel);
-    
-    lowPassSlider.setTextValueSuffix(" Hz");
-    lowPassSlider.setSize(lowPassSlider.getWidth()*0.75, lowPassSlider.getHeight());
-    
-    auto lpbound = lowPassSlider.getBounds();
-    
-    lowPassSlider.setCentrePosition(lpbound.getCentreX()+50, lpbound.getCentreY());
-    lowPassLabel.setText("LP: ", juce::dontSendNotification);
-    lowPassLabel.attachToComponent (&lowPassSlider, true); // [4]
-    
-    highPassSlider.setTextValueSuffix(" Hz");
-    highPassSlider.setSize(highPassSlider.getWidth()*0.75, highPassSlider.getHeight());
-    
-    auto hpbound = highPassSlider.getBounds();
-    highPassSlider.setCentrePosition(hpbound.getCentreX()+50, hpbound.getCentreY());
-    highPassLabel.setText("HP: ", juce::dontSendNotification);
-    highPassLabel.attachToComponent (&highPassSlider, true); // [4]
-    
-    for (auto* comp : getComps())
-    {
-        addAndMakeVisible(comp);
-    }
-}
-
-StrangeEchoesAudioProcessorEditor::~StrangeEchoesAudioProcessorEditor()
-{
-    for (auto& c : getComps())
-    {
-        c->setLookAndFeel(nullptr);
-    }
-}
-
-//==============================================================================
-void StrangeEchoesAudioProcessorEditor::paint (juce::Graphics& g)
-{
-    // (Our component is opaque, so we must completely fill the background with a solid colour)
-    using namespace juce;
-    
-    g.fillAll(juce::Colour(41u,83u,77u));
-    juce::Rectangle<int> r;
-
-    auto bounds = getLocalBounds();
-    auto topArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
-    
-    g.setColour(juce::Colour(62u, 87u, 82u));
-    r.setSize(topArea.getWidth(), topArea.getHeight());
-    r.setCentre(topArea.getCentreX(), topArea.getCentreY());
-    g.fillRect(r);
-    
-    auto eqArea = bounds.removeFromTop(bounds.getHeight()*0.33);
-
-    g.setColour(juce::Colour(97u, 117u, 113u));
-    r.setSize(eqArea.getWidth(), eqArea.getHeight());
-    r.setCentre(eqArea.getCentreX(), eqArea.getCentreY());
-    g.fillRect(r);
-    
-    auto lfoArea = bounds.removeFromTop(bounds.getHeight()*0.5);
-
-    g.setColour(juce::Colour(62u, 87u, 82u));
-    r.setSize(lfoArea.getWidth(), lfoArea.getHeight());
-    r.setCentre(lfoArea.getCentreX(), lfoArea.getCentreY());
-    g.fillRect(r);
-    
-    g.setColour(juce::Colour(97u, 117u, 113u));
-    r.setSize(bounds.getWidth(), bounds.getHeight());
-    r.setCentre(bounds.getCentreX(), bounds.getCentreY());
-    g.fillRect(r);
-    
-    // Colour on Time area
-    bounds = getLocalBounds();
-    g.setColour(juce::Colour(43u,59u,56u));
-    r.setSize(bounds.getWidth()*0.33, bounds.getHeight()*0.5511);
-    r.setCentre(bounds.getCentreX() - bounds.getWidth()*0.67*0.5, bounds.getCentreY() - bounds.getHeight()*0.4489*0.5);
-    g.fillRect(r);
-    
-    auto cr = Rectangle<float>(bounds.getCentreX(), bounds.getCentreY(), bounds.getWidth()*0.1, bounds.getWidth()*0.1);
-    
-    for (int i = 0; i < 24; i++)
-    {
-        float radi = 0.1 + 0.05*i;
-        cr.setSize( bounds.getWidth() * radi, bounds.getWidth() * radi);
-        cr.setCentre(bounds.getCentreX(), bounds.getCentreY());
-
-        g.setColour(juce::Colour(69u, 77u, 76u));
-        g.drawEllipse(cr, 1.f);
-    }
-    
-    g.setFont (15.0f);
-}
-
-void StrangeEchoesAudioProcessorEditor::resized()
-{
-    // This is generally where you'll want to lay out the positions of any
-    // subcomponents in your editor..
-    
-    auto bounds = getLocalBounds();
-    
-    // top
-    auto topArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
-    auto delayTimeArea = topArea.removeFromLeft(topArea.getWidth() * 0.33);
-    auto dryWetArea = topArea.removeFromRight(topArea.getWidth() * 0.5);
-    
-    delayTimeSlider.setBounds(delayTimeArea);
-    dryWetSlider.setBounds(dryWetArea);
-    feedbackSlider.setBounds(topArea);
-    
-    // second
-    auto midArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
-    auto syncArea = midArea.removeFromLeft(midArea.getWidth() * 0.33);
-    //syncArea = syncArea.removeFromLeft(syncArea.getWidth() * 0.66);
-    
-    syncSlider.setBounds(syncArea.removeFromTop(syncArea.getHeight() * 0.33));
-    noteSelector.setBounds(syncArea.removeFromTop(syncArea.getHeight() * 0.5));
-    noteTypeSlider.setBounds(syncArea);
-    
-    lowPassLabel.setBounds(midArea);
-    highPassLabel.setBounds(midArea);
-    lowPassSlider.setBounds(midArea.removeFromTop(midArea.getHeight() * 0.5));
-    highPassSlider.setBounds(midArea);
-    
-    
-    // third
-    auto lfoArea = bounds.removeFromTop(bounds.getHeight() * 0.5);
-        
-//    int margin = lfoArea.getWidth()*0.0438581;
-//    lfoArea.removeFromLeft(margin);
-//    lfoArea.removeFromRight(margin);
-    
-    lfoAmountSlider.setBounds(lfoArea.removeFromLeft(lfoArea.getWidth() * 0.5));
-    lfoRateSlider.setBounds(lfoArea);
-    
-    //bottom
-    auto pitchShiftArea = bounds.removeFromLeft(bounds.getWidth() * 0.5);
-    
-    pitchShiftAmountSlider.setBounds(pitchShiftArea.removeFromLeft(pitchShiftArea.getWidth() * 0.5));
-    pitchShiftSlider.setBounds(pitchShiftArea);
-    freqShiftSlider.setBounds(bounds.removeFromLeft(bounds.getWidth() * 0.5));
-    sidebandSlider.setBounds(bounds);
-}
-
-std::vector<juce::Component*> StrangeEchoesAudioProcessorEditor::getComps()
-{
-    return
-    {
-        &dryWetSlider,
-        &delayTimeSlider,
-        &feedbackSlider,
-        &freqShiftSlider,
-        &sidebandSlider,
-        &pitchShiftSlider,
-        &pitchShiftAmountSlider,
-        &lowPassSlider,
-        &highPassSlider,
-        &lfoAmountSlider,
-        &lfoRateSlider,
-        &syncSlider,
-        &noteSelector,
-        &noteTypeSlider,
-    };
-}
+#include "StrangeEchoesProcessor.h"
+#include "StrangeEchoesEditor.h"
+
+
+void LookAndFeel::drawRotarySlider(juce::Graphics & g,
+                                   int x,
+                                   int y,
+                                   int width,
+                                   int height,
+                                   float sliderPosProportional,
+                                   float rotaryStartAngle,
+                                   float rotaryEndAngle,
+                                   juce::Slider & slider)
+{
+    using namespace juce;
+    
+    auto bounds = Rectangle<float>(x, y, width, height);
+    
+    auto* rslw = dynamic_cast<RotarySliderWithLabels*>(&slider);
+    
+    if (rslw == nullptr)
+    {
+        g.setColour(Colour(197u, 124u, 49u));
+        g.fillEllipse(bounds);
+        
+        g.setColour(Colour(0u,0u,0u));
+        g.drawEllipse(bounds, 1.f);
+        return;
+    }
+    
+    auto center = bounds.getCentre();
+    
+    jassert(rotaryStartAngle<rotaryEndAngle);
+    auto sliderAngRad = jmap(sliderPosProportional, 0.f, 1.f, rotaryStartAngle, rotaryEndAngle);
+    
+    g.setColour(Colour(0u,0u,0u));
+    g.fillPath(rslw->getPointerPath(), AffineTransform::rotation(sliderAngRad, center.getX(), center.getY()));
+    
+    // draw parameter value string in middle
+    g.setFont(rslw->getTextHeight());
+    auto text = rslw->getDisplayString();
+    auto strWidth = g.getCurrentFont().getStringWidth(text);
+    
+    Rectangle<float> r;
+    r.setSize(strWidth + 4, rslw->getTextHeight() + 2);
+    r.setCentre(bounds.getCentre());
+    
+    g.setColour(Colours::black);
+    g.drawFittedText(text, r.toNearestInt(),juce::Justification::centred,1);
+}
+
+void LookAndFeel::drawKnobBody(juce::Graphics& g, juce::Rectangle<float> bounds, const RotarySliderWithLabels& slider)
+{
+    using namespace juce;
+    
+    g.setColour(Colour(197u, 124u, 49u));
+    g.fillEllipse(bounds);
+    
+    g.setColour(Colour(0u,0u,0u));
+    g.drawEllipse(bounds, 1.f);
+    
+    // draw parameter title string at top
+    g.setFont(slider.getTextHeight());
+    auto titleStr = slider.getTitleString();
+    auto strWidth = g.getCurrentFont().getStringWidth(titleStr);
+    
+    Rectangle<float> r;
+    r.setSize(strWidth + 4, slider.getTextHeight() + 2);
+    r.setCentre(bounds.getCentreX(), bounds.getCentreY() - bounds.getHeight() / 2 - 8);
+    g.setColour(Colours::whitesmoke);
+    g.drawFittedText(titleStr, r.toNearestInt(),juce::Justification::centred,1);
+}
+
+
+void RotarySliderWithLabels::paint(juce::Graphics & g)
+{
+    using namespace juce;
+    
+    auto startAng = degreesToRadians(180.0f + 45.0f);
+    auto endAng = degreesToRadians(180.0f - 45.0f) + MathConstants<float>::twoPi;
+    auto range = getRange();
+    
+    auto sliderBounds = getSliderBounds();
+    
+//    g.setColour(Colours::red);
+//    g.drawRect(getLocalBounds());
+//    g.setColour(Colours::yellow);
+//    g.drawRect(sliderBounds);
+    
+    if (getWidth() <= 0 || getHeight() <= 0)
+        return;
+    
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    
+    if (! knobLayer.isValid() || scale != knobLayerScale)
+    {
+        knobLayerScale = scale;
+        knobLayer = Image(Image::ARGB, roundToInt(getWidth() * scale), roundToInt(getHeight() * scale), true);
+        
+        Graphics layer(knobLayer);
+        layer.addTransform(AffineTransform::scale(scale));
+        LookAndFeel::drawKnobBody(layer, sliderBounds.toFloat(), *this);
+    }
+    
+    g.drawImage(knobLayer, getLocalBounds().toFloat());
+    
+    getLookAndFeel().drawRotarySlider(g,
+                                      sliderBounds.getX(),
+                                      sliderBounds.getY(),
+                                      sliderBounds.getWidth(),
+                                      sliderBounds.getHeight(),
+                                      jmap(getValue(), range.getStart(), range.getEnd(), 0.0, 1.0),
+                                      startAng,
+                                      endAng,
+                                      *this);
+}
+
+void RotarySliderWithLabels::resized()
+{
+    juce::Slider::resized();
+    
+    knobLayer = {};
+    
+    auto bounds = getSliderBounds().toFloat();
+    auto center = bounds.getCentre();
+    
+    juce::Rectangle<float> r;
+    r.setLeft(center.getX()-1.5);
+    r.setRight(center.getX()+1.5);
+    r.setTop(bounds.getY());
+    r.setBottom(center.getY() - getTextHeight() * 2.0);
+    
+    pointerPath.clear();
+    pointerPath.addRoundedRectangle(r, 1.f);
+}
+
+juce::Rectangle<int> RotarySliderWithLabels::getSliderBounds() const
+{
+    auto bounds = getLocalBounds();
+    auto size = juce::jmin(bounds.getWidth(), bounds.getHeight());
+    
+    size -= getTextHeight() * 1.2;
+    
+    juce::Rectangle<int> r;
+    r.setSize(size, size);
+    r.setCentre(bounds.getCentreX(), 0);
+    r.setY(15);
+    
+    return r;
+    
+}
+
+juce::String RotarySliderWithLabels::getTitleString() const
+{
+    juce::String str;
+    
+    if (auto* floatParam = dynamic_cast<juce::AudioParameterFloat*>(param))
+        str = floatParam->name;
+    
+    return str;
+}
+
+juce::String RotarySliderWithLabels::getDisplayString() const
+{
+    if (auto* choiceParam = dynamic_cast<juce::AudioParameterChoice*>(param))
+        return choiceParam->getCurrentChoiceName();
+    
+    juce::String str;
+    bool addK = false;
+    
+    if (auto* floatParam = dynamic_cast<juce::AudioParameterFloat*>(param))
+    {
+        float val = getValue();
+        
+        
+        if (suffix == "Hz" && val > 999.f)
+        {
+            val /= 1000.f;
+            addK = true;
+        }
+        
+        if (suffix == "%")
+        {
+            val *= 100.f;
+            str = juce::String(val, 0);
+        }
+        else
+        {
+            str = juce::String(val,(addK ? 2 : 0));
+        }
+    }
+    else
+    {
+        jassertfalse;
+    }
+    
+    if (suffix.isNotEmpty())
+    {
+        str << " ";
+        if (addK)
+            str << "k";
+
+        str << suffix;
+    }
+        
+    return str;
+}
+
+LevelMeterComponent::LevelMeterComponent(const juce::String& meterLabel) :
+label(meterLabel)
+{
+    setOpaque(true);
+}
+
+void LevelMeterComponent::update(LevelMeter& meter)
+{
+    bool changed = false;
+    
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto peak = meter.getAndResetPeak(channel);
+        
+        if (peak >= 1.f && ! clipped)
+        {
+            clipped = true;
+            changed = true;
+        }
+        
+        // Peaks fall back at about 45 dB/s
+        auto& peakDb = peakDecibels[(size_t) channel];
+        peakDb = juce::jmax(juce::Decibels::gainToDecibels(peak, -100.f), peakDb - 0.75f);
+        rmsDecibels[(size_t) channel] = juce::Decibels::gainToDecibels(meter.getRms(channel), -100.f);
+        
+        auto peakHeight = getBarHeight(peakDb);
+        auto rmsHeight = getBarHeight(rmsDecibels[(size_t) channel]);
+        
+        if (peakHeight != peakHeights[(size_t) channel] || rmsHeight != rmsHeights[(size_t) channel])
+        {
+            peakHeights[(size_t) channel] = peakHeight;
+            rmsHeights[(size_t) channel] = rmsHeight;
+            changed = true;
+        }
+    }
+    
+    if (changed)
+        repaint();
+}
+
+void LevelMeterComponent::paint(juce::Graphics& g)
+{
+    using namespace juce;
+    
+    g.fillAll(Colour(43u,59u,56u));
+    
+    auto barArea = getBarArea();
+    auto barWidth = barArea.getWidth() / 2;
+    
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        auto bar = barArea.withWidth(barWidth - 1).withX(barArea.getX() + channel * barWidth);
+        
+        g.setColour(Colour(62u, 87u, 82u));
+        g.fillRect(bar);
+        
+        g.setColour(Colour(197u, 124u, 49u));
+        g.fillRect(bar.withTop(bar.getBottom() - rmsHeights[(size_t) channel]));
+        
+        g.setColour(Colours::whitesmoke);
+        g.fillRect(bar.getX(), bar.getBottom() - peakHeights[(size_t) channel], bar.getWidth(), 1);
+    }
+    
+    auto bounds = getLocalBounds();
+    
+    g.setColour(clipped ? Colours::red : Colour(62u, 87u, 82u));
+    g.fillRect(bounds.removeFromTop(6).reduced(2, 1));
+    
+    g.setColour(Colours::whitesmoke);
+    g.setFont(10.f);
+    g.drawFittedText(label, bounds.removeFromBottom(12), Justification::centred, 1);
+}
+
+void LevelMeterComponent::mouseDown(const juce::MouseEvent&)
+{
+    clipped = false;
+    repaint();
+}
+
+juce::Rectangle<int> LevelMeterComponent::getBarArea() const
+{
+    return getLocalBounds().withTrimmedTop(6).withTrimmedBottom(12).reduced(2, 0);
+}
+
+int LevelMeterComponent::getBarHeight(float decibels) const
+{
+    // -60 dB ... +6 dB
+    auto height = getBarArea().getHeight();
+    return juce::jlimit(0, height, juce::roundToInt(juce::jmap(decibels, -60.f, 6.f, 0.f, static_cast<float>(height))));
+}
+
+EchoDisplay::EchoDisplay()
+{
+    setOpaque(true);
+}
+
+void EchoDisplay::update(Metering& metering)
+{
+    bool changed = false;
+    
+    if (history.isValid())
+    {
+        juce::Graphics g(history);
+        
+        for (;;)
+        {
+            auto numPoints = metering.echoes.pop(incoming.data(), static_cast<int>(incoming.size()));
+            
+            for (int i = 0; i < numPoints; ++i)
+                drawPoint(g, incoming[(size_t) i]);
+            
+            changed = changed || numPoints > 0;
+            
+            if (numPoints < static_cast<int>(incoming.size()))
+                break;
+        }
+    }
+    
+    auto delayTimeMs = metering.delayTimeMs.load(std::memory_order_relaxed);
+    auto feedback = metering.feedback.load(std::memory_order_relaxed);
+    
+    if (delayTimeMs != markerDelayTimeMs || feedback != markerFeedback)
+    {
+        markerDelayTimeMs = delayTimeMs;
+        markerFeedback = feedback;
+        drawMarkers();
+        changed = true;
+    }
+    
+    if (changed)
+        repaint();
+}
+
+void EchoDisplay::paint(juce::Graphics& g)
+{
+    if (! history.isValid())
+    {
+        g.fillAll(juce::Colour(43u,59u,56u));
+        return;
+    }
+    
+    // The column after the newest one is the oldest, and goes at the left edge
+    auto width = history.getWidth();
+    auto height = history.getHeight();
+    auto oldestColumn = (writeColumn + 1) % width;
+    
+    g.drawImage(history, 0, 0, width - oldestColumn, height, oldestColumn, 0, width - oldestColumn, height);
+    
+    if (oldestColumn > 0)
+        g.drawImage(history, width - oldestColumn, 0, oldestColumn, height, 0, 0, oldestColumn, height);
+    
+    g.drawImageAt(markers, 0, 0);
+}
+
+void EchoDisplay::resized()
+{
+    auto width = getWidth();
+    auto height = getHeight();
+    
+    if (width <= 0 || height <= 0)
+    {
+        history = {};
+        markers = {};
+        return;
+    }
+    
+    history = juce::Image(juce::Image::RGB, width, height, false);
+    juce::Graphics(history).fillAll(juce::Colour(43u,59u,56u));
+    writeColumn = width - 1;
+    
+    markers = juce::Image(juce::Image::ARGB, width, height, true);
+    drawMarkers();
+}
+
+void EchoDisplay::drawPoint(juce::Graphics& g, const EchoEnvelopeFifo::Point& point)
+{
+    writeColumn = (writeColumn + 1) % history.getWidth();
+    auto height = history.getHeight();
+    
+    g.setColour(juce::Colour(43u,59u,56u));
+    g.fillRect(writeColumn, 0, 1, height);
+    
+    g.setColour(juce::Colour(97u, 117u, 113u));
+    g.fillRect(writeColumn, getY(point.dry), 1, height);
+    
+    g.setColour(juce::Colour(197u, 124u, 49u).withAlpha(0.8f));
+    g.fillRect(writeColumn, getY(point.wet), 1, height);
+}
+
+void EchoDisplay::drawMarkers()
+{
+    if (! markers.isValid())
+        return;
+    
+    markers.clear(markers.getBounds());
+    juce::Graphics g(markers);
+    g.setColour(juce::Colours::whitesmoke.withAlpha(0.6f));
+    
+    // Repeat n of what arrives now lands n delay times later, feedback^n as loud. Drawn back from the
+    // right edge, that is where the repeats of what is shown there came from.
+    auto pixelsPerRepeat = markerDelayTimeMs / 1000.f * EchoEnvelopeFifo::pointsPerSecond;
+    auto level = 1.f;
+    auto newestX = static_cast<float>(markers.getWidth() - 1);
+    
+    for (int repeat = 1; repeat <= markers.getWidth(); ++repeat)
+    {
+        auto x = newestX - static_cast<float>(repeat) * pixelsPerRepeat;
+        level *= markerFeedback;
+        
+        if (x < 0.f || level < 0.001f)
+            break;
+        
+        g.fillRect(juce::roundToInt(x), getY(level), 1, markers.getHeight());
+    }
+}
+
+int EchoDisplay::getY(float level) const
+{
+    // -48 dB at the bottom, 0 dB at the top
+    auto decibels = juce::Decibels::gainToDecibels(level, -48.f);
+    return juce::roundToInt(juce::jmap(decibels, -48.f, 0.f, static_cast<float>(getHeight()), 0.f));
+}
+
+//==============================================================================
+StrangeEchoesAudioProcessorEditor::StrangeEchoesAudioProcessorEditor (StrangeEchoesAudioProcessor& p)
+    : AudioProcessorEditor (&p), processorRef (p),
+dryWetSlider            (*processorRef.apvts.getParameter("Dry/Wet Mix"),       "%"),
+delayTimeSlider         (*processorRef.apvts.getParameter("Delay Time"),        "ms"),
+feedbackSlider          (*processorRef.apvts.getParameter("Feedback"),          "%"),
+freqShiftSlider         (*processorRef.apvts.getParameter("Frequency Shift"),   "Hz"),
+sidebandSlider          (*processorRef.apvts.getParameter("Sideband Mix"),      "%"),
+pitchShiftSlider        (*processorRef.apvts.getParameter("Pitch Shift"),       "st"),
+pitchShiftAmountSlider  (*processorRef.apvts.getParameter("Pitch Shift Amount"),"%"),
+//lowPassSlider           (*processorRef.apvts.getParameter("LowPass Freq"),      "Hz"),
+//highPassSlider          (*processorRef.apvts.getParameter("HighPass Freq"),     "Hz"),
+lfoAmountSlider         (*processorRef.apvts.getParameter("LFO Amount"),        "ms"),
+lfoRateSlider           (*processorRef.apvts.getParameter("LFO Rate"),          "Hz"),
+
+dryWetSliderAttachment          (processorRef.apvts, "Dry/Wet Mix",                 dryWetSlider),
+delayTimeSliderAttachment       (processorRef.apvts, "Delay Time",                  delayTimeSlider),
+feedbackSliderAttachment        (processorRef.apvts, "Feedback",                    feedbackSlider),
+freqShiftSliderAttachment       (processorRef.apvts, "Frequency Shift",             freqShiftSlider),
+sidebandSliderAttachment        (processorRef.apvts, "Sideband Mix",                sidebandSlider),
+pitchShiftSliderAttachment      (processorRef.apvts, "Pitch Shift",                 pitchShiftSlider),
+pitchShiftAmountSliderAttachment(processorRef.apvts, "Pitch Shift Amount",          pitchShiftAmountSlider),
+lowPassSliderAttachment         (processorRef.apvts, "LowPass Freq",                lowPassSlider),
+highPassSliderAttachment        (processorRef.apvts, "HighPass Freq",               highPassSlider),
+lfoAmountSliderAttachment       (processorRef.apvts, "LFO Amount",                  lfoAmountSlider),
+lfoRateSliderAttachment         (processorRef.apvts, "LFO Rate",                    lfoRateSlider),
+syncSliderAttachment            (processorRef.apvts, "Sync Options",                syncSlider),
+noteTypeSliderAttachment        (processorRef.apvts, "Note Type v2",                noteTypeSlider),
+noteSelectorAttachment          (processorRef.apvts, "Tempo-Relative Delay Time v2", noteSelector)
+{
+    juce::ignoreUnused (processorRef);
+
+    setSize (500, 400 + visualiserHeight);
+    setOpaque (true);
+
+    syncLookAndFeel.setColour (juce::Slider::thumbColourId, juce::Colour(197u, 124u, 49u));
+    syncLookAndFeel.setColour (juce::Slider::textBoxOutlineColourId, juce::Colours::black.withAlpha(0.0f));
+    syncLookAndFeel.setColour (juce::Slider::textBoxTextColourId, juce::Colours::whitesmoke);
+    
+    syncSlider.setLookAndFeel(&syncLookAndFeel);
+    noteSelector.setLookAndFeel(&syncLookAndFeel);
+    noteTypeSlider.setLookAndFeel(&syncLookAndFeel);
+    lowPassSlider.setLookAndFeel(&syncLookAndFeel);
+    highPassSlider.setLookAndFeel(&syncLookAndFeel);
+    
+    lowPassSlider.setTextValueSuffix(" Hz");
+    lowPassSlider.setSize(lowPassSlider.getWidth()*0.75, lowPassSlider.getHeight());
+    
+    auto lpbound = lowPassSlider.getBounds();
+    
+    lowPassSlider.setCentrePosition(lpbound.getCentreX()+50, lpbound.getCentreY());
+    lowPassLabel.setText("LP: ", juce::dontSendNotification);
+    lowPassLabel.attachToComponent (&lowPassSlider, true); // [4]
+    
+    highPassSlider.setTextValueSuffix(" Hz");
+    highPassSlider.setSize(highPassSlider.getWidth()*0.75, highPassSlider.getHeight());
+    
+    auto hpbound = highPassSlider.getBounds();
+    highPassSlider.setCentrePosition(hpbound.getCentreX()+50, hpbound.getCentreY());
+    highPassLabel.setText("HP: ", juce::dontSendNotification);
+    highPassLabel.attachToComponent (&highPassSlider, true); // [4]
+    
+    for (auto* comp : getComps())
+    {
+        addAndMakeVisible(comp);
+    }
+    
+    addAndMakeVisible(inputMeter);
+    addAndMakeVisible(outputMeter);
+    addAndMakeVisible(echoDisplay);
+    
+    startTimerHz(60);
+}
+
+StrangeEchoesAudioProcessorEditor::~StrangeEchoesAudioProcessorEditor()
+{
+    stopTimer();
+    
+    for (auto& c : getComps())
+    {
+        c->setLookAndFeel(nullptr);
+    }
+}
+
+//==============================================================================
+void StrangeEchoesAudioProcessorEditor::paint (juce::Graphics& g)
+{
+    // Slider repaints clip to the slider, so this mostly blits a small part of the cached background
+    auto scale = g.getInternalContext().getPhysicalPixelScaleFactor();
+    
+    if (! backgroundImage.isValid() || scale != backgroundScale)
+    {
+        backgroundScale = scale;
+        backgroundImage = juce::Image(juce::Image::RGB, juce::roundToInt(getWidth() * scale), juce::roundToInt(getHeight() * scale), false);
+        
+        juce::Graphics background(backgroundImage);
+        background.addTransform(juce::AffineTransform::scale(scale));
+        drawBackground(background);
+    }
+    
+    g.drawImage(backgroundImage, getLocalBounds().toFloat());
+}
+
+void StrangeEchoesAudioProcessorEditor::drawBackground (juce::Graphics& g)
+{
+    // (Our component is opaque, so we must completely fill the background with a solid colour)
+    using namespace juce;
+    
+    g.fillAll(juce::Colour(41u,83u,77u));
+    juce::Rectangle<int> r;
+
+    // The meters and echo display along the bottom paint themselves
+    auto bounds = getLocalBounds().withTrimmedBottom(visualiserHeight);
+    auto topArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
+    
+    g.setColour(juce::Colour(62u, 87u, 82u));
+    r.setSize(topArea.getWidth(), topArea.getHeight());
+    r.setCentre(topArea.getCentreX(), topArea.getCentreY());
+    g.fillRect(r);
+    
+    auto eqArea = bounds.removeFromTop(bounds.getHeight()*0.33);
+
+    g.setColour(juce::Colour(97u, 117u, 113u));
+    r.setSize(eqArea.getWidth(), eqArea.getHeight());
+    r.setCentre(eqArea.getCentreX(), eqArea.getCentreY());
+    g.fillRect(r);
+    
+    auto lfoArea = bounds.removeFromTop(bounds.getHeight()*0.5);
+
+    g.setColour(juce::Colour(62u, 87u, 82u));
+    r.setSize(lfoArea.getWidth(), lfoArea.getHeight());
+    r.setCentre(lfoArea.getCentreX(), lfoArea.getCentreY());
+    g.fillRect(r);
+    
+    g.setColour(juce::Colour(97u, 117u, 113u));
+    r.setSize(bounds.getWidth(), bounds.getHeight());
+    r.setCentre(bounds.getCentreX(), bounds.getCentreY());
+    g.fillRect(r);
+    
+    // Colour on Time area
+    bounds = getLocalBounds().withTrimmedBottom(visualiserHeight);
+    g.setColour(juce::Colour(43u,59u,56u));
+    r.setSize(bounds.getWidth()*0.33, bounds.getHeight()*0.5511);
+    r.setCentre(bounds.getCentreX() - bounds.getWidth()*0.67*0.5, bounds.getCentreY() - bounds.getHeight()*0.4489*0.5);
+    g.fillRect(r);
+    
+    auto cr = Rectangle<float>(bounds.getCentreX(), bounds.getCentreY(), bounds.getWidth()*0.1, bounds.getWidth()*0.1);
+    
+    for (int i = 0; i < 24; i++)
+    {
+        float radi = 0.1 + 0.05*i;
+        cr.setSize( bounds.getWidth() * radi, bounds.getWidth() * radi);
+        cr.setCentre(bounds.getCentreX(), bounds.getCentreY());
+
+        g.setColour(juce::Colour(69u, 77u, 76u));
+        g.drawEllipse(cr, 1.f);
+    }
+    
+    g.setFont (15.0f);
+}
+
+void StrangeEchoesAudioProcessorEditor::resized()
+{
+    // This is generally where you'll want to lay out the positions of any
+    // subcomponents in your editor..
+    
+    backgroundImage = {};
+    
+    auto bounds = getLocalBounds();
+    
+    // meters and echo display
+    auto visualiserArea = bounds.removeFromBottom(visualiserHeight);
+    inputMeter.setBounds(visualiserArea.removeFromLeft(30));
+    outputMeter.setBounds(visualiserArea.removeFromRight(30));
+    echoDisplay.setBounds(visualiserArea);
+    
+    // top
+    auto topArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
+    auto delayTimeArea = topArea.removeFromLeft(topArea.getWidth() * 0.33);
+    auto dryWetArea = topArea.removeFromRight(topArea.getWidth() * 0.5);
+    
+    delayTimeSlider.setBounds(delayTimeArea);
+    dryWetSlider.setBounds(dryWetArea);
+    feedbackSlider.setBounds(topArea);
+    
+    // second
+    auto midArea = bounds.removeFromTop(bounds.getHeight() * 0.33);
+    auto syncArea = midArea.removeFromLeft(midArea.getWidth() * 0.33);
+    //syncArea = syncArea.removeFromLeft(syncArea.getWidth() * 0.66);
+    
+    syncSlider.setBounds(syncArea.removeFromTop(syncArea.getHeight() * 0.33));
+    noteSelector.setBounds(syncArea.removeFromTop(syncArea.getHeight() * 0.5));
+    noteTypeSlider.setBounds(syncArea);
+    
+    lowPassLabel.setBounds(midArea);
+    highPassLabel.setBounds(midArea);
+    lowPassSlider.setBounds(midArea.removeFromTop(midArea.getHeight() * 0.5));
+    highPassSlider.setBounds(midArea);
+    
+    
+    // third
+    auto lfoArea = bounds.removeFromTop(bounds.getHeight() * 0.5);
+        
+//    int margin = lfoArea.getWidth()*0.0438581;
+//    lfoArea.removeFromLeft(margin);
+//    lfoArea.removeFromRight(margin);
+    
+    lfoAmountSlider.setBounds(lfoArea.removeFromLeft(lfoArea.getWidth() * 0.5));
+    lfoRateSlider.setBounds(lfoArea);
+    
+    //bottom
+    auto pitchShiftArea = bounds.removeFromLeft(bounds.getWidth() * 0.5);
+    
+    pitchShiftAmountSlider.setBounds(pitchShiftArea.removeFromLeft(pitchShiftArea.getWidth() * 0.5));
+    pitchShiftSlider.setBounds(pitchShiftArea);
+    freqShiftSlider.setBounds(bounds.removeFromLeft(bounds.getWidth() * 0.5));
+    sidebandSlider.setBounds(bounds);
+}
+
+void StrangeEchoesAudioProcessorEditor::timerCallback()
+{
+    auto& metering = processorRef.getMetering();
+    
+    inputMeter.update(metering.input);
+    outputMeter.update(metering.output);
+    echoDisplay.update(metering);
+}
+
+std::vector<juce::Component*> StrangeEchoesAudioProcessorEditor::getComps()
+{
+    return
+    {
+        &dryWetSlider,
+        &delayTimeSlider,
+        &feedbackSlider,
+        &freqShiftSlider,
+        &sidebandSlider,
+        &pitchShiftSlider,
+        &pitchShiftAmountSlider,
+        &lowPassSlider,
+        &highPassSlider,
+        &lfoAmountSlider,
+        &lfoRateSlider,
+        &syncSlider,
+        &noteSelector,
+        &noteTypeSlider,
+    };
+}
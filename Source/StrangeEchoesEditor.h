@@ -1,102 +1,185 @@
-#pragma once
-
-#include "StrangeEchoesProcessor.h"
-
-
-struct LookAndFeel : juce::LookAndFeel_V4
-{
-    void drawRotarySlider (juce::Graphics&,
-                                    int x, int y, int width, int height,
-                                    float sliderPosProportional,
-                                    float rotaryStartAngle,
-                                    float rotaryEndAngle,
-                                    juce::Slider&) override;
-};
-
-struct RotarySliderWithLabels : juce::Slider
-{
-    RotarySliderWithLabels(juce::RangedAudioParameter& rap, const juce::String& unitSuffix):
-    juce::Slider(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag,juce::Slider::TextEntryBoxPosition::NoTextBox),
-    param(&rap),
-    suffix(unitSuffix)
-    {
-        setLookAndFeel(&lnf);
-    }
-    
-    ~RotarySliderWithLabels()
-    {
-        setLookAndFeel(nullptr);
-    }
-    
-    void paint(juce::Graphics& g) override;
-    juce::Rectangle<int> getSliderBounds() const;
-    int getTextHeight() const {return 14;}
-    juce::String getDisplayString() const;
-    juce::String getTitleString() const;
-    
-    private:
-    LookAndFeel lnf;
-    juce::RangedAudioParameter* param;
-    juce::String suffix;
-    
-};
-
-
-//==============================================================================
-class StrangeEchoesAudioProcessorEditor final : public juce::AudioProcessorEditor
-{
-public:
-    explicit StrangeEchoesAudioProcessorEditor (StrangeEchoesAudioProcessor&);
-    ~StrangeEchoesAudioProcessorEditor() override;
-
-    //==============================================================================
-    void paint (juce::Graphics&) override;
-    void resized() override;
-
-private:    
-    // This reference is provided as a quick way for your editor to
-    // access the processor object that created it.
-    using APVTS = juce::AudioProcessorValueTreeState;
-    using Attachment = APVTS::SliderAttachment;
-    
-    StrangeEchoesAudioProcessor& processorRef;
-    
-    RotarySliderWithLabels dryWetSlider,
-    delayTimeSlider,
-    feedbackSlider,
-    freqShiftSlider,
-    sidebandSlider,
-    pitchShiftSlider,
-    pitchShiftAmountSlider,
-    //lowPassSlider,
-    //highPassSlider,
-    lfoAmountSlider,
-    lfoRateSlider;
-    
-    juce::Slider lowPassSlider, highPassSlider;
-    juce::Label lowPassLabel, highPassLabel;
-    
-    juce::Slider syncSlider, noteSelector, noteTypeSlider;
-
-    Attachment dryWetSliderAttachment,
-    delayTimeSliderAttachment,
-    feedbackSliderAttachment,
-    freqShiftSliderAttachment,
-    sidebandSliderAttachment,
-    pitchShiftSliderAttachment,
-    pitchShiftAmountSliderAttachment,
-    lowPassSliderAttachment,
-    highPassSliderAttachment,
-    lfoAmountSliderAttachment,
-    lfoRateSliderAttachment,
-    syncSliderAttachment,
-    noteSelectorAttachment,
-    noteTypeSliderAttachment;
-    
-    
-    juce::LookAndFeel_V4 syncLookAndFeel;
-    
-    std::vector<juce::Component*> getComps();
-
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StrangeEchoesAudioProcessorEditor)
-};
+#pragma once
+
+#include "StrangeEchoesProcessor.h"
+
+
+struct RotarySliderWithLabels;
+
+struct LookAndFeel : juce::LookAndFeel_V4
+{
+    // For a RotarySliderWithLabels this only draws what depends on the value, the pointer and the
+    // value string; its body and title come from the slider's cached layer (see drawKnobBody)
+    void drawRotarySlider (juce::Graphics&,
+                                    int x, int y, int width, int height,
+                                    float sliderPosProportional,
+                                    float rotaryStartAngle,
+                                    float rotaryEndAngle,
+                                    juce::Slider&) override;
+    
+    // Knob body and title, which don't depend on the value
+    static void drawKnobBody(juce::Graphics&, juce::Rectangle<float> bounds, const RotarySliderWithLabels&);
+};
+
+struct RotarySliderWithLabels : juce::Slider
+{
+    RotarySliderWithLabels(juce::RangedAudioParameter& rap, const juce::String& unitSuffix):
+    juce::Slider(juce::Slider::SliderStyle::RotaryHorizontalVerticalDrag,juce::Slider::TextEntryBoxPosition::NoTextBox),
+    param(&rap),
+    suffix(unitSuffix)
+    {
+        setLookAndFeel(&lnf);
+    }
+    
+    ~RotarySliderWithLabels()
+    {
+        setLookAndFeel(nullptr);
+    }
+    
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    juce::Rectangle<int> getSliderBounds() const;
+    int getTextHeight() const {return 14;}
+    juce::String getDisplayString() const;
+    juce::String getTitleString() const;
+    
+    // Unrotated pointer, built once per size
+    const juce::Path& getPointerPath() const {return pointerPath;}
+    
+    private:
+    LookAndFeel lnf;
+    juce::RangedAudioParameter* param;
+    juce::String suffix;
+    
+    // Body and title pre-rendered at the display's pixel scale, so a value change only redraws the
+    // pointer and value string on top of a blit
+    juce::Image knobLayer;
+    float knobLayerScale{0.f};
+    juce::Path pointerPath;
+    
+};
+
+// Peak and RMS bars of a LevelMeter, one per channel, with a clip light that stays on until clicked.
+// It only repaints when a bar or the light has moved.
+struct LevelMeterComponent : juce::Component
+{
+    explicit LevelMeterComponent(const juce::String& meterLabel);
+    
+    // Message thread, once per editor timer tick
+    void update(LevelMeter& meter);
+    
+    void paint(juce::Graphics& g) override;
+    void mouseDown(const juce::MouseEvent&) override;
+    
+    private:
+    juce::Rectangle<int> getBarArea() const;
+    int getBarHeight(float decibels) const;
+    
+    juce::String label;
+    std::array<float, 2> peakDecibels{-100.f, -100.f}, rmsDecibels{-100.f, -100.f};
+    std::array<int, 2> peakHeights{}, rmsHeights{};
+    bool clipped{false};
+};
+
+// Scrolling dry and wet envelopes of the last few seconds, newest at the right edge, with a marker
+// wherever the current delay time and feedback put a repeat of what comes in now.
+//
+// Each new envelope point is drawn as a single column into an image that wraps around, and the
+// markers into a second image that is only redrawn when the settings or the size change, so a
+// repaint is just blitting the two.
+struct EchoDisplay : juce::Component
+{
+    EchoDisplay();
+    
+    // Message thread, once per editor timer tick
+    void update(Metering& metering);
+    
+    void paint(juce::Graphics& g) override;
+    void resized() override;
+    
+    private:
+    void drawPoint(juce::Graphics& g, const EchoEnvelopeFifo::Point& point);
+    void drawMarkers();
+    int getY(float level) const;
+    
+    juce::Image history, markers;
+    int writeColumn{0};
+    
+    float markerDelayTimeMs{-1.f}, markerFeedback{-1.f};
+    std::array<EchoEnvelopeFifo::Point, 256> incoming;
+};
+
+
+//==============================================================================
+class StrangeEchoesAudioProcessorEditor final : public juce::AudioProcessorEditor,
+                                                private juce::Timer
+{
+public:
+    explicit StrangeEchoesAudioProcessorEditor (StrangeEchoesAudioProcessor&);
+    ~StrangeEchoesAudioProcessorEditor() override;
+
+    //==============================================================================
+    void paint (juce::Graphics&) override;
+    void resized() override;
+
+private:
+    // Static background, the part of paint() that only changes with the size
+    void drawBackground(juce::Graphics& g);
+    
+    // Drains the processor's metering, at the display frame rate
+    void timerCallback() override;
+    
+    static constexpr int visualiserHeight = 80;
+    
+    // This reference is provided as a quick way for your editor to
+    // access the processor object that created it.
+    using APVTS = juce::AudioProcessorValueTreeState;
+    using Attachment = APVTS::SliderAttachment;
+    
+    StrangeEchoesAudioProcessor& processorRef;
+    
+    RotarySliderWithLabels dryWetSlider,
+    delayTimeSlider,
+    feedbackSlider,
+    freqShiftSlider,
+    sidebandSlider,
+    pitchShiftSlider,
+    pitchShiftAmountSlider,
+    //lowPassSlider,
+    //highPassSlider,
+    lfoAmountSlider,
+    lfoRateSlider;
+    
+    juce::Slider lowPassSlider, highPassSlider;
+    juce::Label lowPassLabel, highPassLabel;
+    
+    juce::Slider syncSlider, noteSelector, noteTypeSlider;
+
+    Attachment dryWetSliderAttachment,
+    delayTimeSliderAttachment,
+    feedbackSliderAttachment,
+    freqShiftSliderAttachment,
+    sidebandSliderAttachment,
+    pitchShiftSliderAttachment,
+    pitchShiftAmountSliderAttachment,
+    lowPassSliderAttachment,
+    highPassSliderAttachment,
+    lfoAmountSliderAttachment,
+    lfoRateSliderAttachment,
+    syncSliderAttachment,
+    noteSelectorAttachment,
+    noteTypeSliderAttachment;
+    
+    
+    juce::LookAndFeel_V4 syncLookAndFeel;
+    
+    // drawBackground() rendered at the display's pixel scale, dropped on resize
+    juce::Image backgroundImage;
+    float backgroundScale{0.f};
+    
+    LevelMeterComponent inputMeter{"IN"}, outputMeter{"OUT"};
+    EchoDisplay echoDisplay;
+    
+    std::vector<juce::Component*> getComps();
+
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StrangeEchoesAudioProcessorEditor)
+};
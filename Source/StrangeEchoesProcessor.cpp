@@ -1,655 +1,1867 @@
-#include "StrangeEchoesProcessor.h"
-#include "StrangeEchoesEditor.h"
-
-//==============================================================================
-StrangeEchoesAudioProcessor::StrangeEchoesAudioProcessor()
-     : AudioProcessor (BusesProperties()
-                     #if ! JucePlugin_IsMidiEffect
-                      #if ! JucePlugin_IsSynth
-                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
-                      #endif
-                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
-                     #endif
-                       )
-{
-    apvts.state = juce::ValueTree("savedParams");
-}
-
-StrangeEchoesAudioProcessor::~StrangeEchoesAudioProcessor()
-{
-}
-
-//==============================================================================
-const juce::String StrangeEchoesAudioProcessor::getName() const
-{
-    return JucePlugin_Name;
-}
-
-bool StrangeEchoesAudioProcessor::acceptsMidi() const
-{
-   #if JucePlugin_WantsMidiInput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool StrangeEchoesAudioProcessor::producesMidi() const
-{
-   #if JucePlugin_ProducesMidiOutput
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-bool StrangeEchoesAudioProcessor::isMidiEffect() const
-{
-   #if JucePlugin_IsMidiEffect
-    return true;
-   #else
-    return false;
-   #endif
-}
-
-double StrangeEchoesAudioProcessor::getTailLengthSeconds() const
-{
-    return 0.0;
-}
-
-int StrangeEchoesAudioProcessor::getNumPrograms()
-{
-    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
-                // so this should be at least 1, even if you're not really implementing programs.
-}
-
-int StrangeEchoesAudioProcessor::getCurrentProgram()
-{
-    return 0;
-}
-
-void StrangeEchoesAudioProcessor::setCurrentProgram (int index)
-{
-    juce::ignoreUnused (index);
-}
-
-const juce::String StrangeEchoesAudioProcessor::getProgramName (int index)
-{
-    juce::ignoreUnused (index);
-    return {};
-}
-
-void StrangeEchoesAudioProcessor::changeProgramName (int index, const juce::String& newName)
-{
-    juce::ignoreUnused (index, newName);
-}
-
-//==============================================================================
-void StrangeEchoesAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
-{
-    auto effectSettings = getEffectSettings(apvts, 120.0);
-    
-    // Prepare delay lines
-    wetSignal.setSize(2, samplesPerBlock);
-    wetSignal.clear(0, 0, samplesPerBlock);
-    wetSignal.clear(1, 0, samplesPerBlock);
-        
-    auto delayBufferSize = 2.5 * sampleRate;
-    delayBuffer.setSize(2, (int)delayBufferSize);
-    delayBuffer.clear(0, 0, (int)delayBufferSize);
-    delayBuffer.clear(1, 0, (int)delayBufferSize);
-    
-    delayTimeMsSmooth.reset(sampleRate / samplesPerBlock, 0.5f);
-    
-    // Prepare filter chains
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = static_cast<uint32_t>(samplesPerBlock);
-    spec.numChannels = 1;
-    
-    filterChainL.prepare(spec);
-    filterChainR.prepare(spec);
-  
-    updateFilterChains(effectSettings.lowPassFreq, effectSettings.highPassFreq, sampleRate);
-    
-    // Prepare LFO
-    lfoPhase = 0.0f;
-    
-    
-    // prepare pitch shifter
-    // TODO: consider changing pitch shift preset based on block size (weird noises when buffer size < 128)
-    tmpPitchShiftInput.setSize(2, samplesPerBlock);
-    tmpPitchShiftOutput.setSize(2, samplesPerBlock);
-    
-    if (samplesPerBlock <= 128)
-        pitchShifter.configure(2, sampleRate * 0.05, sampleRate * 0.02); //even cheaper
-    else
-        pitchShifter.presetCheaper(2, sampleRate);
-    
-    pitchShifter.setTransposeSemitones(effectSettings.pitchShift);
-    
-    freqShifter.prepare(sampleRate, samplesPerBlock);
-}
-
-void StrangeEchoesAudioProcessor::releaseResources()
-{
-    // When playback stops, you can use this as an opportunity to free up any
-    // spare memory, etc.
-}
-
-bool StrangeEchoesAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
-{
-  #if JucePlugin_IsMidiEffect
-    juce::ignoreUnused (layouts);
-    return true;
-  #else
-    // This is the place where you check if the layout is supported.
-    // In this template code we only support mono or stereo.
-    // Some plugin hosts, such as certain GarageBand versions, will only
-    // load plugins that support stereo bus layouts.
-    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
-     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
-        return false;
-
-    // This checks if the input layout matches the output layout
-   #if ! JucePlugin_IsSynth
-    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
-        return false;
-   #endif
-
-    return true;
-  #endif
-}
-
-void StrangeEchoesAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
-                                              juce::MidiBuffer& midiMessages)
-{
-    juce::ignoreUnused (midiMessages);
-    juce::ScopedNoDenormals noDenormals;
-    auto totalNumInputChannels  = getTotalNumInputChannels();
-    auto totalNumOutputChannels = getTotalNumOutputChannels();
-
-    auto bufferSize = buffer.getNumSamples();
-    auto delayBufferSize = delayBuffer.getNumSamples();
-        
-    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
-        buffer.clear (i, 0, buffer.getNumSamples());
-    
-    // extract BPM from DAW (needs fix, works in Ableton but crashes when running in standalone mode)
-    float currentBpm { 120 };
-    if (auto bpmFromHost = *getPlayHead()->getPosition()->getBpm())
-            currentBpm = bpmFromHost;
-    
-    auto effectSettings = getEffectSettings(apvts, currentBpm);
-    delayTimeMsSmooth.setTargetValue(effectSettings.delayTimeMs);
-    
-    float LFOsample = std::sin(lfoPhase * 2 * juce::MathConstants<float>::pi);
-    
-    lfoPhase += static_cast<float>(bufferSize / getSampleRate() * effectSettings.lfoRate);
-    if (lfoPhase > 1)
-        lfoPhase -= 1.0f;
-    
-    float delayTimeMs = juce::jlimit(minDelayTimeMs, maxDelayTimeMs, delayTimeMsSmooth.getNextValue() + LFOsample * effectSettings.lfoAmount);
-    int delayTimeInSamples = static_cast<int>(delayTimeMs / 1000.0 * getSampleRate());
-    
-    int newReadPos = writePos - delayTimeInSamples;
-    newReadPos %= delayBufferSize;
-    if (newReadPos < 0)
-        newReadPos += delayBufferSize;
-    
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        // Writes input from buffer -> delayBuffer
-        writeToDelayBuffer(buffer, channel, channel, 1.0f, 1.0f, true);
-        
-        wetSignal.clear(channel, 0, bufferSize);
-        
-        // Reads from past values in delayBuffer -> wetSignal
-        if (newReadPos==readPos)
-            readFromDelayBuffer(wetSignal, channel, channel, newReadPos, 1.0f, 1.0f, true);
-        else
-        {
-            readFromDelayBuffer(wetSignal, channel, channel, readPos, 1.0f, 0.0f, true);
-            readFromDelayBuffer(wetSignal, channel, channel, newReadPos, 0.0f, 1.0f, false);
-        }
-    }
-    
-    // Update LP/HP filter parameters
-    updateFilterChains(effectSettings.lowPassFreq, effectSettings.highPassFreq, getSampleRate());
-    
-    // Process wet signals with LP/HP filter chains
-    juce::dsp::AudioBlock<float> block(wetSignal);
-    auto leftBlock = block.getSingleChannelBlock(0);
-    auto rightBlock = block.getSingleChannelBlock(1);
-    
-    juce::dsp::ProcessContextReplacing<float> leftContext(leftBlock);
-    juce::dsp::ProcessContextReplacing<float> rightContext(rightBlock);
-    
-    filterChainL.process(leftContext);
-    filterChainR.process(rightContext);
-    
-    // pitch shifter
-    float pitchShiftAmount = effectSettings.pitchShiftAmount;
-    
-    pitchShifter.setTransposeSemitones(effectSettings.pitchShift);
-    pitchShifter.process(wetSignal.getArrayOfReadPointers(), tmpPitchShiftInput.getNumSamples(), tmpPitchShiftOutput.getArrayOfWritePointers(), tmpPitchShiftOutput.getNumSamples());
-    
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        wetSignal.applyGain(channel, 0, bufferSize, 1.f - pitchShiftAmount);
-        wetSignal.addFromWithRamp(channel, 0, tmpPitchShiftOutput.getReadPointer(channel), tmpPitchShiftOutput.getNumSamples(), prevPitchShiftAmount, pitchShiftAmount);
-    }
-    
-    prevPitchShiftAmount = pitchShiftAmount;
-    
-    // frequency shifter
-    freqShifter.configure(effectSettings.freqShift, effectSettings.sideBandMix);
-    freqShifter.process(wetSignal.getArrayOfWritePointers(), bufferSize);
-    
-    float dryWetMix = effectSettings.drywet;
-    float feedback = effectSettings.feedback;
-    
-    for (int channel = 0; channel < totalNumInputChannels; ++channel)
-    {
-        // Writes feedback from wetSignal -> delayBuffer
-        writeToDelayBuffer(wetSignal, channel, channel, prevFeedback, feedback, false);
-                
-        // Scales input signal in buffer and adds wetSignal
-        buffer.applyGain(channel, 0, bufferSize, 1.f - dryWetMix);
-        buffer.addFromWithRamp(channel, 0, wetSignal.getReadPointer(channel), bufferSize, dryWetMix, dryWetMix);
-    }
-    
-    prevFeedback = feedback;
-    
-    readPos = newReadPos + bufferSize;
-    readPos %= delayBufferSize;
-    
-    writePos += bufferSize;
-    writePos %= delayBufferSize;
-}
-
-void StrangeEchoesAudioProcessor::updateFilterChains(float lowPassFreq, float highPassFreq, double sampleRate)
-{    
-    auto highPassCoefficients = juce::dsp::FilterDesign<float>::designIIRHighpassHighOrderButterworthMethod(highPassFreq, sampleRate, 4);
-    auto lowPassCoefficients = juce::dsp::FilterDesign<float>::designIIRLowpassHighOrderButterworthMethod(lowPassFreq, sampleRate, 4);
-    
-    auto& leftHighPass = filterChainL.get<0>();
-    *leftHighPass.get<0>().coefficients = *highPassCoefficients[0];
-    *leftHighPass.get<1>().coefficients = *highPassCoefficients[0];
-    
-    auto& rightHighPass = filterChainR.get<0>();
-    *rightHighPass.get<0>().coefficients = *highPassCoefficients[0];
-    *rightHighPass.get<1>().coefficients = *highPassCoefficients[0];
-    
-    auto& leftLowPass = filterChainL.get<1>();
-    *leftLowPass.get<0>().coefficients = *lowPassCoefficients[0];
-    *leftLowPass.get<1>().coefficients = *lowPassCoefficients[0];
-    
-    auto& rightLowPass = filterChainR.get<1>();
-    *rightLowPass.get<0>().coefficients = *lowPassCoefficients[0];
-    *rightLowPass.get<1>().coefficients = *lowPassCoefficients[0];
-}
-
-void FrequencyShifter::prepare(int sampleRate, int blockSize)
-{
-    this->tmpBufferI.setSize(1, blockSize);
-    this->tmpBufferI.clear(0, 0, blockSize);
-    this->tmpBufferQ.setSize(1, blockSize);
-    this->tmpBufferQ.clear(0, 0, blockSize);
-    
-    this->tmpBufferOscI.setSize(1, blockSize);
-    this->tmpBufferOscI.clear(0, 0, blockSize);
-    this->tmpBufferOscQ.setSize(1, blockSize);
-    this->tmpBufferOscQ.clear(0, 0, blockSize);
-    
-    juce::dsp::ProcessSpec spec;
-    spec.sampleRate = sampleRate;
-    spec.maximumBlockSize = static_cast<uint32_t>(blockSize);
-    spec.numChannels = 1;
-    
-    this->firFilterL.reset();
-    this->firFilterL.prepare(spec);
-    this->firFilterL.coefficients = coeffs;
-    
-    this->firFilterR.reset();
-    this->firFilterR.prepare(spec);
-    this->firFilterR.coefficients = coeffs;
-    
-    this->firDelay.setSize(2, firDelayInSamples);
-    this->firDelay.clear();
-    this->firDelayWritePosition = 0;
-    
-    this->oscI.prepare(spec);
-    this->oscI.initialise([](float x) { return std::sin(x); }, 128);
-    this->oscI.setFrequency(0.0f);
-    this->oscI.reset();
-    
-    this->oscQ.prepare(spec);
-    this->oscQ.initialise([](float x) { return std::cos(x); }, 128);
-    this->oscQ.setFrequency(0.0f);
-    this->oscQ.reset();
-}
-
-void FrequencyShifter::configure(float freq, float sidbandMix)
-{
-    this->oscI.setFrequency(freq);
-    this->oscQ.setFrequency(freq);
-    this->sideBandMix = sidbandMix;
-}
-
-void FrequencyShifter::process(float*const* bufferData, int bufferSize)
-{
-    
-    processOscillator(&this->tmpBufferOscI, &this->oscI);
-    processOscillator(&this->tmpBufferOscQ, &this->oscQ);
-    
-    for (int channel = 0; channel < 2; ++channel)
-    {
-        float* bufferChannelData = bufferData[channel];
-        float* tmpIData = this->tmpBufferI.getWritePointer(0);
-        float* tmpQData = this->tmpBufferQ.getWritePointer(0);
-        float* oscIData = this->tmpBufferOscI.getWritePointer(0);
-        float* oscQData = this->tmpBufferOscQ.getWritePointer(0);
-        float* firDelayData = this->firDelay.getWritePointer(channel);
-        
-        for (int i = 0; i < bufferSize; i++)
-        {
-            // Write to delay line
-            firDelayData[this->firDelayWritePosition] = bufferChannelData[i];
-    
-            // Read from delay line
-            int firDelayReadPosition = (this->firDelayWritePosition - this->firDelayInSamples) % this->firDelayInSamples;
-            if (firDelayReadPosition < 0)
-            {
-               firDelayReadPosition += this->firDelayInSamples;
-            }
-    
-            tmpIData[i] = firDelayData[firDelayReadPosition];
-    
-            this->firDelayWritePosition = (this->firDelayWritePosition + 1) % this->firDelayInSamples;
-        }
-        
-        tmpBufferQ.copyFrom(0, 0, bufferChannelData, bufferSize);
-        juce::dsp::AudioBlock<float> block(tmpBufferQ);
-        juce::dsp::ProcessContextReplacing<float> context(block);
-    
-        if (channel==0)
-            this->firFilterL.process(context);
-        else
-            this->firFilterR.process(context);
-    
-        for (int i = 0; i < bufferSize; i++)
-        {
-            float posSide = tmpIData[i] * oscIData[i] - tmpQData[i] * oscQData[i];
-            float negSide = tmpIData[i] * oscIData[i] + tmpQData[i] * oscQData[i];
-            
-            bufferChannelData[i] = this->sideBandMix * posSide + (1.f - this->sideBandMix) * negSide;
-        }
-    }
-}
-
-void FrequencyShifter::processOscillator(juce::AudioBuffer<float>* bufPtr,juce::dsp::Oscillator<float>* oscPtr)
-{
-    bufPtr->clear();
-    juce::dsp::AudioBlock<float> block(*bufPtr);
-    juce::dsp::ProcessContextReplacing<float> context(block);
-    oscPtr->process(context);
-}
-
-void StrangeEchoesAudioProcessor::writeToDelayBuffer(juce::AudioBuffer<float>& buffer,
-                                                   int channelIn, int channelOut,
-                                                   float startGain, float endGain,
-                                                   bool replacing)
-{
-    if (delayBuffer.getNumSamples() >= writePos + buffer.getNumSamples())
-    {
-        if (replacing)
-            delayBuffer.copyFrom(channelOut, writePos, buffer.getReadPointer (channelIn), buffer.getNumSamples());
-        else
-            delayBuffer.addFromWithRamp(channelOut, writePos, buffer.getReadPointer(channelIn), buffer.getNumSamples(), startGain, endGain);
-    }
-    else
-    {
-        auto numSamplesToEnd = delayBuffer.getNumSamples() - writePos;
-        auto numLeftoverSamples = buffer.getNumSamples() - numSamplesToEnd;
-        
-        if (replacing)
-        {
-            delayBuffer.copyFrom(channelOut, writePos, buffer.getReadPointer (channelIn), numSamplesToEnd);
-            delayBuffer.copyFrom(channelOut, 0, buffer.getReadPointer (channelIn, numSamplesToEnd), numLeftoverSamples);
-        }
-        else
-        {
-            delayBuffer.addFromWithRamp(channelOut, writePos, buffer.getReadPointer(channelIn), numSamplesToEnd, startGain, endGain);
-            delayBuffer.addFromWithRamp(channelOut, 0, buffer.getReadPointer(channelIn, numSamplesToEnd), numLeftoverSamples, startGain, endGain);
-        }
-    }
-}
-
-void StrangeEchoesAudioProcessor::readFromDelayBuffer(juce::AudioBuffer<float>& buffer,
-                                                    int channelIn, int channelOut,
-                                                    int rPos,
-                                                    float startGain, float endGain,
-                                                    bool replacing)
-{
-    if (delayBuffer.getNumSamples() > rPos + buffer.getNumSamples())
-    {
-        if (replacing)
-        {
-            buffer.copyFromWithRamp(channelOut, 0, delayBuffer.getReadPointer(channelIn, rPos), buffer.getNumSamples(), startGain, endGain);
-        }
-        else
-        {
-            buffer.addFromWithRamp(channelOut, 0, delayBuffer.getReadPointer(channelIn, rPos),      buffer.getNumSamples(), startGain,   endGain);
-        }
-    }
-    else
-    {
-        auto numSamplesToEnd = delayBuffer.getNumSamples() - rPos;
-        auto numLeftoverSamples = buffer.getNumSamples() - numSamplesToEnd;
-        auto midGain = juce::jmap(float (numSamplesToEnd) / buffer.getNumSamples(), startGain, endGain);
-                
-        if (replacing)
-        {
-            buffer.copyFromWithRamp(channelOut, 0,               delayBuffer.getReadPointer(channelIn, rPos), numSamplesToEnd, startGain, midGain);
-            buffer.copyFromWithRamp(channelOut, numSamplesToEnd, delayBuffer.getReadPointer(channelIn, 0   ), numLeftoverSamples, midGain, endGain);
-        }
-        else
-        {
-            buffer.addFromWithRamp(channelOut, 0,               delayBuffer.getReadPointer(channelIn, rPos), numSamplesToEnd,   startGain,   midGain);
-            buffer.addFromWithRamp(channelOut, numSamplesToEnd, delayBuffer.getReadPointer(channelIn, 0   ), numLeftoverSamples, midGain,           endGain);
-        }
-    }
-}
-
-//==============================================================================
-bool StrangeEchoesAudioProcessor::hasEditor() const
-{
-    return true; // (change this to false if you choose to not supply an editor)
-}
-
-juce::AudioProcessorEditor* StrangeEchoesAudioProcessor::createEditor()
-{
-    return new StrangeEchoesAudioProcessorEditor (*this);
-}
-
-//==============================================================================
-void StrangeEchoesAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
-{
-    // You should use this method to store your parameters in the memory block.
-    // You could do that either as raw data, or use the XML or ValueTree classes
-    // as intermediaries to make it easy to save and load complex data.
-    
-    std::unique_ptr <juce::XmlElement> xml (apvts.state.createXml());
-    copyXmlToBinary(*xml, destData);
-    
-    //juce::ignoreUnused (destData);
-}
-
-void StrangeEchoesAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
-{
-    // You should use this method to restore your parameters from this memory block,
-    // whose contents will have been created by the getStateInformation() call.
-    
-    std::unique_ptr<juce::XmlElement> storedParams (getXmlFromBinary(data, sizeInBytes));
-    
-    if (storedParams != nullptr)
-    {
-        if (storedParams -> hasTagName(apvts.state.getType()))
-        {
-            apvts.state = juce::ValueTree::fromXml(*storedParams);
-        }
-    }
-    
-    //juce::ignoreUnused (data, sizeInBytes);
-}
-
-EffectSettings getEffectSettings(juce::AudioProcessorValueTreeState& apvts, float bpm)
-{
-    EffectSettings settings;
-    
-    settings.syncOption = static_cast<int>(apvts.getRawParameterValue("Sync Options")->load());
-    
-    if (settings.syncOption == 0)
-        settings.delayTimeMs =  apvts.getRawParameterValue("Delay Time")->load();
-    else
-    {
-        float baseDelayTime = 2000.0 * 120.0 / bpm;
-        float typeMult = 1.0;
-        
-        int noteOption = static_cast<int>(apvts.getRawParameterValue("Tempo-Relative Delay Time")->load());
-        int noteType = static_cast<int>(apvts.getRawParameterValue("Note Type")->load());
-        
-        switch (noteType)
-        {
-            case 1: // triplets
-                typeMult = 2.0 / 3.0;
-                break;
-            case 2: // dotted
-                typeMult = 3.0 / 2.0;
-        }
-        
-        switch (noteOption)
-        {
-            case 0: // 1/1 notes
-                settings.delayTimeMs = typeMult * baseDelayTime;
-                break;
-            case 1: // 1/2 notes
-                settings.delayTimeMs = typeMult * baseDelayTime / 2;
-                break;
-            case 2: // 1/4 notes
-                settings.delayTimeMs = typeMult * baseDelayTime / 4;
-                break;
-            case 3: // 1/8 notes
-                settings.delayTimeMs = typeMult * baseDelayTime / 8;
-                break;
-            case 4: // 1/16 notes
-                settings.delayTimeMs = typeMult * baseDelayTime / 16;
-        }
-    }
-    
-    settings.feedback =     apvts.getRawParameterValue("Feedback")->load();
-    settings.drywet =       apvts.getRawParameterValue("Dry/Wet Mix")->load();
-    settings.lfoRate =      apvts.getRawParameterValue("LFO Rate")->load();
-    settings.lfoAmount =    apvts.getRawParameterValue("LFO Amount")->load();
-    settings.freqShift =    apvts.getRawParameterValue("Frequency Shift")->load();
-    settings.sideBandMix =  apvts.getRawParameterValue("Sideband Mix")->load();
-    settings.pitchShift =   apvts.getRawParameterValue("Pitch Shift")->load();
-    settings.pitchShiftAmount =   apvts.getRawParameterValue("Pitch Shift Amount")->load();
-    settings.lowPassFreq =  apvts.getRawParameterValue("LowPass Freq")->load();
-    settings.highPassFreq = apvts.getRawParameterValue("HighPass Freq")->load();
-    
-    return settings;
-}
-
-juce::AudioProcessorValueTreeState::ParameterLayout StrangeEchoesAudioProcessor::createParameterLayout()
-{
-    juce::AudioProcessorValueTreeState::ParameterLayout layout;
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Delay Time",
-                                                           "Delay Time",
-                                                           juce::NormalisableRange<float>(1.0f, 2500.0f, 1.f, 1.f),
-                                                           300.0f));
-    
-    juce::StringArray strSyncOptions;
-    strSyncOptions.add("Time");
-    strSyncOptions.add("Sync");
-    
-    layout.add(std::make_unique<juce::AudioParameterChoice>("Sync Options", "Sync Options", strSyncOptions, 0));
-    
-    juce::StringArray strNoteOptions;
-    strNoteOptions.add("1/1");
-    strNoteOptions.add("1/2");
-    strNoteOptions.add("1/4");
-    strNoteOptions.add("1/8");
-    strNoteOptions.add("1/16");
-    
-    layout.add(std::make_unique<juce::AudioParameterChoice>("Tempo-Relative Delay Time", "Tempo-Relative Delay Time", strNoteOptions, 2));
-    
-    juce::StringArray strNoteType;
-    strNoteType.add("Notes");
-    strNoteType.add("Triplets");
-    strNoteType.add("Dotted");
-
-    layout.add(std::make_unique<juce::AudioParameterChoice>("Note Type", "Note Type", strNoteType, 0));
-
-        
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Dry/Wet Mix",
-                                                           "Dry/Wet",
-                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f, 1.f),
-                                                           0.5f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Feedback",
-                                                           "Feedback",
-                                                           juce::NormalisableRange<float>(0.0f, 0.99f, 0.01f, 1.f),
-                                                           0.1f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Frequency Shift",
-                                                           "Frequency Shift",
-                                                           juce::NormalisableRange<float>(0.0f, 1000.f, 0.1f, 1.f),
-                                                           0.0f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Sideband Mix",
-                                                           "Sideband Mix",
-                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f, 1.f),
-                                                           0.f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Pitch Shift",
-                                                           "Pitch Shift",
-                                                           juce::NormalisableRange<float>(-12.f, 12.f, 1.f, 1.f),
-                                                           0.0f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>("Pitch Shift Amount",
-                                                           "Pitch Shift Amount",
-                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f, 1.f),
-                                                           0.f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LowPass Freq",
-                                                           "Low Pass Filter",
-                                                           juce::NormalisableRange<float>(20.0f, 22000.f, 0.1f, 1.f / std::log2(1.f + std::sqrt(22000.f / 20.0f))),
-                                                           22000.0f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>("HighPass Freq",
-                                                           "High Pass Filter",
-                                                           juce::NormalisableRange<float>(20.0f, 22000.f, 0.1f, 1.f / std::log2(1.f + std::sqrt(22000.f / 20.0f))),
-                                                           20.0f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LFO Amount",
-                                                           "LFO Amount",
-                                                           juce::NormalisableRange<float>(-100.0f, 100.0f, 1.f, 1.f),
-                                                           0.0f));
-    
-    layout.add(std::make_unique<juce::AudioParameterFloat>("LFO Rate",
-                                                           "LFO Rate",
-                                                           juce::NormalisableRange<float>(0.0f, 10.0f, 0.1f, 1.f),
-                                                           0.0f));
-    
-    return layout;
-}
-
-//==============================================================================
-// This creates new instances of the plugin..
-juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
-{
-    return new StrangeEchoesAudioProcessor();
-}
+#include "StrangeEchoesProcessor.h"
+#include "StrangeEchoesEditor.h"
+
+namespace
+{
+    // Float views of the wet path's channels, for the stages that only run in float. Float channels
+    // are used as they are; double ones go through scratch, copied in by toFloat and back by fromFloat.
+    template <typename SampleType>
+    float* const* asFloat(SampleType* const* channels, juce::AudioBuffer<float>& scratch)
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+        {
+            juce::ignoreUnused(scratch);
+            return channels;
+        }
+        else
+        {
+            juce::ignoreUnused(channels);
+            return scratch.getArrayOfWritePointers();
+        }
+    }
+    
+    template <typename SampleType>
+    float* const* toFloat(SampleType* const* channels, juce::AudioBuffer<float>& scratch, int numChannels, int numSamples)
+    {
+        auto* floats = asFloat(channels, scratch);
+        
+        if constexpr (! std::is_same_v<SampleType, float>)
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < numSamples; ++i)
+                    floats[channel][i] = static_cast<float>(channels[channel][i]);
+        
+        return floats;
+    }
+    
+    template <typename SampleType>
+    void fromFloat(const float* const* floats, SampleType* const* channels, int numChannels, int numSamples)
+    {
+        if constexpr (std::is_same_v<SampleType, float>)
+            juce::ignoreUnused(floats, channels, numChannels, numSamples);
+        else
+            for (int channel = 0; channel < numChannels; ++channel)
+                for (int i = 0; i < numSamples; ++i)
+                    channels[channel][i] = floats[channel][i];
+    }
+}
+
+//==============================================================================
+StrangeEchoesAudioProcessor::StrangeEchoesAudioProcessor()
+     : AudioProcessor (BusesProperties()
+                     #if ! JucePlugin_IsMidiEffect
+                      #if ! JucePlugin_IsSynth
+                       .withInput  ("Input",  juce::AudioChannelSet::stereo(), true)
+                      #endif
+                       .withOutput ("Output", juce::AudioChannelSet::stereo(), true)
+                     #endif
+                       )
+{
+    apvts.state = juce::ValueTree("savedParams");
+    apvts.addParameterListener("Pitch Shift Quality", this);
+    startTimer(20);
+}
+
+StrangeEchoesAudioProcessor::~StrangeEchoesAudioProcessor()
+{
+    apvts.removeParameterListener("Pitch Shift Quality", this);
+    stopTimer();
+}
+
+//==============================================================================
+const juce::String StrangeEchoesAudioProcessor::getName() const
+{
+    return JucePlugin_Name;
+}
+
+bool StrangeEchoesAudioProcessor::acceptsMidi() const
+{
+   #if JucePlugin_WantsMidiInput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool StrangeEchoesAudioProcessor::producesMidi() const
+{
+   #if JucePlugin_ProducesMidiOutput
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+bool StrangeEchoesAudioProcessor::isMidiEffect() const
+{
+   #if JucePlugin_IsMidiEffect
+    return true;
+   #else
+    return false;
+   #endif
+}
+
+double StrangeEchoesAudioProcessor::getTailLengthSeconds() const
+{
+    return tailLengthSeconds.load(std::memory_order_relaxed);
+}
+
+int StrangeEchoesAudioProcessor::getNumPrograms()
+{
+    return 1;   // NB: some hosts don't cope very well if you tell them there are 0 programs,
+                // so this should be at least 1, even if you're not really implementing programs.
+}
+
+int StrangeEchoesAudioProcessor::getCurrentProgram()
+{
+    return 0;
+}
+
+void StrangeEchoesAudioProcessor::setCurrentProgram (int index)
+{
+    juce::ignoreUnused (index);
+}
+
+const juce::String StrangeEchoesAudioProcessor::getProgramName (int index)
+{
+    juce::ignoreUnused (index);
+    return {};
+}
+
+void StrangeEchoesAudioProcessor::changeProgramName (int index, const juce::String& newName)
+{
+    juce::ignoreUnused (index, newName);
+}
+
+//==============================================================================
+void StrangeEchoesAudioProcessor::prepareToPlay (double sampleRate, int samplesPerBlock)
+{
+    // Any pending quality change is picked up by the pitch shifters' prepare below. Stopped until
+    // they are, then restarted at the end.
+    stopTimer();
+    
+    // Read the current values now, and have the first block treat every setting as changed
+    settingsSnapshot.update(120.f);
+    auto effectSettings = settingsSnapshot.get();
+    settingsSnapshot.reset();
+    
+    delayTimes.setSize(Lfo::maxChannels, samplesPerBlock);
+    
+    delayTimeMsSmooth.reset(sampleRate, 0.5f);
+    delayTimeMsSmooth.setCurrentAndTargetValue(effectSettings.delayTimeMs);
+    
+    smoothedSettings.prepare(sampleRate, effectSettings);
+    prevDryWetMix = effectSettings.drywet;
+    prevFeedback = effectSettings.feedback;
+    
+    auto initialFeedbackMatrix = getFeedbackMatrix(effectSettings.feedbackRouting, effectSettings.crossFeedback);
+    
+    for (size_t j = 0; j < feedbackMatrix.size(); ++j)
+    {
+        feedbackMatrix[j].reset(sampleRate, 0.02);
+        feedbackMatrix[j].setCurrentAndTargetValue(initialFeedbackMatrix[j]);
+        prevFeedbackGains[j] = initialFeedbackMatrix[j] * effectSettings.feedback;
+    }
+    
+    lowPassCoefficients.prepare(ButterworthCutCoefficients::Type::lowPass, sampleRate, effectSettings.lowPassFreq);
+    highPassCoefficients.prepare(ButterworthCutCoefficients::Type::highPass, sampleRate, effectSettings.highPassFreq);
+    filtersUpdating = true;
+    
+    // Prepare LFO
+    lfo.setShape(static_cast<Lfo::Shape>(effectSettings.lfoShape));
+    lfo.setStereoOffset(effectSettings.lfoStereoOffset / 360.0);
+    lfo.prepare(sampleRate);
+    transport.prepare(sampleRate);
+    
+    
+    // prepare pitch shifter
+    auto pitchShiftQuality = getPitchShiftQuality(effectSettings.pitchShiftQuality, samplesPerBlock);
+    
+    pitchShifter.prepare(2, sampleRate, samplesPerBlock, pitchShiftQuality);
+    pitchShifter.setTransposeSemitones(effectSettings.pitchShift);
+    
+    // A whole block can be pushed before the worker sees any of it, and it then gets one more
+    // block period to process it
+    backgroundPitchShiftLatency = 2 * samplesPerBlock;
+    
+    backgroundPitchShifter.prepare(2, sampleRate, samplesPerBlock, backgroundPitchShiftLatency, pitchShiftQuality);
+    backgroundPitchShifter.setTransposeSemitones(effectSettings.pitchShift);
+    backgroundPitchShifter.setActive(effectSettings.pitchShiftMode == 1);
+    backgroundPitchShifter.start();
+    
+    // Delay line, filters, frequency shifter and scratch in the precision the host asked for
+    if (isUsingDoublePrecision())
+        prepareWetChain(doubleChain, effectSettings, sampleRate, samplesPerBlock);
+    else
+        prepareWetChain(floatChain, effectSettings, sampleRate, samplesPerBlock);
+    
+    pitchShifterRunning = false;
+    pitchShiftInBackground = effectSettings.pitchShiftMode == 1;
+    activeLatencySamples.store(pitchShiftInBackground ? backgroundPitchShiftLatency : 0, std::memory_order_release);
+    setLatencySamples(activeLatencySamples.load(std::memory_order_relaxed));
+    
+    // prepare saturation
+    saturator.prepare(2, sampleRate, samplesPerBlock);
+    saturator.setOversampling(static_cast<Saturator::Oversampling>(effectSettings.saturationOversampling));
+    saturator.setEnabled(effectSettings.saturation != 0);
+    saturator.reset();
+    prevSaturationDrive = juce::Decibels::decibelsToGain(effectSettings.saturationDrive);
+    
+    // Taps start where they are, after the latency they depend on is known
+    bool tapFeedbackActive = false;
+    updateDelayTaps(smoothedSettings.advance(0), true, tapFeedbackActive);
+    
+    metering.prepare(sampleRate);
+    
+    updateTailLength(effectSettings);
+    idleDetector.reset();
+    idle.store(false, std::memory_order_relaxed);
+    
+    pitchShiftQualityChanged.store(false, std::memory_order_release);
+    startTimer(20);
+}
+
+template <typename SampleType>
+void StrangeEchoesAudioProcessor::prepareWetChain(WetChain<SampleType>& chain, const EffectSettings& effectSettings,
+                                                  double sampleRate, int samplesPerBlock)
+{
+    chain.wetSignal.setSize(2, samplesPerBlock);
+    chain.wetSignal.clear();
+    chain.tapFeedback.setSize(2, samplesPerBlock);
+    chain.pitchShiftOutput.setSize(2, samplesPerBlock);
+    
+    // Modulated delay times are clamped to maxDelayTimeMs
+    chain.delayLine.prepare(2, static_cast<int>(std::ceil(maxDelayTimeMs / 1000.0 * sampleRate)) + 1, samplesPerBlock);
+    chain.delayLine.setInterpolation(static_cast<DelayInterpolation>(effectSettings.delayInterpolation));
+    
+    // Prepare filter chains
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = static_cast<uint32_t>(samplesPerBlock);
+    spec.numChannels = 1;
+    
+    // Give every stage biquad-sized coefficients up front, so updates only overwrite values in place
+    for (auto* filterChain : { &chain.filterChainL, &chain.filterChainR })
+    {
+        auto& highPass = filterChain->template get<0>();
+        auto& lowPass = filterChain->template get<1>();
+        
+        *highPass.template get<0>().coefficients = juce::dsp::IIR::Coefficients<SampleType>(1, 0, 0, 1, 0, 0);
+        *highPass.template get<1>().coefficients = juce::dsp::IIR::Coefficients<SampleType>(1, 0, 0, 1, 0, 0);
+        *lowPass.template get<0>().coefficients = juce::dsp::IIR::Coefficients<SampleType>(1, 0, 0, 1, 0, 0);
+        *lowPass.template get<1>().coefficients = juce::dsp::IIR::Coefficients<SampleType>(1, 0, 0, 1, 0, 0);
+        
+        highPassCoefficients.copySectionTo(0, *highPass.template get<0>().coefficients);
+        highPassCoefficients.copySectionTo(1, *highPass.template get<1>().coefficients);
+        lowPassCoefficients.copySectionTo(0, *lowPass.template get<0>().coefficients);
+        lowPassCoefficients.copySectionTo(1, *lowPass.template get<1>().coefficients);
+        
+        filterChain->prepare(spec);
+    }
+    
+    chain.latencyDryDelay.prepare(2, backgroundPitchShiftLatency, samplesPerBlock);
+    chain.latencyDryDelay.setDelay(backgroundPitchShiftLatency);
+    chain.latencyWetDelay.prepare(2, backgroundPitchShiftLatency, samplesPerBlock);
+    chain.latencyWetDelay.setDelay(backgroundPitchShiftLatency);
+    
+    chain.freqShifter.setQuadratureMode(static_cast<typename FrequencyShifter<SampleType>::QuadratureMode>(effectSettings.shifterMode));
+    chain.freqShifter.prepare(static_cast<int>(sampleRate), samplesPerBlock);
+    
+    if constexpr (! std::is_same_v<SampleType, float>)
+    {
+        chain.floatWet.setSize(2, samplesPerBlock);
+        chain.floatPitchShiftOutput.setSize(2, samplesPerBlock);
+    }
+}
+
+template <typename SampleType>
+void StrangeEchoesAudioProcessor::clearWetChain(WetChain<SampleType>& chain)
+{
+    chain.delayLine.reset();
+    chain.filterChainL.reset();
+    chain.filterChainR.reset();
+    chain.latencyDryDelay.reset();
+    chain.latencyWetDelay.reset();
+    chain.freqShifter.reset();
+    saturator.reset();
+}
+
+void StrangeEchoesAudioProcessor::releaseResources()
+{
+    // When playback stops, you can use this as an opportunity to free up any
+    // spare memory, etc.
+    
+    backgroundPitchShifter.stop();
+    
+   #if STRANGE_ECHOES_RT_AUDIT
+    auto report = RealtimeAudit::getReport();
+    
+    if (! report.isClean())
+        DBG("Realtime audit violations in processBlock - " << report.toString());
+   #endif
+}
+
+bool StrangeEchoesAudioProcessor::isBusesLayoutSupported (const BusesLayout& layouts) const
+{
+  #if JucePlugin_IsMidiEffect
+    juce::ignoreUnused (layouts);
+    return true;
+  #else
+    // This is the place where you check if the layout is supported.
+    // In this template code we only support mono or stereo.
+    // Some plugin hosts, such as certain GarageBand versions, will only
+    // load plugins that support stereo bus layouts.
+    if (layouts.getMainOutputChannelSet() != juce::AudioChannelSet::mono()
+     && layouts.getMainOutputChannelSet() != juce::AudioChannelSet::stereo())
+        return false;
+
+    // This checks if the input layout matches the output layout
+   #if ! JucePlugin_IsSynth
+    if (layouts.getMainOutputChannelSet() != layouts.getMainInputChannelSet())
+        return false;
+   #endif
+
+    return true;
+  #endif
+}
+
+bool StrangeEchoesAudioProcessor::supportsDoublePrecisionProcessing() const
+{
+    return true;
+}
+
+void StrangeEchoesAudioProcessor::processBlock (juce::AudioBuffer<float>& buffer,
+                                              juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    process(buffer, floatChain);
+}
+
+void StrangeEchoesAudioProcessor::processBlock (juce::AudioBuffer<double>& buffer,
+                                              juce::MidiBuffer& midiMessages)
+{
+    juce::ignoreUnused (midiMessages);
+    process(buffer, doubleChain);
+}
+
+template <typename SampleType>
+void StrangeEchoesAudioProcessor::process(juce::AudioBuffer<SampleType>& buffer, WetChain<SampleType>& chain)
+{
+    STRANGE_ECHOES_REALTIME_SECTION;
+    juce::ScopedNoDenormals noDenormals;
+    STRANGE_ECHOES_PROFILE_BLOCK(profiler);
+    
+    // Only the wet chain of the precision set before prepareToPlay has been prepared
+    jassert(isUsingDoublePrecision() == std::is_same_v<SampleType, double>);
+    
+    // An unprepared chain has no scratch to split the block into; output silence rather than spin
+    if (chain.wetSignal.getNumSamples() <= 0)
+    {
+        buffer.clear();
+        return;
+    }
+    
+    auto totalNumInputChannels  = getTotalNumInputChannels();
+    auto totalNumOutputChannels = getTotalNumOutputChannels();
+
+    auto bufferSize = buffer.getNumSamples();
+        
+    for (auto i = totalNumInputChannels; i < totalNumOutputChannels; ++i)
+        buffer.clear (i, 0, buffer.getNumSamples());
+    
+    // Tempo and position from the host, if there is one
+    transport.update(getPlayHead(), bufferSize);
+    
+    auto settingsChanges = settingsSnapshot.update(static_cast<float>(transport.getBpm()));
+    const auto& effectSettings = settingsSnapshot.get();
+    
+    if (settingsChanges != EffectSettingsSnapshot::none)
+        smoothedSettings.setTargets(effectSettings);
+    
+    if (settingsChanges & EffectSettingsSnapshot::delayChanged)
+    {
+        chain.delayLine.setInterpolation(static_cast<DelayInterpolation>(effectSettings.delayInterpolation));
+        lfo.setShape(static_cast<Lfo::Shape>(effectSettings.lfoShape));
+        lfo.setStereoOffset(effectSettings.lfoStereoOffset / 360.0);
+    }
+    
+    if (settingsChanges & EffectSettingsSnapshot::pitchChanged)
+    {
+        pitchShifter.setTransposeSemitones(effectSettings.pitchShift);
+        backgroundPitchShifter.setTransposeSemitones(effectSettings.pitchShift);
+    }
+    
+    // Every block, a switch to the background mode may be waiting for the worker
+    setPitchShiftMode(effectSettings.pitchShiftMode);
+    
+    if (settingsChanges & EffectSettingsSnapshot::shifterChanged)
+        chain.freqShifter.setQuadratureMode(static_cast<typename FrequencyShifter<SampleType>::QuadratureMode>(effectSettings.shifterMode));
+    
+    if (settingsChanges & EffectSettingsSnapshot::filtersChanged)
+        filtersUpdating = true;
+    
+    if (settingsChanges & EffectSettingsSnapshot::saturationChanged)
+    {
+        saturator.setOversampling(static_cast<Saturator::Oversampling>(effectSettings.saturationOversampling));
+        saturator.setEnabled(effectSettings.saturation != 0);
+    }
+    
+    if (settingsChanges & (EffectSettingsSnapshot::delayChanged | EffectSettingsSnapshot::pitchChanged | EffectSettingsSnapshot::shifterChanged
+                           | EffectSettingsSnapshot::mixChanged | EffectSettingsSnapshot::tapsChanged | EffectSettingsSnapshot::saturationChanged))
+        updateTailLength(effectSettings);
+    
+    // The LFO picks up from the song position whenever playback starts or jumps, so synced patches
+    // play back the same every time. A synced cycle counts from the start of the song, as one longer
+    // than a bar doesn't start again with every bar; a free one counts from the bar start.
+    if (transport.hasRelocated())
+    {
+        if (effectSettings.lfoSync != 0)
+            lfo.setPhase(std::fmod(transport.getPpqPosition() / effectSettings.lfoCycleQuarters, 1.0));
+        else
+            lfo.setPhase(transport.getSecondsSinceBarStart() * effectSettings.lfoRate);
+    }
+    
+    metering.input.measure(buffer.getArrayOfReadPointers(), totalNumInputChannels, bufferSize);
+    metering.delayTimeMs.store(effectSettings.delayTimeMs, std::memory_order_relaxed);
+    metering.feedback.store(effectSettings.feedback, std::memory_order_relaxed);
+    
+    // Silent input and nothing audible left of the echoes: only the dry signal needs scaling
+    auto inputLevel = static_cast<float>(buffer.getMagnitude(0, bufferSize));
+    
+    if (idleDetector.canSkip(inputLevel))
+    {
+        // The delay line stops moving while idle, so what it held would otherwise come back on waking.
+        // It's silent by now, clearing it once is inaudible.
+        if (! idle.load(std::memory_order_relaxed))
+            clearWetChain(chain);
+        
+        auto settings = smoothedSettings.advance(bufferSize);
+        
+        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+            buffer.applyGainRamp(channel, 0, bufferSize, 1.f - prevDryWetMix, 1.f - settings.drywet);
+        
+        prevDryWetMix = settings.drywet;
+        
+        // Keeps the LFO in step with the host while there's nothing to modulate
+        lfo.setRate(settings.lfoRate);
+        lfo.advance(bufferSize);
+        
+        // Flushed on wake-up like after a bypass, rather than replaying what it held
+        pitchShifterRunning = false;
+        
+        const SampleType* dryChannels[2] = { buffer.getReadPointer(0), buffer.getReadPointer(totalNumInputChannels > 1 ? 1 : 0) };
+        metering.echoes.push<SampleType>(dryChannels, nullptr, totalNumInputChannels, bufferSize);
+        metering.output.measure(buffer.getArrayOfReadPointers(), totalNumOutputChannels, bufferSize);
+        
+        idleDetector.update(inputLevel, 0.f, bufferSize);
+        idle.store(true, std::memory_order_relaxed);
+        return;
+    }
+    
+    idle.store(false, std::memory_order_relaxed);
+    float echoLevel = 0.f;
+    
+    // Settings are ramped and applied once per sub-block, so automation resolution doesn't depend on the host block size.
+    // Every stage is sized for the prepared block size, so a host block larger than that is split too.
+    auto maxSubBlockLength = chain.wetSignal.getNumSamples();
+    auto subBlockLength = subBlockSize.load(std::memory_order_relaxed);
+    if (subBlockLength <= 0 || subBlockLength > maxSubBlockLength)
+        subBlockLength = maxSubBlockLength;
+    
+    for (int start = 0; start < bufferSize; start += subBlockLength)
+    {
+        auto numSamples = juce::jmin(subBlockLength, bufferSize - start);
+        auto settings = smoothedSettings.advance(numSamples);
+        
+        // Scratch for this sub-block only, always from its first sample
+        SampleType* wetChannels[2] = { chain.wetSignal.getWritePointer(0), chain.wetSignal.getWritePointer(1) };
+        
+        STRANGE_ECHOES_PROFILE_STAGE(DspStage::delayIO);
+        
+        auto numDelayTimeChannels = computeDelayTimes(settings, numSamples);
+        
+        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        {
+            // With the reported latency the dry signal is late, and echoes are taken from the late dry
+            // signal so they stay in time with it once the host compensates
+            if (pitchShiftInBackground)
+                chain.latencyDryDelay.process(channel, buffer.getReadPointer(channel, start), buffer.getWritePointer(channel, start), numSamples);
+            
+            // Writes input from buffer -> delayLine, then reads the modulated echo -> wetSignal
+            chain.delayLine.write(channel, buffer.getReadPointer(channel, start), numSamples);
+            chain.delayLine.read(channel, delayTimes.getReadPointer(juce::jmin(channel, numDelayTimeChannels - 1)), wetChannels[channel], numSamples);
+        }
+        
+        // Extra taps go into the wet signal ahead of the effect chain, in one pass over the delay line
+        // per channel. Their feedback sends are written back along with the main feedback.
+        bool tapFeedbackActive = false;
+        auto numActiveTaps = updateDelayTaps(settings, false, tapFeedbackActive);
+        
+        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        {
+            chain.delayLine.addTaps(channel, outputTaps[(size_t) channel].data(), numActiveTaps, wetChannels[channel], numSamples);
+            
+            if (tapFeedbackActive)
+            {
+                chain.tapFeedback.clear(channel, 0, numSamples);
+                chain.delayLine.addTaps(channel, feedbackTaps.data(), numActiveTaps, chain.tapFeedback.getWritePointer(channel), numSamples);
+            }
+        }
+        
+        STRANGE_ECHOES_PROFILE_STAGE(DspStage::filters);
+        
+        // Update LP/HP filter parameters
+        if (filtersUpdating)
+            filtersUpdating = updateFilterChains(chain, settings.lowPassFreq, settings.highPassFreq, numSamples);
+        
+        // Process wet signals with LP/HP filter chains
+        auto block = juce::dsp::AudioBlock<SampleType>(chain.wetSignal).getSubBlock(0, static_cast<size_t>(numSamples));
+        auto leftBlock = block.getSingleChannelBlock(0);
+        auto rightBlock = block.getSingleChannelBlock(1);
+        
+        juce::dsp::ProcessContextReplacing<SampleType> leftContext(leftBlock);
+        juce::dsp::ProcessContextReplacing<SampleType> rightContext(rightBlock);
+        
+        chain.filterChainL.process(leftContext);
+        chain.filterChainR.process(rightContext);
+        
+        // pitch shifter
+        STRANGE_ECHOES_PROFILE_STAGE(DspStage::pitchShifter);
+        
+        float pitchShiftAmount = settings.pitchShiftAmount;
+        
+        // Bypassed once the amount has ramped down to zero. On re-entry the stretcher is flushed so it
+        // doesn't replay stale audio, and the amount ramps up from zero as a crossfade.
+        bool pitchShifterActive = pitchShiftAmount > 0.f || prevPitchShiftAmount > 0.f;
+        SampleType* pitchChannels[2] = { chain.pitchShiftOutput.getWritePointer(0), chain.pitchShiftOutput.getWritePointer(1) };
+        
+        if (pitchShifterActive)
+        {
+            if (! pitchShifterRunning)
+            {
+                if (pitchShiftInBackground)
+                    backgroundPitchShifter.reset();
+                else
+                    pitchShifter.reset();
+                
+                pitchShifterRunning = true;
+            }
+            
+            // Both stretchers run in float
+            auto* floatIn = toFloat(wetChannels, chain.floatWet, 2, numSamples);
+            auto* floatOut = asFloat(pitchChannels, chain.floatPitchShiftOutput);
+            
+            if (pitchShiftInBackground)
+                backgroundPitchShifter.process(floatIn, floatOut, numSamples);
+            else
+                pitchShifter.process(floatIn, floatOut, numSamples);
+            
+            fromFloat(floatOut, pitchChannels, 2, numSamples);
+        }
+        else
+        {
+            pitchShifterRunning = false;
+        }
+        
+        // The unshifted echo waits for the worker's output, bypassed or not, so the latency stays fixed
+        if (pitchShiftInBackground)
+            for (int channel = 0; channel < totalNumInputChannels; ++channel)
+                chain.latencyWetDelay.process(channel, wetChannels[channel], wetChannels[channel], numSamples);
+        
+        if (pitchShifterActive)
+        {
+            auto amount = MixKernels::Ramp::between(prevPitchShiftAmount, pitchShiftAmount, numSamples);
+            
+            for (int channel = 0; channel < totalNumInputChannels; ++channel)
+                MixKernels::crossfade(wetChannels[channel], pitchChannels[channel], numSamples, amount);
+        }
+        
+        prevPitchShiftAmount = pitchShiftAmount;
+        
+        // frequency shifter
+        STRANGE_ECHOES_PROFILE_STAGE(DspStage::frequencyShifter);
+        
+        if (settings.freqShift != chain.freqShifter.oscFreqHz || settings.sideBandMix != chain.freqShifter.sideBandMix)
+            chain.freqShifter.configure(settings.freqShift, settings.sideBandMix);
+        
+        chain.freqShifter.process(wetChannels, numSamples);
+        
+        // saturation, ahead of the feedback write so every repeat goes through it again
+        STRANGE_ECHOES_PROFILE_STAGE(DspStage::saturation);
+        
+        auto saturationDrive = juce::Decibels::decibelsToGain(settings.saturationDrive);
+        
+        if (saturator.isActive())
+        {
+            auto* floatWet = toFloat(wetChannels, chain.floatWet, totalNumInputChannels, numSamples);
+            saturator.process(floatWet, totalNumInputChannels, numSamples, prevSaturationDrive, saturationDrive);
+            fromFloat(floatWet, wetChannels, totalNumInputChannels, numSamples);
+        }
+        
+        prevSaturationDrive = saturationDrive;
+        
+        STRANGE_ECHOES_PROFILE_STAGE(DspStage::output);
+        
+        float dryWetMix = settings.drywet;
+        float feedback = settings.feedback;
+        
+        // Writes feedback from wetSignal -> delayLine, through the routing matrix when stereo
+        auto routing = getFeedbackMatrix(settings.feedbackRouting, settings.crossFeedback);
+        std::array<float, 4> feedbackGains;
+        
+        for (size_t j = 0; j < feedbackGains.size(); ++j)
+        {
+            feedbackMatrix[j].setTargetValue(routing[j]);
+            feedbackGains[j] = feedbackMatrix[j].skip(numSamples) * feedback;
+        }
+        
+        const SampleType* dryChannels[2] = { buffer.getReadPointer(0, start), buffer.getReadPointer(totalNumInputChannels > 1 ? 1 : 0, start) };
+        metering.echoes.push<SampleType>(dryChannels, wetChannels, totalNumInputChannels, numSamples);
+        
+        // Everything written back into the delay line besides the input
+        for (int channel = 0; channel < totalNumInputChannels; ++channel)
+        {
+            echoLevel = juce::jmax(echoLevel, static_cast<float>(chain.wetSignal.getMagnitude(channel, 0, numSamples)));
+            
+            if (tapFeedbackActive)
+                echoLevel = juce::jmax(echoLevel, static_cast<float>(chain.tapFeedback.getMagnitude(channel, 0, numSamples)));
+        }
+        
+        if (totalNumInputChannels > 1)
+        {
+            // Feedback write and dry/wet mix in one pass over wetSignal
+            const SampleType* extraFeedback[2] = { chain.tapFeedback.getReadPointer(0), chain.tapFeedback.getReadPointer(1) };
+            SampleType* outChannels[2] = { buffer.getWritePointer(0, start), buffer.getWritePointer(1, start) };
+            
+            chain.delayLine.addFeedbackAndMix(wetChannels, tapFeedbackActive ? extraFeedback : nullptr, numSamples,
+                                        prevFeedbackGains, feedbackGains, outChannels, prevDryWetMix, dryWetMix);
+        }
+        else
+        {
+            chain.delayLine.addWithRamp(0, wetChannels[0], numSamples, prevFeedback, feedback);
+            
+            if (tapFeedbackActive)
+                chain.delayLine.addWithRamp(0, chain.tapFeedback.getReadPointer(0), numSamples, 1.f, 1.f);
+            
+            // Scales input signal in buffer and adds wetSignal
+            MixKernels::crossfade(buffer.getWritePointer(0, start), wetChannels[0], numSamples,
+                                  MixKernels::Ramp::between(prevDryWetMix, dryWetMix, numSamples));
+        }
+        
+        prevFeedback = feedback;
+        prevFeedbackGains = feedbackGains;
+        prevDryWetMix = dryWetMix;
+        
+        chain.delayLine.advance(numSamples);
+    }
+    
+    idleDetector.update(inputLevel, echoLevel, bufferSize);
+    
+    metering.output.measure(buffer.getArrayOfReadPointers(), totalNumOutputChannels, bufferSize);
+}
+
+int StrangeEchoesAudioProcessor::computeDelayTimes(const EffectSettings& effectSettings, int numSamples)
+{
+    // Smoothed delay time plus the LFO, both evaluated for every sample
+    const float samplesPerMs = static_cast<float>(getSampleRate() / 1000.0);
+    
+    // The rest of the wet path adds the background pitch shifter's and the saturation's latency, so the echo
+    // is read that much earlier to keep repeats at the set delay time. Echoes shorter than that come out late.
+    const float latencyInSamples = static_cast<float>(getWetLatencyInSamples());
+    
+    delayTimeMsSmooth.setTargetValue(effectSettings.delayTimeMs);
+    lfo.setRate(effectSettings.lfoRate);
+    
+    // Without modulation the LFO only keeps its phase running, and both channels share one delay
+    if (effectSettings.lfoAmount == 0.f)
+    {
+        float* delayData = delayTimes.getWritePointer(0);
+        lfo.advance(numSamples);
+        
+        for (int i = 0; i < numSamples; ++i)
+        {
+            float delayTimeMs = juce::jlimit(minDelayTimeMs, maxDelayTimeMs, delayTimeMsSmooth.getNextValue());
+            delayData[i] = juce::jmax(1.f, delayTimeMs * samplesPerMs - latencyInSamples);
+        }
+        
+        return 1;
+    }
+    
+    // The LFO writes its values into delayTimes, which are then turned into delays in place
+    const int numChannels = juce::jlimit(1, Lfo::maxChannels, getTotalNumInputChannels());
+    float* delayData[Lfo::maxChannels] = { delayTimes.getWritePointer(0), delayTimes.getWritePointer(1) };
+    lfo.process(delayData, numChannels, numSamples);
+    
+    for (int i = 0; i < numSamples; ++i)
+    {
+        float baseDelayTimeMs = delayTimeMsSmooth.getNextValue();
+        
+        for (int channel = 0; channel < numChannels; ++channel)
+        {
+            float delayTimeMs = juce::jlimit(minDelayTimeMs, maxDelayTimeMs, baseDelayTimeMs + delayData[channel][i] * effectSettings.lfoAmount);
+            delayData[channel][i] = juce::jmax(1.f, delayTimeMs * samplesPerMs - latencyInSamples);
+        }
+    }
+    
+    return numChannels;
+}
+
+int StrangeEchoesAudioProcessor::updateDelayTaps(const EffectSettings& effectSettings, bool reset, bool& feedbackActive)
+{
+    const float samplesPerMs = static_cast<float>(getSampleRate() / 1000.0);
+    
+    // Same latency compensation as the main echo in computeDelayTimes
+    const float latencyInSamples = static_cast<float>(getWetLatencyInSamples());
+    
+    const bool stereo = getTotalNumInputChannels() > 1;
+    
+    int numActive = 0;
+    feedbackActive = false;
+    
+    // Taps that are off have ramped their send to 0, so all of them can be summed
+    float totalTapFeedback = 0.f;
+    
+    for (const auto& tap : effectSettings.taps)
+        totalTapFeedback += tap.feedback;
+    
+    auto tapFeedbackScale = getTapFeedbackScale(effectSettings.feedback, totalTapFeedback);
+    
+    auto rampTo = [reset](DelayTap& tap, float delay, float gain)
+    {
+        tap.startDelay = reset ? delay : tap.endDelay;
+        tap.startGain = reset ? gain : tap.endGain;
+        tap.endDelay = delay;
+        tap.endGain = gain;
+        
+        return tap.startGain != 0.f || tap.endGain != 0.f;
+    };
+    
+    for (size_t k = 0; k < maxDelayTaps; ++k)
+    {
+        const auto& tap = effectSettings.taps[k];
+        auto timeMs = juce::jlimit(minDelayTimeMs, maxDelayTimeMs, tap.timeMs);
+        auto delay = juce::jmax(1.f, timeMs * samplesPerMs - latencyInSamples);
+        
+        // Balance rather than equal-power panning, so a centred tap keeps both channels at full level
+        float channelGains[2] = { tap.gain, tap.gain };
+        
+        if (stereo)
+        {
+            channelGains[0] *= juce::jmin(1.f, 1.f - tap.pan);
+            channelGains[1] *= juce::jmin(1.f, 1.f + tap.pan);
+        }
+        
+        for (size_t channel = 0; channel < 2; ++channel)
+            if (rampTo(outputTaps[channel][k], delay, channelGains[channel]))
+                numActive = static_cast<int>(k) + 1;
+        
+        if (rampTo(feedbackTaps[k], delay, tap.feedback * tapFeedbackScale))
+        {
+            numActive = static_cast<int>(k) + 1;
+            feedbackActive = true;
+        }
+    }
+    
+    return numActive;
+}
+
+void StrangeEchoesAudioProcessor::updateTailLength(const EffectSettings& effectSettings)
+{
+    // Longest echo, main or tap, and the loop gain as the sum of every feedback path. None of the
+    // routing matrices adds gain, and the filters only take energy out, so this is an upper bound.
+    auto longestDelayMs = juce::jlimit(minDelayTimeMs, maxDelayTimeMs, effectSettings.delayTimeMs + std::abs(effectSettings.lfoAmount));
+    float totalTapFeedback = 0.f;
+    
+    for (int k = 0; k < effectSettings.numTaps; ++k)
+    {
+        const auto& tap = effectSettings.taps[(size_t) k];
+        longestDelayMs = juce::jmax(longestDelayMs, juce::jlimit(minDelayTimeMs, maxDelayTimeMs, tap.timeMs));
+        totalTapFeedback += tap.feedback;
+    }
+    
+    auto loopGain = effectSettings.feedback + totalTapFeedback * getTapFeedbackScale(effectSettings.feedback, totalTapFeedback);
+    
+    // Whatever sits in the pitch shifters, the Hilbert and the oversampling filters, plus time for the
+    // filters to ring out
+    auto sampleRate = getSampleRate();
+    auto shifterLatency = isUsingDoublePrecision() ? doubleChain.freqShifter.getInPhaseDelayInSamples(doubleChain.freqShifter.quadratureMode)
+                                                   : floatChain.freqShifter.getInPhaseDelayInSamples(floatChain.freqShifter.quadratureMode);
+    auto chainLatency = pitchShifter.getLatencyInSamples() + backgroundPitchShiftLatency
+                      + shifterLatency + saturator.getLatencyInSamples()
+                      + static_cast<int>(0.1 * sampleRate);
+    
+    auto longestDelay = static_cast<int>(std::ceil(longestDelayMs / 1000.0 * sampleRate));
+    idleDetector.setHoldSamples(longestDelay + chainLatency);
+    
+    // Repeats until the loop has decayed below the silence threshold, the first echo included
+    double repeats = 1.0;
+    
+    if (loopGain >= 1.f)
+        repeats = std::numeric_limits<double>::infinity();
+    else if (loopGain > 0.f)
+        repeats += std::ceil(std::log(static_cast<double>(IdleDetector::silenceThreshold)) / std::log(static_cast<double>(loopGain)));
+    
+    tailLengthSeconds.store(repeats * longestDelayMs / 1000.0 + chainLatency / sampleRate, std::memory_order_relaxed);
+}
+
+int StrangeEchoesAudioProcessor::getWetLatencyInSamples() const
+{
+    return (pitchShiftInBackground ? backgroundPitchShiftLatency : 0)
+         + saturator.getLatencyInSamples();
+}
+
+void StrangeEchoesAudioProcessor::setPitchShiftMode(int mode)
+{
+    bool inBackground = mode == 1;
+    
+    if (inBackground == pitchShiftInBackground)
+        return;
+    
+    // The timer wakes the worker once the parameter asks for it, retried every block until it has
+    if (inBackground && ! backgroundPitchShifter.isActive())
+        return;
+    
+    // Whichever stretcher takes over starts from a flush, and the compensation delays from silence
+    pitchShiftInBackground = inBackground;
+    pitchShifterRunning = false;
+    activeLatencySamples.store(inBackground ? backgroundPitchShiftLatency : 0, std::memory_order_release);
+    
+    for (auto* delay : { &floatChain.latencyDryDelay, &floatChain.latencyWetDelay })
+        delay->reset();
+    
+    for (auto* delay : { &doubleChain.latencyDryDelay, &doubleChain.latencyWetDelay })
+        delay->reset();
+}
+
+std::array<float, 4> StrangeEchoesAudioProcessor::getFeedbackMatrix(int routing, float crossFeedback)
+{
+    switch (routing)
+    {
+        case 1:     // cross: part of each channel's echo comes back on the other side
+            return { 1.f - crossFeedback, crossFeedback, crossFeedback, 1.f - crossFeedback };
+        case 2:     // ping-pong: every repeat swaps sides
+            return { 0.f, 1.f, 1.f, 0.f };
+        case 3:     // mid/side: each repeat turns L/R into M/S and back, scaled to keep the level
+        {
+            constexpr float g = juce::MathConstants<float>::sqrt2 * 0.5f;
+            return { g, g, g, -g };
+        }
+        default:    // stereo: each channel feeds back into itself
+            return { 1.f, 0.f, 0.f, 1.f };
+    }
+}
+
+float StrangeEchoesAudioProcessor::getTapFeedbackScale(float feedback, float totalTapFeedback)
+{
+    if (feedback + totalTapFeedback <= maxLoopGain)
+        return 1.f;
+    
+    return juce::jmax(0.f, maxLoopGain - feedback) / totalTapFeedback;
+}
+
+PitchShiftQuality StrangeEchoesAudioProcessor::getPitchShiftQuality(int choice, int blockSize)
+{
+    switch (choice)
+    {
+        case 1:     return PitchShiftQuality::eco;
+        case 2:     return PitchShiftQuality::normal;
+        case 3:     return PitchShiftQuality::high;
+        default:    return blockSize <= 128 ? PitchShiftQuality::eco : PitchShiftQuality::normal;
+    }
+}
+
+void StrangeEchoesAudioProcessor::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    jassert(parameterID == "Pitch Shift Quality");
+    juce::ignoreUnused(parameterID);
+    
+    // The new stretchers are configured off the audio thread by the timer, then crossfaded in by it
+    auto quality = getPitchShiftQuality(static_cast<int>(newValue), getBlockSize());
+    pitchShifter.setQuality(quality);
+    backgroundPitchShifter.setQuality(quality);
+    pitchShiftQualityChanged.store(true, std::memory_order_release);
+}
+
+void StrangeEchoesAudioProcessor::timerCallback()
+{
+    // The latency of the pitch shift mode processBlock has actually switched to, whichever thread
+    // changed the parameter
+    auto latency = activeLatencySamples.load(std::memory_order_acquire);
+    
+    if (latency != getLatencySamples())
+        setLatencySamples(latency);
+    
+    // The worker only runs while the background mode is selected or processBlock is still in it, so
+    // it is woken before processBlock switches and put to sleep after it has switched back
+    backgroundPitchShifter.setActive(static_cast<int>(pitchShiftModeValue->load()) == 1 || latency != 0);
+    
+    // Retried until any swap still crossfading has finished. Cleared first, so a quality change
+    // arriving meanwhile is picked up on the next tick.
+    if (pitchShiftQualityChanged.exchange(false, std::memory_order_acq_rel) && ! pitchShifter.updateConfiguration())
+        pitchShiftQualityChanged.store(true, std::memory_order_release);
+}
+
+template <typename SampleType>
+bool StrangeEchoesAudioProcessor::updateFilterChains(WetChain<SampleType>& chain, float lowPassFreq, float highPassFreq, int numSamples)
+{
+    if (highPassCoefficients.update(highPassFreq, numSamples))
+    {
+        auto& leftHighPass = chain.filterChainL.template get<0>();
+        highPassCoefficients.copySectionTo(0, *leftHighPass.template get<0>().coefficients);
+        highPassCoefficients.copySectionTo(1, *leftHighPass.template get<1>().coefficients);
+        
+        auto& rightHighPass = chain.filterChainR.template get<0>();
+        highPassCoefficients.copySectionTo(0, *rightHighPass.template get<0>().coefficients);
+        highPassCoefficients.copySectionTo(1, *rightHighPass.template get<1>().coefficients);
+    }
+    
+    if (lowPassCoefficients.update(lowPassFreq, numSamples))
+    {
+        auto& leftLowPass = chain.filterChainL.template get<1>();
+        lowPassCoefficients.copySectionTo(0, *leftLowPass.template get<0>().coefficients);
+        lowPassCoefficients.copySectionTo(1, *leftLowPass.template get<1>().coefficients);
+        
+        auto& rightLowPass = chain.filterChainR.template get<1>();
+        lowPassCoefficients.copySectionTo(0, *rightLowPass.template get<0>().coefficients);
+        lowPassCoefficients.copySectionTo(1, *rightLowPass.template get<1>().coefficients);
+    }
+    
+    return highPassCoefficients.isSmoothing() || lowPassCoefficients.isSmoothing();
+}
+
+void SmoothedEffectSettings::prepare(double sampleRate, const EffectSettings& initial)
+{
+    this->targets = initial;
+    
+    auto init = [sampleRate](juce::SmoothedValue<float>& value, float initialValue)
+    {
+        value.reset(sampleRate, 0.02);
+        value.setCurrentAndTargetValue(initialValue);
+    };
+    
+    init(this->feedback,            initial.feedback);
+    init(this->drywet,              initial.drywet);
+    init(this->lfoRate,             initial.lfoRate);
+    init(this->lfoAmount,           initial.lfoAmount);
+    init(this->freqShift,           initial.freqShift);
+    init(this->sideBandMix,         initial.sideBandMix);
+    init(this->pitchShiftAmount,    initial.pitchShiftAmount);
+    init(this->saturationDrive,     initial.saturationDrive);
+    
+    for (size_t k = 0; k < maxDelayTaps; ++k)
+    {
+        const auto& tap = initial.taps[k];
+        bool enabled = static_cast<int>(k) < initial.numTaps;
+        
+        init(this->tapTimeMs[k],    tap.timeMs);
+        init(this->tapGain[k],      enabled ? tap.gain : 0.f);
+        init(this->tapPan[k],       tap.pan);
+        init(this->tapFeedback[k],  enabled ? tap.feedback : 0.f);
+        
+        // Glides like the main delay time
+        this->tapTimeMs[k].reset(sampleRate, 0.5);
+    }
+}
+
+void SmoothedEffectSettings::setTargets(const EffectSettings& target)
+{
+    this->targets = target;
+    
+    this->feedback.setTargetValue(target.feedback);
+    this->drywet.setTargetValue(target.drywet);
+    this->lfoRate.setTargetValue(target.lfoRate);
+    this->lfoAmount.setTargetValue(target.lfoAmount);
+    this->freqShift.setTargetValue(target.freqShift);
+    this->sideBandMix.setTargetValue(target.sideBandMix);
+    this->pitchShiftAmount.setTargetValue(target.pitchShiftAmount);
+    this->saturationDrive.setTargetValue(target.saturationDrive);
+    
+    for (size_t k = 0; k < maxDelayTaps; ++k)
+    {
+        const auto& tap = target.taps[k];
+        bool enabled = static_cast<int>(k) < target.numTaps;
+        
+        this->tapTimeMs[k].setTargetValue(tap.timeMs);
+        this->tapGain[k].setTargetValue(enabled ? tap.gain : 0.f);
+        this->tapPan[k].setTargetValue(tap.pan);
+        this->tapFeedback[k].setTargetValue(enabled ? tap.feedback : 0.f);
+    }
+}
+
+EffectSettings SmoothedEffectSettings::advance(int numSamples)
+{
+    auto settings = this->targets;
+    
+    settings.feedback =         this->feedback.skip(numSamples);
+    settings.drywet =           this->drywet.skip(numSamples);
+    settings.lfoRate =          this->lfoRate.skip(numSamples);
+    settings.lfoAmount =        this->lfoAmount.skip(numSamples);
+    settings.freqShift =        this->freqShift.skip(numSamples);
+    settings.sideBandMix =      this->sideBandMix.skip(numSamples);
+    settings.pitchShiftAmount = this->pitchShiftAmount.skip(numSamples);
+    settings.saturationDrive =  this->saturationDrive.skip(numSamples);
+    
+    for (size_t k = 0; k < maxDelayTaps; ++k)
+    {
+        auto& tap = settings.taps[k];
+        tap.timeMs =    this->tapTimeMs[k].skip(numSamples);
+        tap.gain =      this->tapGain[k].skip(numSamples);
+        tap.pan =       this->tapPan[k].skip(numSamples);
+        tap.feedback =  this->tapFeedback[k].skip(numSamples);
+    }
+    
+    return settings;
+}
+
+void IdleDetector::update(float inputLevel, float echoLevel, int numSamples)
+{
+    if (inputLevel < silenceThreshold && echoLevel < silenceThreshold)
+        silentSamples = silentSamples < holdSamples ? silentSamples + numSamples : silentSamples;
+    else
+        silentSamples = 0;
+}
+
+void ButterworthCutCoefficients::prepare(Type filterType, double sampleRate, float cutoffHz)
+{
+    this->type = filterType;
+    this->fs = sampleRate;
+    
+    this->cutoffSmooth.reset(sampleRate, 0.05);
+    this->cutoffSmooth.setCurrentAndTargetValue(cutoffHz);
+    
+    computeSections(cutoffHz);
+}
+
+bool ButterworthCutCoefficients::update(float targetCutoffHz, int numSamples)
+{
+    this->cutoffSmooth.setTargetValue(targetCutoffHz);
+    
+    if (! this->cutoffSmooth.isSmoothing())
+        return false;
+    
+    auto cutoffHz = this->cutoffSmooth.skip(numSamples);
+    
+    if (cutoffHz == this->computedCutoffHz)
+        return false;
+    
+    computeSections(cutoffHz);
+    return true;
+}
+
+template <typename SampleType>
+void ButterworthCutCoefficients::copySectionTo(int section, juce::dsp::IIR::Coefficients<SampleType>& coefficients) const
+{
+    jassert(coefficients.coefficients.size() == 5);
+    
+    auto& values = this->sections[(size_t) section];
+    auto* raw = coefficients.getRawCoefficients();
+    
+    for (size_t i = 0; i < values.size(); ++i)
+        raw[i] = static_cast<SampleType>(values[i]);
+}
+
+template void ButterworthCutCoefficients::copySectionTo<float>(int, juce::dsp::IIR::Coefficients<float>&) const;
+template void ButterworthCutCoefficients::copySectionTo<double>(int, juce::dsp::IIR::Coefficients<double>&) const;
+
+void ButterworthCutCoefficients::computeSections(float cutoffHz)
+{
+    // Bilinear transform of the analogue prototype, same form as IIR::Coefficients::makeLowPass/makeHighPass
+    // with the section Qs of a 4th order Butterworth: 1 / (2 cos(pi/8)) and 1 / (2 cos(3pi/8))
+    static constexpr double sectionQ[2] = { 0.54119610014619698, 1.3065629648763766 };
+    
+    this->computedCutoffHz = cutoffHz;
+    
+    auto freq = juce::jlimit(1.0, this->fs * 0.49, static_cast<double>(cutoffHz));
+    auto n = 1.0 / std::tan(juce::MathConstants<double>::pi * freq / this->fs);
+    auto nSquared = n * n;
+    
+    for (size_t i = 0; i < 2; ++i)
+    {
+        auto invQ = 1.0 / sectionQ[i];
+        auto c1 = 1.0 / (1.0 + invQ * n + nSquared);
+        auto& section = this->sections[i];
+        
+        if (this->type == Type::lowPass)
+        {
+            section[0] = c1;
+            section[1] = c1 * 2.0;
+            section[2] = c1;
+        }
+        else
+        {
+            section[0] = c1 * nSquared;
+            section[1] = c1 * -2.0 * nSquared;
+            section[2] = c1 * nSquared;
+        }
+        
+        section[3] = c1 * 2.0 * (1.0 - nSquared);
+        section[4] = c1 * (1.0 - invQ * n + nSquared);
+    }
+}
+
+template <typename SampleType>
+void FrequencyShifter<SampleType>::prepare(int sampleRate, int blockSize)
+{
+    this->tmpBufferI.setSize(2, blockSize);
+    this->tmpBufferI.clear();
+    this->tmpBufferQ.setSize(2, blockSize);
+    this->tmpBufferQ.clear();
+    
+    this->tmpBufferOscI.setSize(1, blockSize);
+    this->tmpBufferOscI.clear(0, 0, blockSize);
+    this->tmpBufferOscQ.setSize(1, blockSize);
+    this->tmpBufferOscQ.clear(0, 0, blockSize);
+    this->previousBufferI.setSize(2, blockSize);
+    this->previousBufferQ.setSize(2, blockSize);
+    
+    if constexpr (! std::is_same_v<SampleType, float>)
+    {
+        this->floatInput.setSize(2, blockSize);
+        this->floatQuadrature.setSize(2, blockSize);
+    }
+    
+    juce::dsp::ProcessSpec spec;
+    spec.sampleRate = sampleRate;
+    spec.maximumBlockSize = static_cast<uint32_t>(blockSize);
+    spec.numChannels = 1;
+    
+    this->hilbert.setKernel(firCoeffArray.getRawDataPointer(), static_cast<int>(filterSize));
+    this->hilbert.prepare(blockSize);
+    this->allpassHilbert.reset();
+    
+    this->longFilterSize = juce::jlimit(1024, 8192, juce::nextPowerOfTwo(juce::roundToInt(sampleRate * 0.09))) - 1;
+    auto longKernel = designHilbertKernel(this->longFilterSize);
+    this->longHilbert.prepare(longKernel.data(), this->longFilterSize, longFilterPartitionSize, 2);
+    
+    // Starts on the requested engine straight away, there is nothing to crossfade from
+    this->quadratureMode = this->requestedMode;
+    this->isChangingMode = false;
+    this->modeFadeLength = juce::roundToInt(sampleRate * 0.02);
+    
+    // Both sized for the longest in-phase delay so switching modes never reallocates
+    this->inPhaseDelay.prepare(2, getInPhaseDelayInSamples(QuadratureMode::linearPhaseLong), blockSize);
+    this->inPhaseDelay.setDelay(getInPhaseDelayInSamples(this->quadratureMode));
+    this->previousInPhaseDelay.prepare(2, getInPhaseDelayInSamples(QuadratureMode::linearPhaseLong), blockSize);
+    
+    // A 128 point table is plenty for float; in double the oscillators are evaluated exactly, so the
+    // table's interpolation error doesn't end up in the feedback loop
+    const size_t tableSize = std::is_same_v<SampleType, float> ? 128 : 0;
+    
+    this->oscI.prepare(spec);
+    this->oscI.initialise([](SampleType x) { return std::sin(x); }, tableSize);
+    this->oscI.setFrequency(0);
+    this->oscI.reset();
+    
+    this->oscQ.prepare(spec);
+    this->oscQ.initialise([](SampleType x) { return std::cos(x); }, tableSize);
+    this->oscQ.setFrequency(0);
+    this->oscQ.reset();
+    
+    // Same length as the oscillators' frequency ramp
+    this->bypassTimer.reset(sampleRate, 0.05);
+    this->bypassTimer.setCurrentAndTargetValue(this->oscFreqHz == 0.f ? 1.f : 0.f);
+}
+
+template <typename SampleType>
+void FrequencyShifter<SampleType>::reset()
+{
+    this->hilbert.reset();
+    this->allpassHilbert.reset();
+    this->longHilbert.reset();
+    this->inPhaseDelay.reset();
+    this->previousInPhaseDelay.reset();
+    this->isChangingMode = false;
+}
+
+template <typename SampleType>
+void FrequencyShifter<SampleType>::configure(float freq, float sidbandMix)
+{
+    this->oscFreqHz = freq;
+    this->oscI.setFrequency(freq);
+    this->oscQ.setFrequency(freq);
+    this->sideBandMix = sidbandMix;
+    this->bypassTimer.setTargetValue(freq == 0.f ? 1.f : 0.f);
+}
+
+template <typename SampleType>
+void FrequencyShifter<SampleType>::setQuadratureMode(QuadratureMode newMode)
+{
+    this->requestedMode = newMode;
+}
+
+template <typename SampleType>
+void FrequencyShifter<SampleType>::beginModeChange()
+{
+    this->previousMode = this->quadratureMode;
+    this->quadratureMode = this->requestedMode;
+    
+    // The outgoing engine keeps its in-phase history, the incoming one starts from silence
+    std::swap(this->inPhaseDelay, this->previousInPhaseDelay);
+    
+    auto delay = getInPhaseDelayInSamples(this->quadratureMode);
+    this->inPhaseDelay.setDelay(delay);
+    
+    switch (this->quadratureMode)
+    {
+        case QuadratureMode::linearPhase:       this->hilbert.reset();          break;
+        case QuadratureMode::lowLatency:        this->allpassHilbert.reset();   break;
+        case QuadratureMode::linearPhaseLong:   this->longHilbert.reset();      break;
+    }
+    
+    // The delay is half the FIR kernel plus any block latency, so twice that covers the whole kernel
+    this->modeFadePosition = -2 * delay;
+    this->isChangingMode = true;
+}
+
+template <typename SampleType>
+int FrequencyShifter<SampleType>::getInPhaseDelayInSamples(QuadratureMode mode) const
+{
+    switch (mode)
+    {
+        case QuadratureMode::linearPhase:       return hilbert.getLatencyInSamples();
+        case QuadratureMode::lowLatency:        return 0;
+        case QuadratureMode::linearPhaseLong:   return (longFilterSize - 1) / 2 + longHilbert.getLatencyInSamples();
+    }
+    
+    return 0;
+}
+
+template <typename SampleType>
+void FrequencyShifter<SampleType>::process(SampleType*const* bufferData, int bufferSize)
+{
+    if (this->requestedMode != this->quadratureMode && ! this->isChangingMode)
+        beginModeChange();
+    
+    if (this->bypassTimer.getTargetValue() == 1.f && ! this->bypassTimer.isSmoothing() && ! this->isChangingMode)
+    {
+        processBypassed(bufferData, bufferSize);
+        return;
+    }
+    
+    processOscillator(&this->tmpBufferOscI, &this->oscI, bufferSize);
+    processOscillator(&this->tmpBufferOscQ, &this->oscQ, bufferSize);
+    
+    processQuadrature(this->quadratureMode, this->inPhaseDelay, bufferData, this->tmpBufferI, this->tmpBufferQ, bufferSize);
+    
+    if (this->isChangingMode)
+        crossfadeFromPreviousMode(bufferData, bufferSize);
+    
+    this->bypassTimer.skip(bufferSize);
+    
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        SampleType* bufferChannelData = bufferData[channel];
+        SampleType* tmpIData = this->tmpBufferI.getWritePointer(channel);
+        SampleType* tmpQData = this->tmpBufferQ.getWritePointer(channel);
+        SampleType* oscIData = this->tmpBufferOscI.getWritePointer(0);
+        SampleType* oscQData = this->tmpBufferOscQ.getWritePointer(0);
+        
+        for (int i = 0; i < bufferSize; i++)
+        {
+            SampleType posSide = tmpIData[i] * oscIData[i] - tmpQData[i] * oscQData[i];
+            SampleType negSide = tmpIData[i] * oscIData[i] + tmpQData[i] * oscQData[i];
+            bufferChannelData[i] = this->sideBandMix * posSide + (1.f - this->sideBandMix) * negSide;
+        }
+    }
+}
+
+template <typename SampleType>
+void FrequencyShifter<SampleType>::processQuadrature(QuadratureMode mode, BlockDelayLine<SampleType>& inPhase, SampleType*const* bufferData,
+                                                     juce::AudioBuffer<SampleType>& outI, juce::AudioBuffer<SampleType>& outQ, int bufferSize)
+{
+    if (mode == QuadratureMode::lowLatency)
+    {
+        this->allpassHilbert.process(bufferData[0], bufferData[1],
+                                     outI.getWritePointer(0), outI.getWritePointer(1),
+                                     outQ.getWritePointer(0), outQ.getWritePointer(1),
+                                     bufferSize);
+        return;
+    }
+    
+    if (mode == QuadratureMode::linearPhaseLong)
+    {
+        auto* floatIn = toFloat(bufferData, this->floatInput, 2, bufferSize);
+        auto* floatQ = asFloat(outQ.getArrayOfWritePointers(), this->floatQuadrature);
+        
+        for (int channel = 0; channel < 2; ++channel)
+            this->longHilbert.process(channel, floatIn[channel], floatQ[channel], bufferSize);
+        
+        fromFloat(floatQ, outQ.getArrayOfWritePointers(), 2, bufferSize);
+    }
+    else
+    {
+        // Quadrature component of both channels in one pass
+        this->hilbert.process(bufferData[0], bufferData[1], outQ.getWritePointer(0), outQ.getWritePointer(1), bufferSize);
+    }
+    
+    // In-phase component is the input delayed to line up with the FIR
+    for (int channel = 0; channel < 2; ++channel)
+        inPhase.process(channel, bufferData[channel], outI.getWritePointer(channel), bufferSize);
+}
+
+template <typename SampleType>
+void FrequencyShifter<SampleType>::crossfadeFromPreviousMode(SampleType*const* bufferData, int bufferSize)
+{
+    processQuadrature(this->previousMode, this->previousInPhaseDelay, bufferData, this->previousBufferI, this->previousBufferQ, bufferSize);
+    
+    auto fadeStep = SampleType(1) / static_cast<SampleType>(this->modeFadeLength);
+    
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        SampleType* tmpIData = this->tmpBufferI.getWritePointer(channel);
+        SampleType* tmpQData = this->tmpBufferQ.getWritePointer(channel);
+        const SampleType* previousIData = this->previousBufferI.getReadPointer(channel);
+        const SampleType* previousQData = this->previousBufferQ.getReadPointer(channel);
+        
+        for (int i = 0; i < bufferSize; i++)
+        {
+            auto fade = juce::jlimit(SampleType(0), SampleType(1), static_cast<SampleType>(this->modeFadePosition + i + 1) * fadeStep);
+            
+            tmpIData[i] = previousIData[i] + fade * (tmpIData[i] - previousIData[i]);
+            tmpQData[i] = previousQData[i] + fade * (tmpQData[i] - previousQData[i]);
+        }
+    }
+    
+    this->modeFadePosition += bufferSize;
+    
+    if (this->modeFadePosition >= this->modeFadeLength)
+        this->isChangingMode = false;
+}
+
+template <typename SampleType>
+void FrequencyShifter<SampleType>::processBypassed(SampleType*const* bufferData, int bufferSize)
+{
+    // With the oscillators holding still the shifted output is a fixed mix of the in-phase and
+    // quadrature signals: sin * I + (1 - 2 * sideBandMix) * cos * Q, with sin and cos at the phase
+    // they stopped at. Reading them doesn't move them at 0 Hz.
+    auto inPhaseGain = this->oscI.processSample(0);
+    auto quadratureGain = (1 - 2 * static_cast<SampleType>(this->sideBandMix)) * this->oscQ.processSample(0);
+    
+    if (quadratureGain == 0 && this->quadratureMode == QuadratureMode::linearPhase)
+    {
+        // The quadrature signal isn't heard, so the FIR only needs its history kept current
+        this->hilbert.pushHistory(bufferData[0], bufferData[1], bufferSize);
+        
+        for (int channel = 0; channel < 2; ++channel)
+        {
+            this->inPhaseDelay.process(channel, bufferData[channel], bufferData[channel], bufferSize);
+            juce::FloatVectorOperations::multiply(bufferData[channel], inPhaseGain, bufferSize);
+        }
+        
+        return;
+    }
+    
+    // The allpass and partitioned engines run either way, they are cheap or have FFT state to keep
+    processQuadrature(this->quadratureMode, this->inPhaseDelay, bufferData, this->tmpBufferI, this->tmpBufferQ, bufferSize);
+    
+    for (int channel = 0; channel < 2; ++channel)
+    {
+        juce::FloatVectorOperations::copyWithMultiply(bufferData[channel], this->tmpBufferI.getReadPointer(channel), inPhaseGain, bufferSize);
+        juce::FloatVectorOperations::addWithMultiply(bufferData[channel], this->tmpBufferQ.getReadPointer(channel), quadratureGain, bufferSize);
+    }
+}
+
+template <typename SampleType>
+void FrequencyShifter<SampleType>::processOscillator(juce::AudioBuffer<SampleType>* bufPtr,juce::dsp::Oscillator<SampleType>* oscPtr, int numSamples)
+{
+    bufPtr->clear(0, numSamples);
+    auto block = juce::dsp::AudioBlock<SampleType>(*bufPtr).getSubBlock(0, static_cast<size_t>(numSamples));
+    juce::dsp::ProcessContextReplacing<SampleType> context(block);
+    oscPtr->process(context);
+}
+
+template struct FrequencyShifter<float>;
+template struct FrequencyShifter<double>;
+
+//==============================================================================
+bool StrangeEchoesAudioProcessor::hasEditor() const
+{
+    return true; // (change this to false if you choose to not supply an editor)
+}
+
+juce::AudioProcessorEditor* StrangeEchoesAudioProcessor::createEditor()
+{
+    return new StrangeEchoesAudioProcessorEditor (*this);
+}
+
+//==============================================================================
+void StrangeEchoesAudioProcessor::getStateInformation (juce::MemoryBlock& destData)
+{
+    // You should use this method to store your parameters in the memory block.
+    // You could do that either as raw data, or use the XML or ValueTree classes
+    // as intermediaries to make it easy to save and load complex data.
+    
+    std::unique_ptr <juce::XmlElement> xml (apvts.state.createXml());
+    copyXmlToBinary(*xml, destData);
+    
+    //juce::ignoreUnused (destData);
+}
+
+void StrangeEchoesAudioProcessor::setStateInformation (const void* data, int sizeInBytes)
+{
+    // You should use this method to restore your parameters from this memory block,
+    // whose contents will have been created by the getStateInformation() call.
+    
+    std::unique_ptr<juce::XmlElement> storedParams (getXmlFromBinary(data, sizeInBytes));
+    
+    if (storedParams != nullptr)
+    {
+        if (storedParams -> hasTagName(apvts.state.getType()))
+        {
+            auto state = juce::ValueTree::fromXml(*storedParams);
+            
+            // Sessions saved before the note lists grew: the stored choice indices still mean the
+            // same notes, only the IDs changed
+            for (auto [legacyID, currentID] : { std::pair<const char*, const char*>("Tempo-Relative Delay Time", "Tempo-Relative Delay Time v2"),
+                                                std::pair<const char*, const char*>("Note Type", "Note Type v2") })
+            {
+                auto legacy = state.getChildWithProperty("id", legacyID);
+                
+                if (legacy.isValid() && ! state.getChildWithProperty("id", currentID).isValid())
+                    legacy.setProperty("id", currentID, nullptr);
+            }
+            
+            apvts.state = state;
+        }
+    }
+    
+    //juce::ignoreUnused (data, sizeInBytes);
+}
+
+ParameterHandles::ParameterHandles(juce::AudioProcessorValueTreeState& apvts)
+    : delayTime         (apvts.getRawParameterValue("Delay Time")),
+      syncOption        (apvts.getRawParameterValue("Sync Options")),
+      noteOption        (apvts.getRawParameterValue("Tempo-Relative Delay Time v2")),
+      noteType          (apvts.getRawParameterValue("Note Type v2")),
+      feedback          (apvts.getRawParameterValue("Feedback")),
+      drywet            (apvts.getRawParameterValue("Dry/Wet Mix")),
+      lfoRate           (apvts.getRawParameterValue("LFO Rate")),
+      lfoAmount         (apvts.getRawParameterValue("LFO Amount")),
+      freqShift         (apvts.getRawParameterValue("Frequency Shift")),
+      sideBandMix       (apvts.getRawParameterValue("Sideband Mix")),
+      shifterMode       (apvts.getRawParameterValue("Shifter Mode")),
+      delayInterpolation(apvts.getRawParameterValue("Delay Interpolation")),
+      pitchShift        (apvts.getRawParameterValue("Pitch Shift")),
+      pitchShiftAmount  (apvts.getRawParameterValue("Pitch Shift Amount")),
+      pitchShiftMode    (apvts.getRawParameterValue("Pitch Shift Mode")),
+      pitchShiftQuality (apvts.getRawParameterValue("Pitch Shift Quality")),
+      lowPassFreq       (apvts.getRawParameterValue("LowPass Freq")),
+      highPassFreq      (apvts.getRawParameterValue("HighPass Freq")),
+      numTaps           (apvts.getRawParameterValue("Taps")),
+      feedbackRouting   (apvts.getRawParameterValue("Feedback Routing")),
+      crossFeedback     (apvts.getRawParameterValue("Cross Feedback")),
+      saturation        (apvts.getRawParameterValue("Saturation")),
+      saturationDrive   (apvts.getRawParameterValue("Saturation Drive")),
+      saturationOversampling (apvts.getRawParameterValue("Saturation Oversampling")),
+      lfoShape          (apvts.getRawParameterValue("LFO Shape")),
+      lfoSync           (apvts.getRawParameterValue("LFO Sync")),
+      lfoNote           (apvts.getRawParameterValue("LFO Note")),
+      lfoStereoOffset   (apvts.getRawParameterValue("LFO Stereo Offset"))
+{
+    for (auto* handle : { delayTime, syncOption, noteOption, noteType, feedback, drywet, lfoRate, lfoAmount,
+                          freqShift, sideBandMix, shifterMode, delayInterpolation, pitchShift, pitchShiftAmount,
+                          pitchShiftMode, pitchShiftQuality, lowPassFreq, highPassFreq, numTaps,
+                          feedbackRouting, crossFeedback, saturation, saturationDrive, saturationOversampling,
+                          lfoShape, lfoSync, lfoNote, lfoStereoOffset })
+        jassert(handle != nullptr);
+    
+    for (size_t k = 0; k < taps.size(); ++k)
+    {
+        auto tapName = "Tap " + juce::String(static_cast<int>(k) + 1);
+        
+        taps[k] = { apvts.getRawParameterValue(tapName + " Time"),
+                    apvts.getRawParameterValue(tapName + " Gain"),
+                    apvts.getRawParameterValue(tapName + " Pan"),
+                    apvts.getRawParameterValue(tapName + " Feedback") };
+        
+        for (auto* handle : { taps[k].time, taps[k].gain, taps[k].pan, taps[k].feedback })
+            jassert(handle != nullptr);
+    }
+}
+
+EffectSettings getEffectSettings(const ParameterHandles& parameters, float bpm)
+{
+    EffectSettings settings;
+    
+    settings.syncOption = static_cast<int>(parameters.syncOption->load());
+    
+    if (settings.syncOption == 0)
+        settings.delayTimeMs =  parameters.delayTime->load();
+    else
+    {
+        int noteOption = static_cast<int>(parameters.noteOption->load());
+        int noteType = static_cast<int>(parameters.noteType->load());
+        
+        settings.delayTimeMs = static_cast<float>(TransportTracker::getNoteLengthInQuarters(noteOption, noteType) * 60000.0 / bpm);
+    }
+    
+    settings.feedback =     parameters.feedback->load();
+    settings.feedbackRouting = static_cast<int>(parameters.feedbackRouting->load());
+    settings.crossFeedback = parameters.crossFeedback->load();
+    settings.drywet =       parameters.drywet->load();
+    settings.lfoSync =      static_cast<int>(parameters.lfoSync->load());
+    
+    if (settings.lfoSync == 0)
+        settings.lfoRate =  parameters.lfoRate->load();
+    else
+    {
+        // One cycle per "LFO Note": 4/1, 2/1, 1/1 ... 1/32
+        settings.lfoCycleQuarters = 16.0 / static_cast<double>(1 << juce::jlimit(0, 7, static_cast<int>(parameters.lfoNote->load())));
+        settings.lfoRate = static_cast<float>(bpm / (60.0 * settings.lfoCycleQuarters));
+    }
+    
+    settings.lfoAmount =    parameters.lfoAmount->load();
+    settings.lfoShape =     static_cast<int>(parameters.lfoShape->load());
+    settings.lfoStereoOffset = parameters.lfoStereoOffset->load();
+    settings.freqShift =    parameters.freqShift->load();
+    settings.sideBandMix =  parameters.sideBandMix->load();
+    settings.shifterMode =  static_cast<int>(parameters.shifterMode->load());
+    settings.delayInterpolation = static_cast<int>(parameters.delayInterpolation->load());
+    settings.pitchShift =   parameters.pitchShift->load();
+    settings.pitchShiftAmount =   parameters.pitchShiftAmount->load();
+    settings.pitchShiftMode =   static_cast<int>(parameters.pitchShiftMode->load());
+    settings.pitchShiftQuality =   static_cast<int>(parameters.pitchShiftQuality->load());
+    settings.lowPassFreq =  parameters.lowPassFreq->load();
+    settings.highPassFreq = parameters.highPassFreq->load();
+    settings.saturation =   static_cast<int>(parameters.saturation->load());
+    settings.saturationDrive = parameters.saturationDrive->load();
+    settings.saturationOversampling = static_cast<int>(parameters.saturationOversampling->load());
+    
+    settings.numTaps =      static_cast<int>(parameters.numTaps->load());
+    
+    for (size_t k = 0; k < settings.taps.size(); ++k)
+    {
+        auto& tap = settings.taps[k];
+        tap.timeMs =    parameters.taps[k].time->load();
+        tap.gain =      parameters.taps[k].gain->load();
+        tap.pan =       parameters.taps[k].pan->load();
+        tap.feedback =  parameters.taps[k].feedback->load();
+    }
+    
+    return settings;
+}
+
+EffectSettingsSnapshot::EffectSettingsSnapshot(juce::AudioProcessorValueTreeState& apvts)
+    : state(apvts), parameters(apvts)
+{
+    for (auto* parameter : state.processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            state.addParameterListener(ranged->getParameterID(), this);
+}
+
+EffectSettingsSnapshot::~EffectSettingsSnapshot()
+{
+    for (auto* parameter : state.processor.getParameters())
+        if (auto* ranged = dynamic_cast<juce::RangedAudioParameter*>(parameter))
+            state.removeParameterListener(ranged->getParameterID(), this);
+}
+
+void EffectSettingsSnapshot::reset()
+{
+    this->forceAll = true;
+    this->dirty.store(true);
+}
+
+uint32_t EffectSettingsSnapshot::update(float bpm)
+{
+    // Tempo only matters to synced delay times and LFO rates
+    bool tempoMoved = (this->settings.syncOption != 0 || this->settings.lfoSync != 0) && bpm != this->settingsBpm;
+    
+    if (! this->dirty.exchange(false, std::memory_order_acquire) && ! tempoMoved && ! this->forceAll)
+        return none;
+    
+    auto previous = this->settings;
+    this->settings = getEffectSettings(this->parameters, bpm);
+    this->settingsBpm = bpm;
+    
+    if (this->forceAll)
+    {
+        this->forceAll = false;
+        return allChanged;
+    }
+    
+    uint32_t changes = none;
+    
+    if (settings.delayTimeMs != previous.delayTimeMs || settings.syncOption != previous.syncOption
+        || settings.delayInterpolation != previous.delayInterpolation
+        || settings.lfoRate != previous.lfoRate || settings.lfoAmount != previous.lfoAmount
+        || settings.lfoShape != previous.lfoShape || settings.lfoStereoOffset != previous.lfoStereoOffset)
+        changes |= delayChanged;
+    
+    if (settings.lowPassFreq != previous.lowPassFreq || settings.highPassFreq != previous.highPassFreq)
+        changes |= filtersChanged;
+    
+    if (settings.pitchShift != previous.pitchShift || settings.pitchShiftAmount != previous.pitchShiftAmount
+        || settings.pitchShiftMode != previous.pitchShiftMode)
+        changes |= pitchChanged;
+    
+    if (settings.freqShift != previous.freqShift || settings.sideBandMix != previous.sideBandMix
+        || settings.shifterMode != previous.shifterMode)
+        changes |= shifterChanged;
+    
+    if (settings.feedback != previous.feedback || settings.drywet != previous.drywet
+        || settings.feedbackRouting != previous.feedbackRouting || settings.crossFeedback != previous.crossFeedback)
+        changes |= mixChanged;
+    
+    if (settings.saturation != previous.saturation || settings.saturationDrive != previous.saturationDrive
+        || settings.saturationOversampling != previous.saturationOversampling)
+        changes |= saturationChanged;
+    
+    if (settings.numTaps != previous.numTaps)
+        changes |= tapsChanged;
+    
+    for (size_t k = 0; k < settings.taps.size(); ++k)
+    {
+        const auto& tap = settings.taps[k];
+        const auto& previousTap = previous.taps[k];
+        
+        if (tap.timeMs != previousTap.timeMs || tap.gain != previousTap.gain
+            || tap.pan != previousTap.pan || tap.feedback != previousTap.feedback)
+            changes |= tapsChanged;
+    }
+    
+    return changes;
+}
+
+void EffectSettingsSnapshot::parameterChanged(const juce::String& parameterID, float newValue)
+{
+    juce::ignoreUnused(parameterID, newValue);
+    this->dirty.store(true, std::memory_order_release);
+}
+
+juce::AudioProcessorValueTreeState::ParameterLayout StrangeEchoesAudioProcessor::createParameterLayout()
+{
+    juce::AudioProcessorValueTreeState::ParameterLayout layout;
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Delay Time",
+                                                           "Delay Time",
+                                                           juce::NormalisableRange<float>(1.0f, 2500.0f, 1.f, 1.f),
+                                                           300.0f));
+    
+    juce::StringArray strSyncOptions;
+    strSyncOptions.add("Time");
+    strSyncOptions.add("Sync");
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Sync Options", "Sync Options", strSyncOptions, 0));
+    
+    juce::StringArray strNoteOptions;
+    strNoteOptions.add("1/1");
+    strNoteOptions.add("1/2");
+    strNoteOptions.add("1/4");
+    strNoteOptions.add("1/8");
+    strNoteOptions.add("1/16");
+    strNoteOptions.add("1/32");
+    strNoteOptions.add("1/64");
+    
+    // The note lists gained 1/32, 1/64 and quintuplets after release, which moved the normalised value
+    // of every existing choice, so they took new IDs; setStateInformation moves old sessions over
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Tempo-Relative Delay Time v2", "Tempo-Relative Delay Time", strNoteOptions, 2));
+    
+    juce::StringArray strNoteType;
+    strNoteType.add("Notes");
+    strNoteType.add("Triplets");
+    strNoteType.add("Dotted");
+    strNoteType.add("Quintuplets");
+
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Note Type v2", "Note Type", strNoteType, 0));
+
+        
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Dry/Wet Mix",
+                                                           "Dry/Wet",
+                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f, 1.f),
+                                                           0.5f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Feedback",
+                                                           "Feedback",
+                                                           juce::NormalisableRange<float>(0.0f, 0.99f, 0.01f, 1.f),
+                                                           0.1f));
+    
+    juce::StringArray strFeedbackRoutings;
+    strFeedbackRoutings.add("Stereo");
+    strFeedbackRoutings.add("Cross");
+    strFeedbackRoutings.add("Ping-Pong");
+    strFeedbackRoutings.add("Mid/Side");
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Feedback Routing", "Feedback Routing", strFeedbackRoutings, 0));
+    
+    // How much of each channel's feedback crosses over in the "Cross" routing
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Cross Feedback",
+                                                           "Cross Feedback",
+                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f, 1.f),
+                                                           0.5f));
+    
+    // Soft clipping of every repeat, tanh(drive * x) / drive. Oversampling keeps the harmonics it adds
+    // from aliasing, at 2x or 4x the cost; changing the factor restarts the oversampling filters. The
+    // oversampler runs, and its latency comes off the delay time, even while the saturation is off, so
+    // it defaults to 1x and the default preset pays for neither.
+    juce::StringArray strSaturationOptions;
+    strSaturationOptions.add("Off");
+    strSaturationOptions.add("On");
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Saturation", "Saturation", strSaturationOptions, 0));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Saturation Drive",
+                                                           "Saturation Drive",
+                                                           juce::NormalisableRange<float>(0.0f, 24.0f, 0.1f, 1.f),
+                                                           6.0f));
+    
+    juce::StringArray strOversamplingFactors;
+    strOversamplingFactors.add("1x");
+    strOversamplingFactors.add("2x");
+    strOversamplingFactors.add("4x");
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Saturation Oversampling", "Saturation Oversampling", strOversamplingFactors, 0,
+                                                            juce::AudioParameterChoiceAttributes().withAutomatable(false)));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Frequency Shift",
+                                                           "Frequency Shift",
+                                                           juce::NormalisableRange<float>(0.0f, 1000.f, 0.1f, 1.f),
+                                                           0.0f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Sideband Mix",
+                                                           "Sideband Mix",
+                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f, 1.f),
+                                                           0.f));
+    
+    juce::StringArray strShifterModes;
+    strShifterModes.add("Linear Phase");
+    strShifterModes.add("Low Latency");
+    strShifterModes.add("Linear Phase (Long)");
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Shifter Mode", "Shifter Mode", strShifterModes, 0));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Pitch Shift",
+                                                           "Pitch Shift",
+                                                           juce::NormalisableRange<float>(-12.f, 12.f, 1.f, 1.f),
+                                                           0.0f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("Pitch Shift Amount",
+                                                           "Pitch Shift Amount",
+                                                           juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f, 1.f),
+                                                           0.f));
+    
+    // Background moves the pitch shifter off the audio thread for two blocks of reported latency.
+    // Not automatable, since hosts may restart processing when the latency changes.
+    juce::StringArray strPitchShiftModes;
+    strPitchShiftModes.add("Realtime");
+    strPitchShiftModes.add("Background");
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Pitch Shift Mode", "Pitch Shift Mode", strPitchShiftModes, 0,
+                                                            juce::AudioParameterChoiceAttributes().withAutomatable(false)));
+    
+    // SignalsmithStretch block/interval sizes, trading CPU for quality. Changes crossfade to a
+    // stretcher configured off the audio thread, so there's no point automating it.
+    juce::StringArray strPitchShiftQualities;
+    strPitchShiftQualities.add("Auto");
+    strPitchShiftQualities.add("Eco");
+    strPitchShiftQualities.add("Normal");
+    strPitchShiftQualities.add("High");
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Pitch Shift Quality", "Pitch Shift Quality", strPitchShiftQualities, 0,
+                                                            juce::AudioParameterChoiceAttributes().withAutomatable(false)));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("LowPass Freq",
+                                                           "Low Pass Filter",
+                                                           juce::NormalisableRange<float>(20.0f, 22000.f, 0.1f, 1.f / std::log2(1.f + std::sqrt(22000.f / 20.0f))),
+                                                           22000.0f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("HighPass Freq",
+                                                           "High Pass Filter",
+                                                           juce::NormalisableRange<float>(20.0f, 22000.f, 0.1f, 1.f / std::log2(1.f + std::sqrt(22000.f / 20.0f))),
+                                                           20.0f));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("LFO Amount",
+                                                           "LFO Amount",
+                                                           juce::NormalisableRange<float>(-100.0f, 100.0f, 1.f, 1.f),
+                                                           0.0f));
+    
+    juce::StringArray strInterpolationModes;
+    strInterpolationModes.add("Linear");
+    strInterpolationModes.add("Hermite");
+    strInterpolationModes.add("Lagrange");
+    strInterpolationModes.add("Allpass");
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Delay Interpolation", "Delay Interpolation", strInterpolationModes, 1));
+    
+    layout.add(std::make_unique<juce::AudioParameterFloat>("LFO Rate",
+                                                           "LFO Rate",
+                                                           juce::NormalisableRange<float>(0.0f, 10.0f, 0.1f, 1.f),
+                                                           0.0f));
+    
+    juce::StringArray strLfoShapes;
+    strLfoShapes.add("Sine");
+    strLfoShapes.add("Triangle");
+    strLfoShapes.add("Saw");
+    strLfoShapes.add("Square");
+    strLfoShapes.add("Sample & Hold");
+    strLfoShapes.add("Smooth Random");
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("LFO Shape", "LFO Shape", strLfoShapes, 0));
+    
+    // With sync on, one LFO cycle lasts an "LFO Note" at the host tempo and "LFO Rate" is ignored
+    juce::StringArray strLfoSyncOptions;
+    strLfoSyncOptions.add("Free");
+    strLfoSyncOptions.add("Sync");
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("LFO Sync", "LFO Sync", strLfoSyncOptions, 0));
+    
+    juce::StringArray strLfoNotes;
+    strLfoNotes.add("4/1");
+    strLfoNotes.add("2/1");
+    strLfoNotes.add("1/1");
+    strLfoNotes.add("1/2");
+    strLfoNotes.add("1/4");
+    strLfoNotes.add("1/8");
+    strLfoNotes.add("1/16");
+    strLfoNotes.add("1/32");
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("LFO Note", "LFO Note", strLfoNotes, 2));
+    
+    // 180 degrees sweeps the two channels' echoes in opposite directions
+    layout.add(std::make_unique<juce::AudioParameterFloat>("LFO Stereo Offset",
+                                                           "LFO Stereo Offset",
+                                                           juce::NormalisableRange<float>(0.0f, 180.0f, 1.f, 1.f),
+                                                           0.0f));
+    
+    // Extra echoes read from the same delay line, each with its own time, level, pan and a send of
+    // its echo back into the delay line
+    juce::StringArray strTapCounts;
+    strTapCounts.add("Off");
+    for (int k = 1; k <= maxDelayTaps; ++k)
+        strTapCounts.add(juce::String(k));
+    
+    layout.add(std::make_unique<juce::AudioParameterChoice>("Taps", "Taps", strTapCounts, 0));
+    
+    for (int k = 0; k < maxDelayTaps; ++k)
+    {
+        auto tapName = "Tap " + juce::String(k + 1);
+        
+        layout.add(std::make_unique<juce::AudioParameterFloat>(tapName + " Time",
+                                                               tapName + " Time",
+                                                               juce::NormalisableRange<float>(1.0f, 2500.0f, 1.f, 1.f),
+                                                               150.0f * static_cast<float>(k + 1)));
+        
+        layout.add(std::make_unique<juce::AudioParameterFloat>(tapName + " Gain",
+                                                               tapName + " Gain",
+                                                               juce::NormalisableRange<float>(0.0f, 1.0f, 0.01f, 1.f),
+                                                               0.5f));
+        
+        layout.add(std::make_unique<juce::AudioParameterFloat>(tapName + " Pan",
+                                                               tapName + " Pan",
+                                                               juce::NormalisableRange<float>(-1.0f, 1.0f, 0.01f, 1.f),
+                                                               0.0f));
+        
+        layout.add(std::make_unique<juce::AudioParameterFloat>(tapName + " Feedback",
+                                                               tapName + " Feedback",
+                                                               juce::NormalisableRange<float>(0.0f, 0.99f, 0.01f, 1.f),
+                                                               0.0f));
+    }
+    
+    return layout;
+}
+
+//==============================================================================
+// This creates new instances of the plugin..
+juce::AudioProcessor* JUCE_CALLTYPE createPluginFilter()
+{
+    return new StrangeEchoesAudioProcessor();
+}
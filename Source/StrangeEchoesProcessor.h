@@ -1,160 +1,527 @@
-#pragma once
-
-#include <juce_audio_processors/juce_audio_processors.h>
-#include <juce_dsp/juce_dsp.h>
-#include <juce_core/juce_core.h>
-#include "signalsmith-stretch/signalsmith-stretch.h"
-
-struct EffectSettings
-{
-    float   delayTimeMs{0.0},
-            feedback{0.0},
-            drywet{0.0},
-            lfoRate{0.0},
-            lfoAmount{0.0},
-            freqShift{0.0},
-            sideBandMix{0.0},
-            pitchShift{0.0},
-            pitchShiftAmount{0.0},
-            lowPassFreq{0.0},
-            highPassFreq{0.0};
-    
-    int    syncOption{0};
-};
-
-EffectSettings getEffectSettings(juce::AudioProcessorValueTreeState& apvts, float bpm);
-
-struct FrequencyShifter
-{
-    float oscFreqHz{0.f};
-    float sideBandMix{0.f};
-    size_t filterSize = 301;
-    int firDelayInSamples = 151;
-    int firDelayWritePosition;
-    
-    juce::dsp::Oscillator<float> oscI;
-    juce::dsp::Oscillator<float> oscQ;
-    
-    juce::AudioBuffer<float> firDelay;
-    
-    juce::dsp::FIR::Filter<float> firFilterL;
-    juce::dsp::FIR::Filter<float> firFilterR;
-    
-    juce::AudioBuffer<float> tmpBufferI;
-    juce::AudioBuffer<float> tmpBufferQ;
-    juce::AudioBuffer<float> tmpBufferOscI;
-    juce::AudioBuffer<float> tmpBufferOscQ;
-    
-    juce::Array<float> firCoeffArray = {0.000000, -0.000000, 0.000000, -0.000004, 0.000000, -0.000012, 0.000000, -0.000024, 0.000000, -0.000040, 0.000000, -0.000060, 0.000000, -0.000085, 0.000000, -0.000115, 0.000000, -0.000149, 0.000000, -0.000189, 0.000000, -0.000233, 0.000000, -0.000283, 0.000000, -0.000339, 0.000000, -0.000400, 0.000000, -0.000467, 0.000000, -0.000541, 0.000000, -0.000620, 0.000000, -0.000706, 0.000000, -0.000799, 0.000000, -0.000899, 0.000000, -0.001006, 0.000000, -0.001120, 0.000000, -0.001242, 0.000000, -0.001372, 0.000000, -0.001510, 0.000000, -0.001656, 0.000000, -0.001812, 0.000000, -0.001976, 0.000000, -0.002150, 0.000000, -0.002334, 0.000000, -0.002528, 0.000000, -0.002733, 0.000000, -0.002950, 0.000000, -0.003178, 0.000000, -0.003419, 0.000000, -0.003672, 0.000000, -0.003940, 0.000000, -0.004222, 0.000000, -0.004520, 0.000000, -0.004834, 0.000000, -0.005166, 0.000000, -0.005516, 0.000000, -0.005887, 0.000000, -0.006279, 0.000000, -0.006695, 0.000000, -0.007137, 0.000000, -0.007606, 0.000000, -0.008106, 0.000000, -0.008640, 0.000000, -0.009210, 0.000000, -0.009822, 0.000000, -0.010480, 0.000000, -0.011189, 0.000000, -0.011957, 0.000000, -0.012792, 0.000000, -0.013703, 0.000000, -0.014702, 0.000000, -0.015804, 0.000000, -0.017028, 0.000000, -0.018395, 0.000000, -0.019936, 0.000000, -0.021689, 0.000000, -0.023703, 0.000000, -0.026047, 0.000000, -0.028814, 0.000000, -0.032137, 0.000000, -0.036213, 0.000000, -0.041340, 0.000000, -0.048005, 0.000000, -0.057045, 0.000000, -0.070042, 0.000000, -0.090390, 0.000000, -0.126905, 0.000000, -0.211924, 0.000000, -0.636464, 0.000000, 0.636602, 0.000000, 0.212062, 0.000000, 0.127043, 0.000000, 0.090528, 0.000000, 0.070180, 0.000000, 0.057182, 0.000000, 0.048142, 0.000000, 0.041477, 0.000000, 0.036349, 0.000000, 0.032273, 0.000000, 0.028948, 0.000000, 0.026181, 0.000000, 0.023836, 0.000000, 0.021820, 0.000000, 0.020067, 0.000000, 0.018524, 0.000000, 0.017156, 0.000000, 0.015931, 0.000000, 0.014827, 0.000000, 0.013827, 0.000000, 0.012914, 0.000000, 0.012078, 0.000000, 0.011309, 0.000000, 0.010597, 0.000000, 0.009938, 0.000000, 0.009324, 0.000000, 0.008752, 0.000000, 0.008217, 0.000000, 0.007715, 0.000000, 0.007243, 0.000000, 0.006800, 0.000000, 0.006381, 0.000000, 0.005987, 0.000000, 0.005614, 0.000000, 0.005261, 0.000000, 0.004927, 0.000000, 0.004611, 0.000000, 0.004311, 0.000000, 0.004026, 0.000000, 0.003756, 0.000000, 0.003500, 0.000000, 0.003257, 0.000000, 0.003026, 0.000000, 0.002807, 0.000000, 0.002600, 0.000000, 0.002403, 0.000000, 0.002217, 0.000000, 0.002040, 0.000000, 0.001873, 0.000000, 0.001715, 0.000000, 0.001566, 0.000000, 0.001426, 0.000000, 0.001293, 0.000000, 0.001169, 0.000000, 0.001052, 0.000000, 0.000943, 0.000000, 0.000841, 0.000000, 0.000745, 0.000000, 0.000657, 0.000000, 0.000575, 0.000000, 0.000499, 0.000000, 0.000430, 0.000000, 0.000366, 0.000000, 0.000308, 0.000000, 0.000256, 0.000000, 0.000209, 0.000000, 0.000167, 0.000000, 0.000130, 0.000000, 0.000099, 0.000000, 0.000071, 0.000000, 0.000049, 0.000000, 0.000031, 0.000000, 0.000017, 0.000000, 0.000008, 0.000000, 0.000002, 0.000000};
-
-
-    juce::dsp::FIR::Coefficients<float>::Ptr coeffs = new juce::dsp::FIR::Coefficients<float> (firCoeffArray.getRawDataPointer(), filterSize);
-    
-    void prepare(int sampleRate, int blockSize);
-    
-    void configure(float freq, float sidbandMix);
-    
-    void processOscillator(juce::AudioBuffer<float>* bufPtr, juce::dsp::Oscillator<float>* oscPtr);
-    
-    void process(float*const* bufferData, int bufferSize);
-};
-
-//==============================================================================
-class StrangeEchoesAudioProcessor final : public juce::AudioProcessor
-{
-public:
-    //==============================================================================
-    StrangeEchoesAudioProcessor();
-    ~StrangeEchoesAudioProcessor() override;
-
-    //==============================================================================
-    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
-    void releaseResources() override;
-
-    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
-
-    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
-    using AudioProcessor::processBlock;
-
-    //==============================================================================
-    juce::AudioProcessorEditor* createEditor() override;
-    bool hasEditor() const override;
-
-    //==============================================================================
-    const juce::String getName() const override;
-
-    bool acceptsMidi() const override;
-    bool producesMidi() const override;
-    bool isMidiEffect() const override;
-    double getTailLengthSeconds() const override;
-
-    //==============================================================================
-    int getNumPrograms() override;
-    int getCurrentProgram() override;
-    void setCurrentProgram (int index) override;
-    const juce::String getProgramName (int index) override;
-    void changeProgramName (int index, const juce::String& newName) override;
-
-    //==============================================================================
-    void getStateInformation (juce::MemoryBlock& destData) override;
-    void setStateInformation (const void* data, int sizeInBytes) override;
-    
-    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
-        
-    juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Parameters", createParameterLayout()};
-    
-private:
-    //==============================================================================
-    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StrangeEchoesAudioProcessor)
-    
-    // Stereo delay
-    juce::AudioBuffer<float> delayBuffer;
-    juce::AudioBuffer<float> wetSignal;
-    
-    int writePos{0};
-    int readPos{0};
-    const float minDelayTimeMs = 1.0;
-    const float maxDelayTimeMs = 2500.0;
-    float prevFeedback = 0.0;
-    
-    juce::SmoothedValue<float> delayTimeMsSmooth;
-    
-    // LP/HP filter chain
-    using Filter = juce::dsp::IIR::Filter<float>;
-    using CutFilter = juce::dsp::ProcessorChain<Filter,Filter>;
-    using MonoFilterChain = juce::dsp::ProcessorChain<CutFilter,CutFilter>;
-    
-    MonoFilterChain filterChainL, filterChainR;
-    
-    // LFO
-    float lfoPhase;
-    
-    // Pitch shifter
-    juce::AudioBuffer<float> tmpPitchShiftInput;
-    juce::AudioBuffer<float> tmpPitchShiftOutput;
-    signalsmith::stretch::SignalsmithStretch<float> pitchShifter;
-    float prevPitchShiftAmount{0.f};
-    
-    FrequencyShifter freqShifter;
-    
-    std::unique_ptr <juce::XmlElement> xml;
-    //std::unique_ptr <juce::XmlElement> storedParams;
-    
-    void writeToDelayBuffer(juce::AudioBuffer<float>& buffer,
-                            int channelIn, int channelOut,
-                            float startGain, float endGain,
-                            bool replacing);
-    
-    void readFromDelayBuffer(juce::AudioBuffer<float>& buffer,
-                             int channelIn, int channelOut,
-                             int readPos,
-                             float startGain, float endGain,
-                             bool replacing);
-    
-    void updateFilterChains(float lowPassFreq, float highPassFreq, double sampleRate);
-    
-    void processOscillator(juce::AudioBuffer<float>* bufPtr,
-                           juce::dsp::Oscillator<float>* oscPtr);
-    
-    void frequencyShifter(int channel, int bufferSize);
-};
+#pragma once
+
+#include <juce_audio_processors/juce_audio_processors.h>
+#include <juce_dsp/juce_dsp.h>
+#include <juce_core/juce_core.h>
+#include "signalsmith-stretch/signalsmith-stretch.h"
+#include "StageProfiler.h"
+#include "RealtimeAudit.h"
+#include "HilbertTransformer.h"
+#include "PartitionedConvolver.h"
+#include "BlockDelayLine.h"
+#include "ModulatedDelayLine.h"
+#include "MixKernels.h"
+#include "CrossfadingPitchShifter.h"
+#include "BackgroundPitchShifter.h"
+#include "Metering.h"
+#include "Saturator.h"
+#include "TransportTracker.h"
+#include "Lfo.h"
+
+// Extra echoes read from the same delay line as the main one, before the effect chain
+constexpr int maxDelayTaps = 8;
+
+// Most the main feedback and the taps' sends may add up to, the same as the Feedback parameter's maximum
+constexpr float maxLoopGain = 0.99f;
+
+struct DelayTapSettings
+{
+    float   timeMs{0.0},
+            gain{0.0},
+            pan{0.0},       // -1 (left) ... 1 (right)
+            feedback{0.0};  // send of the tap's own echo back into the delay line
+};
+
+struct EffectSettings
+{
+    float   delayTimeMs{0.0},
+            feedback{0.0},
+            drywet{0.0},
+            lfoRate{0.0},
+            lfoAmount{0.0},
+            freqShift{0.0},
+            sideBandMix{0.0},
+            pitchShift{0.0},
+            pitchShiftAmount{0.0},
+            lowPassFreq{0.0},
+            highPassFreq{0.0},
+            crossFeedback{0.0},
+            saturationDrive{0.0},   // dB
+            lfoStereoOffset{0.0};   // degrees the right channel's LFO runs ahead
+    
+    int    syncOption{0},
+           shifterMode{0},
+           delayInterpolation{1},
+           pitchShiftMode{0},
+           pitchShiftQuality{0},
+           numTaps{0},
+           feedbackRouting{0},
+           saturation{0},
+           saturationOversampling{0},
+           lfoShape{0},
+           lfoSync{0};
+    
+    double lfoCycleQuarters{0.0};   // length of an LFO cycle with "LFO Sync" on, in quarter notes
+    
+    std::array<DelayTapSettings, maxDelayTaps> taps;
+};
+
+// Raw parameter values, looked up by ID once instead of on every block
+struct ParameterHandles
+{
+    explicit ParameterHandles(juce::AudioProcessorValueTreeState& apvts);
+    
+    std::atomic<float>  *delayTime, *syncOption, *noteOption, *noteType,
+                        *feedback, *drywet, *lfoRate, *lfoAmount,
+                        *freqShift, *sideBandMix, *shifterMode, *delayInterpolation,
+                        *pitchShift, *pitchShiftAmount, *pitchShiftMode, *pitchShiftQuality,
+                        *lowPassFreq, *highPassFreq, *numTaps, *feedbackRouting, *crossFeedback,
+                        *saturation, *saturationDrive, *saturationOversampling,
+                        *lfoShape, *lfoSync, *lfoNote, *lfoStereoOffset;
+    
+    struct TapHandles
+    {
+        std::atomic<float> *time, *gain, *pan, *feedback;
+    };
+    
+    std::array<TapHandles, maxDelayTaps> taps;
+};
+
+EffectSettings getEffectSettings(const ParameterHandles& parameters, float bpm);
+
+// EffectSettings as seen by the audio thread. Parameter changes from any thread only raise an
+// atomic flag; the audio thread rebuilds its copy when the flag is set or the tempo moved, and
+// reports which groups of settings differ from the previous block.
+class EffectSettingsSnapshot : private juce::AudioProcessorValueTreeState::Listener
+{
+public:
+    enum Changes : uint32_t
+    {
+        none              = 0,
+        delayChanged      = 1 << 0,   // delay time, sync, interpolation, LFO rate, depth, shape and offset
+        filtersChanged    = 1 << 1,
+        pitchChanged      = 1 << 2,
+        shifterChanged    = 1 << 3,
+        mixChanged        = 1 << 4,   // feedback and its routing, dry/wet
+        tapsChanged       = 1 << 5,
+        saturationChanged = 1 << 6,
+        allChanged        = 0xffffffff
+    };
+    
+    explicit EffectSettingsSnapshot(juce::AudioProcessorValueTreeState& apvts);
+    ~EffectSettingsSnapshot() override;
+    
+    // Makes the next update() rebuild and report every group as changed
+    void reset();
+    
+    // Audio thread, once per block
+    uint32_t update(float bpm);
+    
+    const EffectSettings& get() const { return settings; }
+    
+private:
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    
+    juce::AudioProcessorValueTreeState& state;
+    ParameterHandles parameters;
+    EffectSettings settings;
+    float settingsBpm{0.f};
+    std::atomic<bool> dirty{true};
+    bool forceAll{true};
+};
+
+// Continuous EffectSettings fields ramped towards the latest snapshot, advanced one sub-block at a
+// time. Delay time and filter cutoffs have their own per-sample smoothing and pass straight through,
+// as do the discrete choices. Taps beyond numTaps ramp their gain and feedback down to zero.
+struct SmoothedEffectSettings
+{
+    void prepare(double sampleRate, const EffectSettings& initial);
+    void setTargets(const EffectSettings& target);
+    
+    // Settings at the end of the next numSamples samples
+    EffectSettings advance(int numSamples);
+    
+private:
+    EffectSettings targets;
+    juce::SmoothedValue<float> feedback, drywet, lfoRate, lfoAmount, freqShift, sideBandMix, pitchShiftAmount, saturationDrive;
+    std::array<juce::SmoothedValue<float>, maxDelayTaps> tapTimeMs, tapGain, tapPan, tapFeedback;
+};
+
+// Decides when the echoes have died away, so processBlock can skip the wet chain entirely. The input
+// and everything the echoes feed back into the delay line are tracked by their peak level per block;
+// once all of it has stayed below silenceThreshold for holdSamples (the longest way from the delay
+// line's input to the plugin's output) nothing audible is left in the buffer or the feedback loop.
+// Input above the threshold wakes it up in the same block.
+class IdleDetector
+{
+public:
+    static constexpr float silenceThreshold = 3.1623e-5f;   // -90 dBFS
+    
+    void setHoldSamples(int numSamples) { holdSamples = numSamples; }
+    void reset() { silentSamples = 0; }
+    
+    // Before a block: whether it can be skipped, given the peak level of its input
+    bool canSkip(float inputLevel) const { return inputLevel < silenceThreshold && silentSamples >= holdSamples; }
+    
+    // After a block, skipped or not, with the peak level of what the echoes produced in it
+    void update(float inputLevel, float echoLevel, int numSamples);
+    
+private:
+    int holdSamples{0};
+    int silentSamples{0};
+};
+
+// 4th order Butterworth low/high pass as two biquad sections. Coefficients are computed in
+// closed form into a fixed array (no allocation) and only when the smoothed cutoff has moved.
+// They are kept in double and rounded to the filters' sample type as they are copied out.
+struct ButterworthCutCoefficients
+{
+    enum class Type { lowPass, highPass };
+    
+    using Section = std::array<double, 5>; // b0, b1, b2, a1, a2 normalised by a0
+    
+    std::array<Section, 2> sections;
+    
+    void prepare(Type filterType, double sampleRate, float cutoffHz);
+    
+    // Moves the smoothed cutoff on by numSamples, returns true if the sections were recomputed
+    bool update(float targetCutoffHz, int numSamples);
+    bool isSmoothing() const { return cutoffSmooth.isSmoothing(); }
+    
+    template <typename SampleType>
+    void copySectionTo(int section, juce::dsp::IIR::Coefficients<SampleType>& coefficients) const;
+    
+private:
+    void computeSections(float cutoffHz);
+    
+    Type type{Type::lowPass};
+    double fs{44100.0};
+    float computedCutoffHz{0.f};
+    juce::SmoothedValue<float, juce::ValueSmoothingTypes::Multiplicative> cutoffSmooth;
+};
+
+// Shifts every frequency of a stereo signal by oscFreqHz, in float or double. Only the long convolver
+// runs in float, so a double shifter feeds it float copies and takes its quadrature output back; the
+// oscillators, in-phase delay, FIR Hilbert and allpass pair run in the shifter's own precision.
+template <typename SampleType>
+struct FrequencyShifter
+{
+    // How the quadrature (90 degree) pair is produced
+    enum class QuadratureMode
+    {
+        linearPhase,        // 301-tap FIR Hilbert, delays the wet signal by its 150 sample group delay
+        lowLatency,         // IIR allpass pair, no latency but non-linear phase
+        linearPhaseLong     // long FIR Hilbert by partitioned FFT convolution, sharper at low frequencies
+    };
+    
+    // Engine producing the output, and the one last asked for: process() switches over once any
+    // switch in progress has finished
+    QuadratureMode quadratureMode{QuadratureMode::linearPhase};
+    QuadratureMode requestedMode{QuadratureMode::linearPhase};
+    
+    // While switching, the outgoing engine keeps running from its own in-phase delay until the incoming
+    // one has filled its kernel (modeFadePosition < 0), then the two are crossfaded over modeFadeLength
+    QuadratureMode previousMode{QuadratureMode::linearPhase};
+    bool isChangingMode{false};
+    int modeFadePosition{0};
+    int modeFadeLength{0};
+    
+    float oscFreqHz{0.f};
+    float sideBandMix{0.f};
+    
+    // Moves to 1 over the oscillators' frequency ramp once the shift is 0 Hz, and the shifter is
+    // bypassed when it has settled there: from then on the oscillators hold still
+    juce::SmoothedValue<float> bypassTimer;
+    size_t filterSize = 301;
+    
+    // Long kernel spans at least 90 ms: 4095 taps at 44.1 kHz, 8191 from 48 kHz up
+    int longFilterSize = 4095;
+    static constexpr int longFilterPartitionSize = 256;
+    
+    juce::dsp::Oscillator<SampleType> oscI;
+    juce::dsp::Oscillator<SampleType> oscQ;
+    
+    // In-phase path, delayed to line up with the Hilbert filter's output
+    BlockDelayLine<SampleType> inPhaseDelay;
+    BlockDelayLine<SampleType> previousInPhaseDelay;
+    
+    // The SIMD float FIR, or its direct form double counterpart
+    std::conditional_t<std::is_same_v<SampleType, float>, HilbertTransformer, DoubleHilbertTransformer> hilbert;
+    AllpassHilbertTransformer<SampleType> allpassHilbert;
+    PartitionedConvolver longHilbert;
+    
+    juce::AudioBuffer<SampleType> tmpBufferI;
+    juce::AudioBuffer<SampleType> tmpBufferQ;
+    juce::AudioBuffer<SampleType> tmpBufferOscI;
+    juce::AudioBuffer<SampleType> tmpBufferOscQ;
+    juce::AudioBuffer<SampleType> previousBufferI;
+    juce::AudioBuffer<SampleType> previousBufferQ;
+    
+    // Input and quadrature output of the long convolver, empty for a float shifter
+    juce::AudioBuffer<float> floatInput;
+    juce::AudioBuffer<float> floatQuadrature;
+    
+    juce::Array<float> firCoeffArray = {0.000000, -0.000000, 0.000000, -0.000004, 0.000000, -0.000012, 0.000000, -0.000024, 0.000000, -0.000040, 0.000000, -0.000060, 0.000000, -0.000085, 0.000000, -0.000115, 0.000000, -0.000149, 0.000000, -0.000189, 0.000000, -0.000233, 0.000000, -0.000283, 0.000000, -0.000339, 0.000000, -0.000400, 0.000000, -0.000467, 0.000000, -0.000541, 0.000000, -0.000620, 0.000000, -0.000706, 0.000000, -0.000799, 0.000000, -0.000899, 0.000000, -0.001006, 0.000000, -0.001120, 0.000000, -0.001242, 0.000000, -0.001372, 0.000000, -0.001510, 0.000000, -0.001656, 0.000000, -0.001812, 0.000000, -0.001976, 0.000000, -0.002150, 0.000000, -0.002334, 0.000000, -0.002528, 0.000000, -0.002733, 0.000000, -0.002950, 0.000000, -0.003178, 0.000000, -0.003419, 0.000000, -0.003672, 0.000000, -0.003940, 0.000000, -0.004222, 0.000000, -0.004520, 0.000000, -0.004834, 0.000000, -0.005166, 0.000000, -0.005516, 0.000000, -0.005887, 0.000000, -0.006279, 0.000000, -0.006695, 0.000000, -0.007137, 0.000000, -0.007606, 0.000000, -0.008106, 0.000000, -0.008640, 0.000000, -0.009210, 0.000000, -0.009822, 0.000000, -0.010480, 0.000000, -0.011189, 0.000000, -0.011957, 0.000000, -0.012792, 0.000000, -0.013703, 0.000000, -0.014702, 0.000000, -0.015804, 0.000000, -0.017028, 0.000000, -0.018395, 0.000000, -0.019936, 0.000000, -0.021689, 0.000000, -0.023703, 0.000000, -0.026047, 0.000000, -0.028814, 0.000000, -0.032137, 0.000000, -0.036213, 0.000000, -0.041340, 0.000000, -0.048005, 0.000000, -0.057045, 0.000000, -0.070042, 0.000000, -0.090390, 0.000000, -0.126905, 0.000000, -0.211924, 0.000000, -0.636464, 0.000000, 0.636602, 0.000000, 0.212062, 0.000000, 0.127043, 0.000000, 0.090528, 0.000000, 0.070180, 0.000000, 0.057182, 0.000000, 0.048142, 0.000000, 0.041477, 0.000000, 0.036349, 0.000000, 0.032273, 0.000000, 0.028948, 0.000000, 0.026181, 0.000000, 0.023836, 0.000000, 0.021820, 0.000000, 0.020067, 0.000000, 0.018524, 0.000000, 0.017156, 0.000000, 0.015931, 0.000000, 0.014827, 0.000000, 0.013827, 0.000000, 0.012914, 0.000000, 0.012078, 0.000000, 0.011309, 0.000000, 0.010597, 0.000000, 0.009938, 0.000000, 0.009324, 0.000000, 0.008752, 0.000000, 0.008217, 0.000000, 0.007715, 0.000000, 0.007243, 0.000000, 0.006800, 0.000000, 0.006381, 0.000000, 0.005987, 0.000000, 0.005614, 0.000000, 0.005261, 0.000000, 0.004927, 0.000000, 0.004611, 0.000000, 0.004311, 0.000000, 0.004026, 0.000000, 0.003756, 0.000000, 0.003500, 0.000000, 0.003257, 0.000000, 0.003026, 0.000000, 0.002807, 0.000000, 0.002600, 0.000000, 0.002403, 0.000000, 0.002217, 0.000000, 0.002040, 0.000000, 0.001873, 0.000000, 0.001715, 0.000000, 0.001566, 0.000000, 0.001426, 0.000000, 0.001293, 0.000000, 0.001169, 0.000000, 0.001052, 0.000000, 0.000943, 0.000000, 0.000841, 0.000000, 0.000745, 0.000000, 0.000657, 0.000000, 0.000575, 0.000000, 0.000499, 0.000000, 0.000430, 0.000000, 0.000366, 0.000000, 0.000308, 0.000000, 0.000256, 0.000000, 0.000209, 0.000000, 0.000167, 0.000000, 0.000130, 0.000000, 0.000099, 0.000000, 0.000071, 0.000000, 0.000049, 0.000000, 0.000031, 0.000000, 0.000017, 0.000000, 0.000008, 0.000000, 0.000002, 0.000000};
+
+    
+    void prepare(int sampleRate, int blockSize);
+    
+    // Clears the audio held by the quadrature engines and in-phase delay, the oscillators keep running
+    void reset();
+    
+    void configure(float freq, float sidbandMix);
+    
+    // Takes effect from the next process(), crossfaded from the current engine
+    void setQuadratureMode(QuadratureMode newMode);
+    
+    int getInPhaseDelayInSamples(QuadratureMode mode) const;
+    
+    void processOscillator(juce::AudioBuffer<SampleType>* bufPtr, juce::dsp::Oscillator<SampleType>* oscPtr, int numSamples);
+    
+    void process(SampleType*const* bufferData, int bufferSize);
+    
+    // In-phase and quadrature outputs of the given engine, the in-phase one through inPhase
+    void processQuadrature(QuadratureMode mode, BlockDelayLine<SampleType>& inPhase, SampleType*const* bufferData,
+                           juce::AudioBuffer<SampleType>& outI, juce::AudioBuffer<SampleType>& outQ, int bufferSize);
+    
+    void beginModeChange();
+    
+    // Runs the outgoing engine and fades tmpBufferI/Q in from its output
+    void crossfadeFromPreviousMode(SampleType*const* bufferData, int bufferSize);
+    
+    // Same output as process() once the oscillators have settled at 0 Hz, without running them
+    void processBypassed(SampleType*const* bufferData, int bufferSize);
+};
+
+// Everything on the wet path that holds audio, in the processor's sample type. The processor keeps
+// one per precision and only prepares the one the host is using.
+template <typename SampleType>
+struct WetChain
+{
+    // Stereo delay, modulated per sample
+    ModulatedDelayLine<SampleType> delayLine;
+    juce::AudioBuffer<SampleType> wetSignal;
+    juce::AudioBuffer<SampleType> tapFeedback;
+    
+    // LP/HP filter chain
+    using Filter = juce::dsp::IIR::Filter<SampleType>;
+    using CutFilter = juce::dsp::ProcessorChain<Filter,Filter>;
+    using MonoFilterChain = juce::dsp::ProcessorChain<CutFilter,CutFilter>;
+    
+    MonoFilterChain filterChainL, filterChainR;
+    
+    juce::AudioBuffer<SampleType> pitchShiftOutput;
+    BlockDelayLine<SampleType> latencyDryDelay, latencyWetDelay;
+    
+    FrequencyShifter<SampleType> freqShifter;
+    
+    // The pitch shifters and the saturator only run in float: a double chain passes them copies of
+    // the wet signal and takes their output back. Empty for a float chain.
+    juce::AudioBuffer<float> floatWet, floatPitchShiftOutput;
+};
+
+//==============================================================================
+class StrangeEchoesAudioProcessor final : public juce::AudioProcessor,
+                                          private juce::AudioProcessorValueTreeState::Listener,
+                                          private juce::Timer
+{
+public:
+    //==============================================================================
+    StrangeEchoesAudioProcessor();
+    ~StrangeEchoesAudioProcessor() override;
+
+    //==============================================================================
+    void prepareToPlay (double sampleRate, int samplesPerBlock) override;
+    void releaseResources() override;
+
+    bool isBusesLayoutSupported (const BusesLayout& layouts) const override;
+
+    // Both run the same templated core. Double precision is for offline renders, where the delay line
+    // and filters accumulate less error over long feedback tails. It only covers the delay line, the
+    // taps, the filters and the frequency shifter's oscillators, FIR Hilbert and low latency (allpass)
+    // mode: the long FFT Hilbert mode, both pitch shifters and the saturator still run in float on copies.
+    void processBlock (juce::AudioBuffer<float>&, juce::MidiBuffer&) override;
+    void processBlock (juce::AudioBuffer<double>&, juce::MidiBuffer&) override;
+    bool supportsDoublePrecisionProcessing() const override;
+
+    //==============================================================================
+    juce::AudioProcessorEditor* createEditor() override;
+    bool hasEditor() const override;
+
+    //==============================================================================
+    const juce::String getName() const override;
+
+    bool acceptsMidi() const override;
+    bool producesMidi() const override;
+    bool isMidiEffect() const override;
+    double getTailLengthSeconds() const override;
+
+    //==============================================================================
+    int getNumPrograms() override;
+    int getCurrentProgram() override;
+    void setCurrentProgram (int index) override;
+    const juce::String getProgramName (int index) override;
+    void changeProgramName (int index, const juce::String& newName) override;
+
+    //==============================================================================
+    void getStateInformation (juce::MemoryBlock& destData) override;
+    void setStateInformation (const void* data, int sizeInBytes) override;
+    
+    static juce::AudioProcessorValueTreeState::ParameterLayout createParameterLayout();
+        
+    juce::AudioProcessorValueTreeState apvts {*this, nullptr, "Parameters", createParameterLayout()};
+    EffectSettingsSnapshot settingsSnapshot {apvts};
+    
+    // Settings are applied every numSamples within a block, 0 applies them once per block
+    void setSubBlockSize(int numSamples) { subBlockSize.store(juce::jmax(0, numSamples)); }
+    int getSubBlockSize() const { return subBlockSize.load(); }
+    
+    // Blocks in which the background pitch shifter's output arrived too late, any thread
+    juce::uint64 getBackgroundPitchShiftUnderruns() const { return backgroundPitchShifter.getNumUnderruns(); }
+    
+    // Input plus output latency of the pitch shifter at its current quality, any thread
+    int getPitchShiftLatencyInSamples() const { return pitchShifter.getLatencyInSamples(); }
+    
+    // Levels and echo envelopes for the editor, see Metering
+    Metering& getMetering() { return metering; }
+    
+    // Any thread: true while processBlock is skipping the wet chain because the echoes have died away
+    bool isIdle() const { return idle.load(std::memory_order_relaxed); }
+    
+   #if STRANGE_ECHOES_PROFILING
+    // Per-stage processBlock timings, safe to read from any thread
+    StageProfiler& getProfiler() { return profiler; }
+   #endif
+    
+private:
+    //==============================================================================
+    JUCE_DECLARE_NON_COPYABLE_WITH_LEAK_DETECTOR (StrangeEchoesAudioProcessor)
+    
+    // Wet path in float and in double, only the one matching isUsingDoublePrecision() is prepared
+    WetChain<float> floatChain;
+    WetChain<double> doubleChain;
+    
+    juce::AudioBuffer<float> delayTimes;  // delay in samples for every sample of the block, per channel
+    
+    const float minDelayTimeMs = 1.0;
+    const float maxDelayTimeMs = 2500.0;
+    float prevFeedback = 0.0;
+    float prevDryWetMix = 0.0;
+    
+    // Taps as read in the last sub-block, the next one ramps on from there. The feedback sends are
+    // the same on both channels.
+    std::array<std::array<DelayTap, maxDelayTaps>, 2> outputTaps;
+    std::array<DelayTap, maxDelayTaps> feedbackTaps;
+    
+    // Stereo feedback routing, smoothed so switching modes doesn't click, and the routing times
+    // the feedback amount as written at the end of the last sub-block
+    std::array<juce::SmoothedValue<float>, 4> feedbackMatrix;
+    std::array<float, 4> prevFeedbackGains{};
+    
+    SmoothedEffectSettings smoothedSettings;
+    std::atomic<int> subBlockSize{32};
+    
+    juce::SmoothedValue<float> delayTimeMsSmooth;
+    
+    // LP/HP filter coefficients, shared by both wet chains. Only updated from a cutoff change until
+    // both have finished smoothing.
+    ButterworthCutCoefficients lowPassCoefficients, highPassCoefficients;
+    bool filtersUpdating{false};
+    
+    // LFO, relocked to the host's bar position when playback starts or jumps
+    Lfo lfo;
+    TransportTracker transport;
+    
+    // Pitch shifter
+    CrossfadingPitchShifter pitchShifter;
+    float prevPitchShiftAmount{0.f};
+    bool pitchShifterRunning{false};  // false while bypassed at zero amount
+    
+    // "Background" pitch shift mode: the stretcher runs on a worker thread and the whole output is
+    // delayed by its fixed latency, which is taken off the echo delay so echoes stay on time
+    BackgroundPitchShifter backgroundPitchShifter;
+    bool pitchShiftInBackground{false};
+    int backgroundPitchShiftLatency{0};
+    std::atomic<float>* pitchShiftModeValue{apvts.getRawParameterValue("Pitch Shift Mode")};
+    
+    // Set by the audio thread as it switches mode, reported to the host by the timer
+    std::atomic<int> activeLatencySamples{0};
+    std::atomic<bool> pitchShiftQualityChanged{false};
+    
+    // Saturation of the wet signal before the feedback write, its latency is taken off the delay time
+    // whether it is on or off
+    Saturator saturator;
+    float prevSaturationDrive{1.f};  // as a gain
+    
+    Metering metering;
+    
+    // Tail reported to the host, and skipping the wet chain once that tail has passed in silence
+    std::atomic<double> tailLengthSeconds{0.0};
+    IdleDetector idleDetector;
+    std::atomic<bool> idle{false};
+    
+   #if STRANGE_ECHOES_PROFILING
+    StageProfiler profiler;
+   #endif
+    
+    std::unique_ptr <juce::XmlElement> xml;
+    //std::unique_ptr <juce::XmlElement> storedParams;
+    
+    // processBlock for either precision
+    template <typename SampleType>
+    void process(juce::AudioBuffer<SampleType>& buffer, WetChain<SampleType>& chain);
+    
+    // Non-realtime: sizes and clears the wet chain for the prepared block size
+    template <typename SampleType>
+    void prepareWetChain(WetChain<SampleType>& chain, const EffectSettings& effectSettings, double sampleRate, int samplesPerBlock);
+    
+    // Clears everything on the wet path that holds audio, so nothing older than the idle stretch can be
+    // read back after it (say after the delay time was lengthened)
+    template <typename SampleType>
+    void clearWetChain(WetChain<SampleType>& chain);
+    
+    // Fills delayTimes and returns how many of its channels hold delays: 1 when the LFO is off,
+    // so every channel reads the first one
+    int computeDelayTimes(const EffectSettings& effectSettings, int numSamples);
+    
+    // Ramps the taps on to the next sub-block's settings. Returns how many need reading (taps past
+    // that are silent), and whether any feedback send is open.
+    int updateDelayTaps(const EffectSettings& effectSettings, bool reset, bool& feedbackActive);
+    
+    // Switches to the background mode only once its worker is running
+    void setPitchShiftMode(int mode);
+    
+    // How much later than the delay line's read the wet signal reaches the feedback write and the output
+    int getWetLatencyInSamples() const;
+    
+    // Recomputes the tail and the idle detector's hold time, from the longest echo, the decay of the
+    // feedback loop and the latency of the wet chain
+    void updateTailLength(const EffectSettings& effectSettings);
+    
+    // { left to left, right to left, left to right, right to right } for a "Feedback Routing" choice
+    static std::array<float, 4> getFeedbackMatrix(int routing, float crossFeedback);
+    
+    // What the taps' feedback sends are scaled by so the whole loop gain stays within maxLoopGain.
+    // The main feedback takes priority.
+    static float getTapFeedbackScale(float feedback, float totalTapFeedback);
+    
+    // "Auto" picks Eco for blocks of 128 samples or less, Normal otherwise
+    static PitchShiftQuality getPitchShiftQuality(int choice, int blockSize);
+    
+    // Any thread: passes a new pitch shift quality on to both pitch shifters
+    void parameterChanged(const juce::String& parameterID, float newValue) override;
+    
+    // Message thread, every 20 ms from construction (paused within prepareToPlay): reports the latency
+    // processBlock has switched to, runs the background pitch shifter's worker only while it is needed,
+    // and configures the realtime pitch shifter's spare stretcher after a quality change
+    void timerCallback() override;
+    
+    // Returns false once neither cutoff is moving any more
+    template <typename SampleType>
+    bool updateFilterChains(WetChain<SampleType>& chain, float lowPassFreq, float highPassFreq, int numSamples);
+    
+    void processOscillator(juce::AudioBuffer<float>* bufPtr,
+                           juce::dsp::Oscillator<float>* oscPtr);
+    
+    void frequencyShifter(int channel, int bufferSize);
+};
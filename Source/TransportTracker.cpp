@@ -0,0 +1,66 @@
+#include "TransportTracker.h"
+#include <cmath>
+
+void TransportTracker::prepare(double newSampleRate)
+{
+    this->sampleRate = newSampleRate;
+    this->positionValid = false;
+    this->relocated = false;
+    this->ppqPosition = 0.0;
+    this->quartersSinceBarStart = 0.0;
+}
+
+void TransportTracker::update(juce::AudioPlayHead* playHead, int numSamples)
+{
+    juce::Optional<juce::AudioPlayHead::PositionInfo> position;
+
+    if (playHead != nullptr)
+        position = playHead->getPosition();
+
+    if (position.hasValue())
+    {
+        auto hostBpm = position->getBpm();
+
+        if (hostBpm.hasValue() && *hostBpm > 0.0)
+            this->bpm = *hostBpm;
+    }
+
+    auto ppq = position.hasValue() && position->getIsPlaying() ? position->getPpqPosition() : juce::Optional<double>();
+    auto wasValid = this->positionValid;
+    this->positionValid = ppq.hasValue();
+
+    if (! this->positionValid)
+    {
+        this->relocated = false;
+        this->ppqPosition = 0.0;
+        this->quartersSinceBarStart = 0.0;
+        return;
+    }
+
+    // Hosts that don't report the bar start get one from the time signature, 4/4 if that's missing too
+    auto signature = position->getTimeSignature().orFallback(juce::AudioPlayHead::TimeSignature{});
+    auto quartersPerBar = 4.0 * signature.numerator / juce::jmax(1, signature.denominator);
+    auto barStart = position->getPpqPositionOfLastBarStart().orFallback(std::floor(*ppq / quartersPerBar) * quartersPerBar);
+
+    // Tempo changes within a block leave a small error, a loop or a seek a large one
+    constexpr double toleranceInQuarters = 0.01;
+    this->relocated = ! wasValid || std::abs(*ppq - this->expectedPpq) > toleranceInQuarters;
+
+    this->ppqPosition = *ppq;
+    this->quartersSinceBarStart = juce::jmax(0.0, *ppq - barStart);
+    this->expectedPpq = *ppq + numSamples * this->bpm / (60.0 * this->sampleRate);
+}
+
+double TransportTracker::getNoteLengthInQuarters(int noteOption, int noteType)
+{
+    // 1/1, 1/2, 1/4, 1/8, 1/16, 1/32, 1/64
+    auto quarters = 4.0 / static_cast<double>(1 << juce::jlimit(0, 6, noteOption));
+
+    switch (noteType)
+    {
+        case 1:  return quarters * 2.0 / 3.0;  // triplets, 3 in the time of 2
+        case 2:  return quarters * 3.0 / 2.0;  // dotted
+        case 3:  return quarters * 4.0 / 5.0;  // quintuplets, 5 in the time of 4
+        default: return quarters;
+    }
+}
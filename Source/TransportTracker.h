@@ -0,0 +1,44 @@
+#pragma once
+
+#include <juce_audio_basics/juce_audio_basics.h>
+#include <juce_core/juce_core.h>
+
+// Host tempo and position, read once per block. A missing play head (the standalone app) or fields
+// the host leaves out fall back to the last known tempo, 120 bpm to begin with, and no position.
+class TransportTracker
+{
+public:
+    // Non-realtime
+    void prepare(double sampleRate);
+
+    // Audio thread, at the start of every block
+    void update(juce::AudioPlayHead* playHead, int numSamples);
+
+    double getBpm() const { return bpm; }
+
+    // Whether the host is playing and gave a position for this block
+    bool hasPosition() const { return positionValid; }
+
+    // Position of the block's first sample in quarter notes from the start of the song, 0 without one
+    double getPpqPosition() const { return ppqPosition; }
+
+    // Position of the block's first sample in quarter notes since the start of its bar, 0 without one
+    double getQuartersSinceBarStart() const { return quartersSinceBarStart; }
+    double getSecondsSinceBarStart() const { return quartersSinceBarStart * 60.0 / bpm; }
+
+    // True for the first block with a position after playback started, looped or was moved
+    bool hasRelocated() const { return relocated; }
+
+    // Length of a "Tempo-Relative Delay Time" note value of a "Note Type", in quarter notes
+    static double getNoteLengthInQuarters(int noteOption, int noteType);
+
+private:
+    double sampleRate{44100.0};
+    double bpm{120.0};
+
+    bool positionValid{false};
+    bool relocated{false};
+    double ppqPosition{0.0};
+    double quartersSinceBarStart{0.0};
+    double expectedPpq{0.0};    // where the next block starts if playback carries straight on
+};